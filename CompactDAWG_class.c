@@ -0,0 +1,802 @@
+/*
+	This is part of pydawg Python module.
+
+	Definition of Python class CompactDAWG and its iterator.
+	(wrapper for functions from dawg_compact.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "CompactDAWG_class.h"
+
+
+static PyObject*
+compactobj_new(PyTypeObject* type, PyObject* args, UNUSED PyObject* kwargs) {
+	CompactDAWGclass* obj;
+	DAWGclass* dawg;
+	PyDAWGState* state;
+
+	state = pydawg_get_state(type);
+	if (state == NULL)
+		return NULL;
+
+	if (not PyArg_ParseTuple(args, "O!", state->dawg_type, &dawg))
+		return NULL;
+
+	obj = (CompactDAWGclass*)PyObject_New(CompactDAWGclass, type);
+	if (UNLIKELY(obj == NULL))
+		return NULL;
+
+	DAWG_compact_init(&obj->compact);
+	obj->mapping		= NULL;
+	obj->mapping_size	= 0;
+	obj->shared			= NULL;
+
+	switch (DAWG_compact_compile(&dawg->dawg, &obj->compact)) {
+		case DAWG_OK:
+#ifdef DAWG_PERFECT_HASHING
+			dawg->mph_version = dawg->version;
+#endif
+			return (PyObject*)obj;
+
+		case DAWG_NOT_CLOSED:
+			PyErr_SetString(PyExc_ValueError, "DAWG has to be closed");
+			break;
+
+		case DAWG_TOO_BIG:
+			PyErr_SetString(PyExc_ValueError, "DAWG is too big for compacted representation");
+			break;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			break;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_compact_compile returned unexpected value");
+			break;
+	}
+
+	Py_DECREF(obj);
+	return NULL;
+}
+
+
+static void
+compactobj_del(PyObject* self) {
+	CompactDAWGclass* obj = (CompactDAWGclass*)self;
+	PyTypeObject* type = Py_TYPE(self);
+
+	DAWG_compact_free(&obj->compact);
+#ifdef DAWG_POSIX
+	if (obj->mapping)
+		munmap(obj->mapping, obj->mapping_size);
+#endif
+	if (obj->shared)
+		DAWG_shared_detach(obj->shared);
+
+	PyObject_Del(self);
+	Py_DECREF(type);
+}
+
+
+static PyObject*
+compactobj_open(PyTypeObject* type, PyObject* path, const bool trusted) {
+#ifdef DAWG_POSIX
+	CompactDAWGclass* obj;
+	PyObject* name;
+	struct stat st;
+	void* mapping;
+	int fd;
+
+	if (not PyUnicode_FSConverter(path, &name))
+		return NULL;
+
+	fd = open(PyBytes_AS_STRING(name), O_RDONLY);
+	Py_DECREF(name);
+	if (fd < 0 or fstat(fd, &st) < 0) {
+		PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+		if (fd >= 0)
+			close(fd);
+
+		return NULL;
+	}
+
+	if ((size_t)st.st_size < COMPACT_IMAGE_HEADER_SIZE) {
+		close(fd);
+		PyErr_SetString(PyExc_ValueError, "input data truncated");
+		return NULL;
+	}
+
+	// pages are loaded on demand, thus opening trusted file is O(1)
+	mapping = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapping == MAP_FAILED) {
+		PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+		return NULL;
+	}
+
+	obj = (CompactDAWGclass*)PyObject_New(CompactDAWGclass, type);
+	if (UNLIKELY(obj == NULL)) {
+		munmap(mapping, st.st_size);
+		return NULL;
+	}
+
+	DAWG_compact_init(&obj->compact);
+	obj->mapping		= mapping;
+	obj->mapping_size	= st.st_size;
+	obj->shared			= NULL;
+
+	switch (DAWG_compact_view(&obj->compact, (const uint8_t*)mapping, st.st_size, trusted)) {
+		case DAWG_OK:
+			return (PyObject*)obj;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			break;
+
+		case DAWG_DUMP_TRUNCATED:
+			PyErr_SetString(PyExc_ValueError, "input data truncated");
+			break;
+
+		case DAWG_DUMP_INVALID_MAGICK:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: header corrupted - bad magick");
+			break;
+
+		case DAWG_DUMP_CORRUPTED_1:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: header corrupted - invalid counts");
+			break;
+
+		case DAWG_DUMP_CORRUPTED_2:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: index out of range");
+			break;
+
+		case DAWG_DUMP_INVALID_GRAPH:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: graph corrupted");
+			break;
+
+		case DAWG_DUMP_INVALID_NUMBERS:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: numbers of words corrupted");
+			break;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_compact_view returned unexpected value");
+			break;
+	}
+
+	Py_DECREF(obj);
+	return NULL;
+#else
+	(void)type;
+	(void)path;
+	(void)trusted;
+	PyErr_SetString(PyExc_NotImplementedError, "memory mapped files are not supported on this platform");
+	return NULL;
+#endif
+}
+
+
+#define compact (((CompactDAWGclass*)self)->compact)
+
+static int
+compactmeth_contains(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return -1;
+
+	const int ret = DAWG_compact_exists(&compact, word.chars, word.length);
+
+	Py_DECREF(tmp);
+	return ret;
+}
+
+
+#define compactmeth_exists_doc \
+	"Check if word is in set."
+
+static PyObject*
+compactmeth_exists(PyObject* self, PyObject* value) {
+	switch (compactmeth_contains(self, value)) {
+		case 1:
+			Py_RETURN_TRUE;
+
+		case 0:
+			Py_RETURN_FALSE;
+
+		default:
+			return NULL;
+	}
+}
+
+
+#define compactmeth_match_doc \
+	"Check if word or any of its prefix is in a set."
+
+static PyObject*
+compactmeth_match(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return NULL;
+
+	const size_t len = DAWG_compact_longest_prefix(&compact, word.chars, word.length);
+	const int ret = pymod_prefix_length(word.chars, word.length, len) > 0;
+	Py_DECREF(tmp);
+
+	if (ret)
+		Py_RETURN_TRUE;
+	else
+		Py_RETURN_FALSE;
+}
+
+
+#define compactmeth_longest_prefix_doc \
+	"Returns length of the longest prefix of word that exists in a set."
+
+static PyObject*
+compactmeth_longest_prefix(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return NULL;
+
+	const size_t len = pymod_prefix_length(word.chars, word.length, DAWG_compact_longest_prefix(&compact, word.chars, word.length));
+	Py_DECREF(tmp);
+
+	return Py_BuildValue("i", len);
+}
+
+
+static Py_ssize_t
+compactmeth_len(PyObject* self) {
+	return compact.words_count;
+}
+
+
+#define compactmeth_get_stats_doc \
+	"Returns dictionary containing some statistics about compacted graph:\n" \
+	"- nodes_count\n" \
+	"- edges_count\n" \
+	"- labels_size -- number of letters in label pool\n" \
+	"- words_count\n" \
+	"- longest_word\n" \
+	"- size -- size of structure in bytes"
+
+static PyObject*
+compactmeth_get_stats(PyObject* self, UNUSED PyObject* args) {
+	DAWGCompactStatistics stats;
+
+	DAWG_compact_get_stats(&compact, &stats);
+
+	return Py_BuildValue(
+		"{s:n,s:n,s:n,s:n,s:n,s:n}",
+#define emit(name) #name, (Py_ssize_t)stats.name
+		emit(nodes_count),
+		emit(edges_count),
+		emit(labels_size),
+		emit(words_count),
+		emit(longest_word),
+		emit(size)
+#undef emit
+	);
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+
+#define compactmeth_word2index_doc \
+	"word2index(word) => integer\n" \
+	"Returns unique integer in range 1..len() identifies a word." \
+	"If word is not present in DAWG, returns None"
+
+static PyObject*
+compactmeth_word2index(PyObject* self, PyObject* arg) {
+	String word;
+	PyObject* bytes;
+
+	bytes = get_string(arg, &word);
+	if (bytes == NULL)
+		return NULL;
+
+	const size_t result = DAWG_compact_word2index(&compact, word.chars, word.length);
+	Py_DECREF(bytes);
+
+	switch (result) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		default:
+			return Py_BuildValue("n", (Py_ssize_t)result);
+	}
+}
+
+
+#define compactmeth_index2word_doc \
+	"index2word(integer) => string\n" \
+	"Returns word identified by given integer."
+
+static PyObject*
+compactmeth_index2word(PyObject* self, PyObject* arg) {
+	Py_ssize_t index;
+
+	index = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+	if (index == -1 and PyErr_Occurred())
+		return NULL;
+
+	if (index < 1)
+		Py_RETURN_NONE;
+
+	DAWG_LETTER_TYPE* word;
+	size_t wordlen;
+
+	switch (DAWG_compact_index2word(&compact, index, &word, &wordlen)) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_EXISTS:
+			{
+			PyObject* result;
+			result = pymod_make_string(word, wordlen);
+			memfree(word);
+			return result;
+			}
+
+		default:
+			ASSERT(0);
+			return NULL;
+	}
+}
+#endif
+
+
+static PyObject*
+compact_iterator_new(PyObject* self, FindAllArgs* fa) {
+	CompactDAWGIterator* iter;
+	PyDAWGState* state;
+
+	state = pydawg_get_state(Py_TYPE(self));
+	if (state == NULL)
+		return NULL;
+
+	iter = (CompactDAWGIterator*)PyObject_New(CompactDAWGIterator, state->compact_dawg_iterator_type);
+	if (iter == NULL)
+		return NULL;
+
+	iter->dawg		= (CompactDAWGclass*)self;
+	iter->top		= 0;
+	iter->started	= false;
+	iter->pattern	= NULL;
+	iter->pattern_length = 0;
+	iter->use_wildcard	= fa->use_wildcard;
+	iter->wildcard		= fa->wildcard;
+	iter->matchtype		= fa->matchtype;
+	iter->stack		= (CompactDAWGIteratorItem*)memalloc((compact.longest_word + 1) * sizeof(CompactDAWGIteratorItem));
+	iter->buffer	= (DAWG_LETTER_TYPE*)memalloc((compact.longest_word + 1) * DAWG_LETTER_SIZE);
+
+	Py_INCREF(self);
+
+	if (iter->stack == NULL or iter->buffer == NULL)
+		goto no_mem;
+
+	if (fa->word and fa->wordlen > 0) {
+		iter->pattern = (DAWG_LETTER_TYPE*)memalloc(fa->wordlen * DAWG_LETTER_SIZE);
+		if (iter->pattern == NULL)
+			goto no_mem;
+
+		iter->pattern_length = fa->wordlen;
+		memcpy(iter->pattern, fa->word, fa->wordlen * DAWG_LETTER_SIZE);
+	}
+
+	if (compact.nodes_count > 0) {
+		iter->stack[0].edge		= compact.nodes[0].edges;
+		iter->stack[0].end		= compact.nodes[0].edges + compact.nodes[0].n;
+		iter->stack[0].depth	= 0;
+		iter->stack[0].index	= 0;
+		iter->stack[0].pending	= 0;
+		iter->top = 1;
+	}
+
+	return (PyObject*)iter;
+
+no_mem:
+	Py_DECREF(iter);
+	PyErr_NoMemory();
+	return NULL;
+}
+
+
+static PyObject*
+compactmeth_iterator(PyObject* self) {
+	FindAllArgs fa;
+
+	fa.word			= NULL;
+	fa.wordlen		= 0;
+	fa.use_wildcard	= false;
+	fa.wildcard		= 0;
+	fa.matchtype	= MATCH_AT_LEAST_PREFIX;
+	fa.buffer		= NULL;
+
+	return compact_iterator_new(self, &fa);
+}
+
+
+#define compactmeth_find_all_doc \
+	"find_all([pattern, [wildcard, [how]]])\n" \
+	"Returns iterator over words matching pattern, same as DAWG.find_all."
+
+static PyObject*
+compactmeth_find_all(PyObject* self, PyObject* args) {
+	FindAllArgs fa;
+	PyObject* iter;
+
+	if (get_find_all_args(args, &fa) < 0)
+		return NULL;
+
+	iter = compact_iterator_new(self, &fa);
+
+	find_all_args_release(&fa);
+	return iter;
+}
+
+
+#define compactmeth_words_doc \
+	"Returns list of all words."
+
+static PyObject*
+compactmeth_words(PyObject* self, UNUSED PyObject* args) {
+	return PySequence_List(self);
+}
+
+
+#define compactmeth_save_doc \
+	"save(path)\n" \
+	"Save image of structure to a file, it can be later mapped " \
+	"into memory with CompactDAWG.open (or DAWG.open)."
+
+static PyObject*
+compactmeth_save(PyObject* self, PyObject* path) {
+	PyObject* name;
+	uint8_t* image;
+	size_t size;
+	FILE* f;
+	bool ok;
+
+	if (not PyUnicode_FSConverter(path, &name))
+		return NULL;
+
+	if (DAWG_compact_save(&compact, &image, &size) != DAWG_OK) {
+		Py_DECREF(name);
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	f = fopen(PyBytes_AS_STRING(name), "wb");
+	ok = (f != NULL) and (fwrite(image, 1, size, f) == size);
+	if (f != NULL)
+		ok = (fclose(f) == 0) and ok;
+	Py_END_ALLOW_THREADS
+
+	memfree(image);
+	Py_DECREF(name);
+
+	if (not ok) {
+		PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path);
+		return NULL;
+	}
+
+	Py_RETURN_NONE;
+}
+
+
+#define compactmeth_open_doc \
+	"open(path, trusted=False) => CompactDAWG\n" \
+	"Map into memory a file written by save. Unless file is trusted, " \
+	"whole image is read once and checked (ValueError is raised if " \
+	"it is corrupted); trusted file is neither read nor parsed up front. " \
+	"Pages are loaded by OS when queries touch them and are shared " \
+	"among processes. File must not be modified while it is open."
+
+static PyObject*
+compactmeth_open(PyObject* cls, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"path", "trusted", NULL};
+	PyObject* path;
+	int trusted = 0;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", kwlist, &path, &trusted))
+		return NULL;
+
+	return compactobj_open((PyTypeObject*)cls, path, trusted);
+}
+
+
+#define compactmeth_share_doc \
+	"share(name)\n" \
+	"Publish copy of image of structure under given name; then " \
+	"any interpreter of process (see CompactDAWG.attach) queries " \
+	"the same memory. Image is kept until CompactDAWG.unshare is " \
+	"called and all attached objects are deleted."
+
+static PyObject*
+compactmeth_share(PyObject* self, PyObject* arg) {
+	const char* name;
+	uint8_t* image;
+	size_t size;
+	int ret;
+
+	name = PyUnicode_AsUTF8(arg);
+	if (name == NULL)
+		return NULL;
+
+	if (DAWG_compact_save(&compact, &image, &size) != DAWG_OK) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	ret = DAWG_shared_publish(name, image, size);
+	memfree(image);
+
+	switch (ret) {
+		case DAWG_OK:
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_EXISTS:
+			PyErr_Format(PyExc_ValueError, "name '%s' is already shared", name);
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_shared_publish returned unexpected value");
+			return NULL;
+	}
+}
+
+#undef compact
+
+
+#define compactmeth_attach_doc \
+	"attach(name) => CompactDAWG\n" \
+	"Returns structure viewing image published by share (possibly " \
+	"in another interpreter); nothing is copied. Raises KeyError " \
+	"if name is not shared."
+
+static PyObject*
+compactmeth_attach(PyObject* cls, PyObject* arg) {
+	CompactDAWGclass* obj;
+	DAWGShared* shared;
+	const char* name;
+
+	name = PyUnicode_AsUTF8(arg);
+	if (name == NULL)
+		return NULL;
+
+	shared = DAWG_shared_attach(name);
+	if (shared == NULL) {
+		PyErr_SetObject(PyExc_KeyError, arg);
+		return NULL;
+	}
+
+	obj = (CompactDAWGclass*)PyObject_New(CompactDAWGclass, (PyTypeObject*)cls);
+	if (UNLIKELY(obj == NULL)) {
+		DAWG_shared_detach(shared);
+		return NULL;
+	}
+
+	DAWG_compact_init(&obj->compact);
+	obj->mapping		= NULL;
+	obj->mapping_size	= 0;
+	obj->shared			= shared;
+
+	// image was saved by DAWG_compact_save
+	if (DAWG_compact_view(&obj->compact, shared->image, shared->size, true) != DAWG_OK) {
+		Py_DECREF(obj);
+		PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_compact_view returned unexpected value");
+		return NULL;
+	}
+
+	return (PyObject*)obj;
+}
+
+
+#define compactmeth_unshare_doc \
+	"unshare(name)\n" \
+	"Remove name published by share; memory is freed when the " \
+	"last attached object is deleted. Raises KeyError if name " \
+	"is not shared."
+
+static PyObject*
+compactmeth_unshare(UNUSED PyObject* cls, PyObject* arg) {
+	const char* name;
+
+	name = PyUnicode_AsUTF8(arg);
+	if (name == NULL)
+		return NULL;
+
+	if (not DAWG_shared_unpublish(name)) {
+		PyErr_SetObject(PyExc_KeyError, arg);
+		return NULL;
+	}
+
+	Py_RETURN_NONE;
+}
+
+
+#define iter ((CompactDAWGIterator*)self)
+#define compact (iter->dawg->compact)
+
+static void
+compactiter_del(PyObject* self) {
+	PyTypeObject* type = Py_TYPE(self);
+
+	if (iter->stack)
+		memfree(iter->stack);
+
+	if (iter->buffer)
+		memfree(iter->buffer);
+
+	if (iter->pattern)
+		memfree(iter->pattern);
+
+	Py_DECREF(iter->dawg);
+	PyObject_Del(self);
+	Py_DECREF(type);
+}
+
+
+static PyObject*
+compactiter_iter(PyObject* self) {
+	Py_INCREF(self);
+	return self;
+}
+
+
+static PyObject*
+compactiter_next(PyObject* self) {
+	size_t depth;
+
+	if (UNLIKELY(not iter->started)) {
+		iter->started = true;
+		depth = 0;
+		if (iter->top > 0 and compact.nodes[0].eow and pattern_output(iter->matchtype, 0, iter->pattern_length))
+			goto output;
+	}
+
+	// DFS, edges are visited in order of letters
+	while (iter->top > 0) {
+		CompactDAWGIteratorItem* item = &iter->stack[iter->top - 1];
+		if (item->edge == item->end) {
+			iter->top -= 1;
+			continue;
+		}
+
+		const DAWGCompactEdge* edge = &compact.edges[item->edge++];
+		const size_t start = item->depth;
+		depth = start + 1 + edge->length;
+
+		iter->buffer[start] = edge->letter;
+		if (edge->length > 0)
+			memcpy(iter->buffer + start + 1, &compact.labels[edge->label], edge->length * DAWG_LETTER_SIZE);
+
+		// match label with pattern
+		size_t	index	= item->index;
+		int		pending	= item->pending;
+		size_t	i;
+		for (i=start; i < depth; i++) {
+			if (not pattern_step(iter->pattern, iter->pattern_length, iter->use_wildcard, iter->wildcard,
+								 iter->buffer[i], &index, &pending))
+				break;
+
+			// words below are too long
+			if (iter->matchtype != MATCH_AT_LEAST_PREFIX and index > iter->pattern_length)
+				break;
+		}
+
+		if (i < depth)
+			continue;
+
+		const DAWGCompactNode* child = &compact.nodes[edge->child];
+
+		ASSERT(iter->top <= compact.longest_word);
+		item = &iter->stack[iter->top++];
+		item->edge		= child->edges;
+		item->end		= child->edges + child->n;
+		item->depth		= depth;
+		item->index		= index;
+		item->pending	= pending;
+
+		if (child->eow and pending == 0 and pattern_output(iter->matchtype, index, iter->pattern_length))
+			goto output;
+	}
+
+	return NULL; /* Stop iteration */
+
+output:
+	return pymod_make_string(iter->buffer, depth);
+}
+
+#undef compact
+#undef iter
+
+
+#define method(name, kind) {#name, compactmeth_##name, kind, compactmeth_##name##_doc}
+static
+PyMethodDef compact_dawg_methods[] = {
+	method(exists,				METH_O),
+	method(match,				METH_O),
+	method(longest_prefix,		METH_O),
+	method(words,				METH_NOARGS),
+	method(find_all,			METH_VARARGS),
+
+#ifdef DAWG_PERFECT_HASHING
+	method(word2index,			METH_O),
+	method(index2word,			METH_O),
+#endif
+
+	method(get_stats,			METH_NOARGS),
+
+	method(save,				METH_O),
+	{"open", (PyCFunction)compactmeth_open, METH_VARARGS | METH_KEYWORDS | METH_CLASS, compactmeth_open_doc},
+
+	method(share,				METH_O),
+	method(attach,				METH_O | METH_CLASS),
+	method(unshare,				METH_O | METH_CLASS),
+
+	{NULL, NULL, 0, NULL}
+};
+#undef method
+
+
+static
+PyType_Slot compact_dawg_type_slots[] = {
+	{Py_tp_dealloc,		compactobj_del},
+	{Py_tp_iter,		compactmeth_iterator},
+	{Py_tp_methods,		compact_dawg_methods},
+	{Py_tp_new,			compactobj_new},
+	{Py_sq_length,		compactmeth_len},
+	{Py_sq_contains,	compactmeth_contains},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec compact_dawg_type_spec = {
+	"pydawg.CompactDAWG",
+	sizeof(CompactDAWGclass),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	compact_dawg_type_slots
+};
+
+
+static
+PyType_Slot compact_dawg_iterator_type_slots[] = {
+	{Py_tp_dealloc,		compactiter_del},
+	{Py_tp_iter,		compactiter_iter},
+	{Py_tp_iternext,	compactiter_next},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec compact_dawg_iterator_type_spec = {
+	"pydawg.CompactDAWGIterator",
+	sizeof(CompactDAWGIterator),
+	0,
+	Py_TPFLAGS_DEFAULT | DAWG_TPFLAGS_NO_NEW,
+	compact_dawg_iterator_type_slots
+};
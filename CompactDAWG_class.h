@@ -0,0 +1,61 @@
+/*
+	This is part of pydawg Python module.
+
+	Declaration of Python class CompactDAWG -- read-only
+	compacted (path compressed) representation of closed DAWG.
+	(wrapper for functions from dawg_compact.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef compactdawgclass_h_included__
+#define compactdawgclass_h_included__
+
+#include "dawg_compact.h"
+#include "dawg_shared.h"
+#include "DAWGIterator_class.h"
+
+typedef struct CompactDAWGclass {
+	PyObject_HEAD
+
+	DAWGCompact compact;	///< compacted graph
+	void*	mapping;		///< file mapped by CompactDAWG.open, NULL if none
+	size_t	mapping_size;
+	DAWGShared*	shared;		///< image attached by CompactDAWG.attach, NULL if none
+} CompactDAWGclass;
+
+
+/* CompactDAWG.open(path) -- map image saved by CompactDAWG.save */
+static PyObject*
+compactobj_open(PyTypeObject* type, PyObject* path, const bool trusted);
+
+
+typedef struct CompactDAWGIteratorItem {
+	uint32_t	edge;		///< next edge to visit
+	uint32_t	end;		///< past the last edge of node
+	size_t		depth;		///< length of path to node
+	size_t		index;		///< number of pattern letters matched by path
+	int			pending;	///< letters left of character matched by wildcard
+} CompactDAWGIteratorItem;
+
+
+typedef struct CompactDAWGIterator {
+	PyObject_HEAD
+
+	CompactDAWGclass* dawg;			///< CompactDAWG
+	CompactDAWGIteratorItem* stack;	///< path from root, longest_word + 1 items
+	size_t	top;					///< number of items on stack
+	DAWG_LETTER_TYPE* buffer;		///< string buffer
+	bool	started;				///< empty word has been checked
+
+	DAWG_LETTER_TYPE* pattern;		///< pattern
+	size_t	pattern_length;
+	DAWG_LETTER_TYPE wildcard;
+	bool	use_wildcard;
+
+	PatternMatchType matchtype;
+} CompactDAWGIterator;
+
+#endif
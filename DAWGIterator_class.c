@@ -12,20 +12,66 @@
 #include "dawgnode.h"
 
 
-static PyTypeObject dawg_iterator_type;
-
-
 typedef struct DAWGIteratorStackItem {
 	LISTITEM_data
 
 	struct	DAWGNode*	node;
-	size_t	depth;
+	size_t	depth;		///< length of path
+	size_t	index;		///< number of pattern letters matched by path
+	int		pending;	///< letters left of character matched by wildcard
 	DAWG_LETTER_TYPE letter;
 } DAWGIteratorStackItem;
 
 #define StackItem DAWGIteratorStackItem
 
 
+/*	Bounds of words below node for each suffix of pattern, used with
+	summaries of subgraphs. Returns false if there is no memory.
+*/
+static bool
+DAWGIterator_set_bounds(DAWGIterator* iter) {
+	const DAWG* dawg = &iter->dawg->dawg;
+	// wildcard matches a whole UTF-8 sequence
+	const size_t wildcard_letters = 1 + DAWG_LETTER_CONTINUATION(0xff);
+	const size_t n = iter->pattern_length;
+	size_t i;
+
+	iter->bounds = (DAWGIteratorBounds*)memalloc((n + 1) * sizeof(DAWGIteratorBounds));
+	if (iter->bounds == NULL)
+		return false;
+
+	iter->bounds[n].min_length	= 0;
+	iter->bounds[n].max_length	= (iter->matchtype == MATCH_AT_LEAST_PREFIX) ? dawg->longest_word : 0;
+	iter->bounds[n].letters		= 0;
+
+	for (i=n; i > 0; i--) {
+		const DAWGIteratorBounds* next = &iter->bounds[i];
+		DAWGIteratorBounds* bounds = &iter->bounds[i - 1];
+		const DAWG_LETTER_TYPE letter = iter->pattern[i - 1];
+
+		bounds->min_length = next->min_length + 1;
+		if (iter->use_wildcard and letter == iter->wildcard) {
+			bounds->max_length	= next->max_length + wildcard_letters;
+			bounds->letters		= next->letters;
+		}
+		else {
+			bounds->max_length	= next->max_length + 1;
+			bounds->letters		= next->letters | DAWG_summary_bit(DAWG_alphabet_code(&dawg->alphabet, letter));
+		}
+	}
+
+	if (iter->matchtype == MATCH_AT_MOST_PREFIX) {
+		// words can end anywhere
+		for (i=0; i <= n; i++) {
+			iter->bounds[i].min_length	= 0;
+			iter->bounds[i].letters		= 0;
+		}
+	}
+
+	return true;
+}
+
+
 static PyObject*
 DAWGIterator_new(
 	DAWGclass* dawg,
@@ -40,19 +86,27 @@ DAWGIterator_new(
 	ASSERT(dawg);
 
 	DAWGIterator* iter;
+	PyDAWGState* state;
+
+	state = pydawg_get_state(Py_TYPE(dawg));
+	if (state == NULL)
+		return NULL;
 
-	iter = (DAWGIterator*)PyObject_New(DAWGIterator, &dawg_iterator_type);
+	iter = (DAWGIterator*)PyObject_New(DAWGIterator, state->dawg_iterator_type);
 	if (iter == NULL)
 		return NULL;
 
 	iter->dawg		= dawg;
 	iter->version	= dawg->version;
+	iter->buffer	= NULL;
 	iter->pattern	= NULL;
 	iter->pattern_length = 0;
 	iter->use_wildcard = use_wildcard;
 	iter->wildcard	= wildcard;
 	iter->matchtype = matchtype;
+	iter->bounds	= NULL;
 	list_init(&iter->stack);
+	Py_INCREF((PyObject*)iter->dawg);
 
 	ASSERT(
 		matchtype == MATCH_EXACT_LENGTH or
@@ -61,39 +115,46 @@ DAWGIterator_new(
 	);
 
 	StackItem* new_item = (StackItem*)list_item_new(sizeof(StackItem));
-	if (not new_item) {
-		PyObject_Del((PyObject*)iter);
-		PyErr_NoMemory();
-		return NULL;
-	}
+	if (not new_item)
+		goto no_mem;
 
 	iter->buffer = (DAWG_LETTER_TYPE*)memalloc((dawg->dawg.longest_word + 1) * DAWG_LETTER_SIZE);
 	if (iter->buffer == NULL) {
-		PyObject_Del((PyObject*)iter);
-		return NULL;
+		list_item_delete((ListItem*)new_item);
+		goto no_mem;
 	}
 	else {
 		new_item->node   = dawg->dawg.q0;
 		new_item->letter = 0;
 		new_item->depth	 = 0;
+		new_item->index	 = 0;
+		new_item->pending = 0;
 		list_push_front(&iter->stack, (ListItem*)new_item);
 	}
 
 	if (word and wordlen > 0) {
 		iter->pattern = (DAWG_LETTER_TYPE*)memalloc(wordlen * DAWG_LETTER_SIZE);
-		if (UNLIKELY(iter->pattern == NULL)) {
-			PyObject_Del((PyObject*)iter);
-			PyErr_NoMemory();
-			return NULL;
-		}
+		if (UNLIKELY(iter->pattern == NULL))
+			goto no_mem;
 		else {
 			iter->pattern_length = wordlen;
 			memcpy(iter->pattern, word, wordlen * DAWG_LETTER_SIZE);
 		}
+
+		// summaries are optional, lack of memory is not an error
+		if (dawg->dawg.summary == NULL and dawg->dawg.state == CLOSED)
+			DAWG_summary_build(&dawg->dawg);
+
+		if (dawg->dawg.summary and not DAWGIterator_set_bounds(iter))
+			goto no_mem;
 	}
 
-	Py_INCREF((PyObject*)iter->dawg);
 	return (PyObject*)iter;
+
+no_mem:
+	Py_DECREF(iter);
+	PyErr_NoMemory();
+	return NULL;
 }
 
 
@@ -101,13 +162,22 @@ DAWGIterator_new(
 
 static void
 DAWGIterator_del(PyObject* self) {
+	PyTypeObject* type = Py_TYPE(self);
+
 	if (iter->buffer)
 		memfree(iter->buffer);
+
+	if (iter->pattern)
+		memfree(iter->pattern);
+
+	if (iter->bounds)
+		memfree(iter->bounds);
 	
 	list_delete(&iter->stack);
 	Py_DECREF(iter->dawg);
 
 	PyObject_Del(self);
+	Py_DECREF(type);
 }
 
 
@@ -118,6 +188,96 @@ DAWGIterator_iter(PyObject* self) {
 }
 
 
+static bool
+pattern_output(const PatternMatchType matchtype, const size_t index, const size_t pattern_length) {
+	switch (matchtype) {
+		case MATCH_EXACT_LENGTH:
+			return index == pattern_length;
+
+		case MATCH_AT_MOST_PREFIX:
+			return index <= pattern_length;
+
+		case MATCH_AT_LEAST_PREFIX:
+		default:
+			return index >= pattern_length;
+	}
+}
+
+
+static bool
+pattern_step(
+	const DAWG_LETTER_TYPE* pattern,
+	const size_t pattern_length,
+	const bool use_wildcard,
+	const DAWG_LETTER_TYPE wildcard,
+	const DAWG_LETTER_TYPE letter,
+	size_t* index,
+	int* pending
+) {
+	if (*pending > 0) {
+		*pending -= 1;
+		return true;
+	}
+
+	if (*index >= pattern_length) {
+		*index += 1;
+		return true;
+	}
+
+	if (use_wildcard and pattern[*index] == wildcard) {
+		*index += 1;
+		*pending = DAWG_LETTER_CONTINUATION(letter);
+		return true;
+	}
+
+	if (pattern[*index] == letter) {
+		*index += 1;
+		return true;
+	}
+
+	return false;
+}
+
+
+/* false if there is no word matching pattern below node */
+static bool
+DAWGIterator_viable(PyObject* self, const DAWGNode* node, size_t index, const int pending) {
+	if (iter->bounds == NULL)
+		return true;
+
+	const DAWGSummary* summary = DAWG_summary_get(&iter->dawg->dawg, node);
+	if (index > iter->pattern_length)
+		index = iter->pattern_length;
+
+	const DAWGIteratorBounds* bounds = &iter->bounds[index];
+	if (summary->max_length < DAWG_SUMMARY_MAX_LENGTH and summary->max_length < bounds->min_length + pending)
+		return false;
+
+	if (summary->min_length > bounds->max_length + pending)
+		return false;
+
+	return (summary->letters & bounds->letters) == bounds->letters;
+}
+
+
+static bool
+DAWGIterator_push(PyObject* self, DAWGNode* node, const DAWG_LETTER_TYPE letter, const size_t depth, const size_t index, const int pending) {
+	StackItem* new_item = (StackItem*)list_item_new(sizeof(StackItem));
+	if (UNLIKELY(new_item == NULL)) {
+		PyErr_NoMemory();
+		return false;
+	}
+
+	new_item->node		= node;
+	new_item->letter	= letter;
+	new_item->depth		= depth;
+	new_item->index		= index;
+	new_item->pending	= pending;
+	list_push_front(&iter->stack, (ListItem*)new_item);
+	return true;
+}
+
+
 static PyObject*
 DAWGIterator_next(PyObject* self) {
 	if (UNLIKELY(iter->version != iter->dawg->version)) {
@@ -126,50 +286,49 @@ DAWGIterator_next(PyObject* self) {
 	}
 
 	while (true) {
-		StackItem* item = (StackItem*)list_pop_first(&iter->stack);
-		if (item == NULL or item->node == NULL)
+		StackItem* top = (StackItem*)list_pop_first(&iter->stack);
+		if (top == NULL)
 			return NULL; /* Stop iteration */
 
-		const size_t index = item->depth;
+		const StackItem current = *top;
+		list_item_delete((ListItem*)top);
+
+		const StackItem* item = &current;
+		if (item->node == NULL)
+			return NULL; /* Stop iteration */
+
+		const size_t index = item->index;
 		if (iter->matchtype != MATCH_AT_LEAST_PREFIX and index > iter->pattern_length) {
 			continue;
 		}
 
-		bool output;
-		switch (iter->matchtype) {
-			case MATCH_EXACT_LENGTH:
-				output = (index == iter->pattern_length);
-				break;
-
-			case MATCH_AT_MOST_PREFIX:
-				output = (index <= iter->pattern_length);
-				break;
-				
-			case MATCH_AT_LEAST_PREFIX:
-			default:
-				output = (index >= iter->pattern_length);
-				break;
-
-		}
+		const bool output = (item->pending == 0) and pattern_output(iter->matchtype, index, iter->pattern_length);
 
 		iter->state = item->node;
+		DAWG_profile_visit(&iter->dawg->dawg, iter->state);
 
-		if ((index >= iter->pattern_length) or
+		if (iter->matchtype != MATCH_AT_LEAST_PREFIX and index >= iter->pattern_length and item->pending == 0) {
+			// whole pattern is matched, longer words are not needed
+		}
+		else if ((item->pending > 0) or
+		    (index >= iter->pattern_length) or
 		    (iter->use_wildcard and iter->pattern[index] == iter->wildcard)) {
 
 			const int n = iter->state->n;
 			int i;
 			for (i=0; i < n; i++) {
-				StackItem* new_item = (StackItem*)list_item_new(sizeof(StackItem));
-				if (not new_item) {
-					PyErr_NoMemory();
-					return NULL;
-				}
+				const DAWG_LETTER_TYPE letter = iter->state->next[i].letter;
+				size_t	new_index	= index;
+				int		pending		= item->pending;
+
+				pattern_step(iter->pattern, iter->pattern_length, iter->use_wildcard, iter->wildcard,
+							 letter, &new_index, &pending);
 
-				new_item->node  = iter->state->next[i].child;
-				new_item->letter= iter->state->next[i].letter;
-				new_item->depth = index + 1;
-				list_push_front(&iter->stack, (ListItem*)new_item);
+				if (not DAWGIterator_viable(self, iter->state->next[i].child, new_index, pending))
+					continue;
+
+				if (not DAWGIterator_push(self, iter->state->next[i].child, letter, item->depth + 1, new_index, pending))
+					return NULL;
 			}
 		}
 		else {
@@ -177,73 +336,38 @@ DAWGIterator_next(PyObject* self) {
 			const DAWG_LETTER_TYPE ch = iter->pattern[index];
 			DAWGNode* node = dawgnode_get_child(iter->state, ch);
 
-			if (node) {
-				StackItem* new_item = (StackItem*)list_item_new(sizeof(StackItem));
-				if (UNLIKELY(new_item == NULL)) {
-					PyErr_NoMemory();
+			if (node and DAWGIterator_viable(self, node, index + 1, 0)) {
+				if (not DAWGIterator_push(self, node, ch, item->depth + 1, index + 1, 0))
 					return NULL;
-				}
-
-				new_item->node  = node;
-				new_item->letter= ch;
-				new_item->depth = index + 1;
-				list_push_front(&iter->stack, (ListItem*)new_item);
 			}
 		}
 
 		iter->buffer[item->depth] = item->letter;
 
 		if (output and iter->state->eow)
-#ifdef DAWG_UNICODE
-			return PyUnicode_FromUnicode(iter->buffer + 1, item->depth);
-#else
-			return PyBytes_FromStringAndSize((char*)(iter->buffer + 1), item->depth);
-#endif
+			return pymod_make_string(iter->buffer + 1, item->depth);
 	}
 }
 
 #undef StackItem
 #undef iter
 
-static PyTypeObject dawg_iterator_type = {
-	PY_OBJECT_HEAD_INIT
-	"DAWGIterator",								/* tp_name */
-	sizeof(DAWGIterator),						/* tp_size */
-	0,											/* tp_itemsize? */
-	(destructor)DAWGIterator_del,				/* tp_dealloc */
-	0,                                      	/* tp_print */
-	0,                                         	/* tp_getattr */
-	0,                                          /* tp_setattr */
-	0,                                          /* tp_reserved */
-	0,											/* tp_repr */
-	0,                                          /* tp_as_number */
-	0,                                          /* tp_as_sequence */
-	0,                                          /* tp_as_mapping */
-	0,                                          /* tp_hash */
-	0,                                          /* tp_call */
-	0,                                          /* tp_str */
-	PyObject_GenericGetAttr,                    /* tp_getattro */
-	0,                                          /* tp_setattro */
-	0,                                          /* tp_as_buffer */
-	Py_TPFLAGS_DEFAULT,                         /* tp_flags */
-	0,                                          /* tp_doc */
-	0,                                          /* tp_traverse */
-	0,                                          /* tp_clear */
-	0,                                          /* tp_richcompare */
-	0,                                          /* tp_weaklistoffset */
-	DAWGIterator_iter,							/* tp_iter */
-	DAWGIterator_next,							/* tp_iternext */
-	0,											/* tp_methods */
-	0,						                	/* tp_members */
-	0,                                          /* tp_getset */
-	0,                                          /* tp_base */
-	0,                                          /* tp_dict */
-	0,                                          /* tp_descr_get */
-	0,                                          /* tp_descr_set */
-	0,                                          /* tp_dictoffset */
-	0,                                          /* tp_init */
-	0,                                          /* tp_alloc */
-	0,                                          /* tp_new */
+static
+PyType_Slot dawg_iterator_type_slots[] = {
+	{Py_tp_dealloc,		DAWGIterator_del},
+	{Py_tp_iter,		DAWGIterator_iter},
+	{Py_tp_iternext,	DAWGIterator_next},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec dawg_iterator_type_spec = {
+	"pydawg.DAWGIterator",
+	sizeof(DAWGIterator),
+	0,
+	Py_TPFLAGS_DEFAULT | DAWG_TPFLAGS_NO_NEW,
+	dawg_iterator_type_slots
 };
 
 #undef StackItem
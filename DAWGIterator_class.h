@@ -23,6 +23,14 @@ typedef enum {
 	MATCH_AT_MOST_PREFIX
 } PatternMatchType;
 
+/* constraints on words below node, when i letters of pattern are matched */
+typedef struct DAWGIteratorBounds {
+	size_t		min_length;		///< remaining letters (without pending continuation)
+	size_t		max_length;
+	uint32_t	letters;		///< letters of pattern that have to appear (see DAWGSummary)
+} DAWGIteratorBounds;
+
+
 typedef struct DAWGIterator {
 	PyObject_HEAD
 
@@ -38,6 +46,7 @@ typedef struct DAWGIterator {
 	bool use_wildcard;
 
 	PatternMatchType matchtype;
+	DAWGIteratorBounds* bounds;	///< pattern_length + 1 items, NULL if subgraphs summaries are not available
 } DAWGIterator;
 
 
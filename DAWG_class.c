@@ -13,32 +13,35 @@
 #include "DAWGIterator_class.h"
 
 
-static
-PyTypeObject dawg_type;
-
 static PyObject*
-dawgmeth_binload(PyObject* self, PyObject* arg);
+dawgobj_binload(PyObject* self, PyObject* arg, const DAWGLayout layout, const bool trusted);
 
 
 PyObject*
-dawgobj_new(UNUSED PyTypeObject* type, UNUSED PyObject* args, UNUSED PyObject* kwargs) {
+dawgobj_new(PyTypeObject* type, UNUSED PyObject* args, UNUSED PyObject* kwargs) {
 	DAWGclass	*dawg;
 
-	dawg = (DAWGclass*)PyObject_New(DAWGclass, &dawg_type);
+	// type is DAWG, SequenceDAWG or their Python subclass
+	dawg = (DAWGclass*)type->tp_alloc(type, 0);
     if (UNLIKELY(dawg == NULL)) {
         return NULL;
     }
 
 	DAWG_init(&dawg->dawg);
+	DAWG_da_init(&dawg->da);
 	dawg->version		= 0;
 	dawg->stats_version	= -1;	// stats are not valid
+	dawg->readers		= 0;
+	dawg->image			= NULL;
+	dawg->image_version	= -1;	// image is not valid
+	dawg->exports		= 0;
 #ifdef DAWG_PERFECT_HASHING
 	dawg->mph_version	= -1;	// numbers are not valid
 #endif
 
 	if (PyTuple_Check(args) and PyTuple_Size(args) > 0) {
 		if (PyTuple_Size(args) == 1) {
-			PyObject* ret = dawgmeth_binload((PyObject*)dawg, PyTuple_GET_ITEM(args, 0));
+			PyObject* ret = dawgobj_binload((PyObject*)dawg, PyTuple_GET_ITEM(args, 0), LAYOUT_BFS, false);
 			if (ret == NULL) {
 				Py_DECREF(dawg);
 				return NULL;
@@ -58,12 +61,31 @@ dawgobj_new(UNUSED PyTypeObject* type, UNUSED PyObject* args, UNUSED PyObject* k
 static void
 dawgobj_del(PyObject* self) {
 #define dawg (((DAWGclass*)self)->dawg)
+	PyTypeObject* type = Py_TYPE(self);
+
 	DAWG_free(&dawg);
-	PyObject_Del(self);
+	DAWG_da_free(&((DAWGclass*)self)->da);
+	Py_XDECREF(((DAWGclass*)self)->image);
+	type->tp_free(self);
+	Py_DECREF(type);
 #undef dawg
 }
 
 
+/*	Lookups of many keys release GIL, graph can't be changed
+	meanwhile. Returns -1 and sets exception if it's read.
+*/
+static int
+check_readers(DAWGclass* obj) {
+	if (obj->readers > 0) {
+		PyErr_SetString(PyExc_RuntimeError, "DAWG is being read by another thread, can't modify it");
+		return -1;
+	}
+	else
+		return 0;
+}
+
+
 static PyObject*
 get_string(PyObject* value, String* string) {
 	PyObject* obj;
@@ -90,6 +112,9 @@ dawgmeth_add_word(PyObject* self, PyObject* value) {
 	String	word;
 	PyObject* tmp;
 
+	if (check_readers(obj) < 0)
+		return NULL;
+
 	tmp = get_string(value, &word);
 	if (tmp == NULL)
 		return NULL;
@@ -142,6 +167,9 @@ dawgmeth_add_word_unchecked(PyObject* self, PyObject* value) {
 	String	word;
 	PyObject*	tmp;
 
+	if (check_readers(obj) < 0)
+		return NULL;
+
 	tmp = get_string(value, &word);
 	if (tmp == NULL)
 		return NULL;
@@ -176,20 +204,108 @@ dawgmeth_add_word_unchecked(PyObject* self, PyObject* value) {
 }
 
 
+#define dawgmeth_add_ints_doc \
+	"add_ints(buffer, [width=8]) => int\n" \
+	"Add integer keys saved as words of ``width`` bytes in big-endian " \
+	"order. Buffer contains unsigned integers or raw keys (bytes). " \
+	"Keys have to be sorted. Returns number of new words."
+
+static PyObject*
+dawgmeth_add_ints(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	static char* kwlist[] = {"buffer", "width", NULL};
+
+	PyObject* arg;
+	Py_ssize_t width = 8;
+	Py_buffer view;
+	DAWGIntArray keys;
+	size_t processed;
+	size_t added;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|n", kwlist, &arg, &width))
+		return NULL;
+
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	if (pymod_get_int_array(arg, width, &view, &keys) < 0)
+		return NULL;
+
+	// GIL is kept: other threads must not see half-updated graph
+	const int ret = DAWG_add_ints(&dawg, &keys, &processed, &added);
+	PyBuffer_Release(&view);
+
+	if (added > 0)
+		obj->version += 1;
+
+	switch (ret) {
+		case DAWG_OK:
+			return Py_BuildValue("n", (Py_ssize_t)added);
+
+		case DAWG_FROZEN:
+			PyErr_SetString(
+				PyExc_AttributeError,
+				"DAWG has been freezed, no further chanages are allowed"
+			);
+			return NULL;
+
+		case DAWG_WORD_LESS:
+			PyErr_Format(
+				PyExc_ValueError,
+				"key #%zd is less then previosuly added, can't update DAWG",
+				(Py_ssize_t)processed
+			);
+			return NULL;
+
+		case DAWG_TOO_BIG:
+			PyErr_Format(
+				PyExc_ValueError,
+				"key #%zd doesn't fit in %zd bytes",
+				(Py_ssize_t)processed, width
+			);
+			return NULL;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_add_ints returned unexpected value");
+			return NULL;
+	}
+#undef dawg
+#undef obj
+}
+
+
+/* double-array is used if it has been compiled */
+#define has_da(obj) ((obj)->da.slots != NULL)
+
+
 static int
 dawgmeth_contains(PyObject* self, PyObject* value) {
-#define dawg (((DAWGclass*)self)->dawg)
-	String	word;
-	PyObject*	obj;
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	LookupString word;
+	PyObject*	tmp;
 
-	obj = get_string(value, &word);
-	if (obj == NULL)
+	tmp = pymod_get_lookup_string(value, &word);
+	if (tmp == NULL)
 		return -1;
 
-	const int ret = DAWG_exists(&dawg, word.chars, word.length);
-	Py_DECREF(obj);
+	int ret;
+	if (dawg.profile)
+		ret = DAWG_LOOKUP(DAWG_profile_exists, &dawg, word);
+	else if (has_da(obj))
+		ret = DAWG_LOOKUP(DAWG_da_exists, &obj->da, word);
+	else
+		ret = DAWG_LOOKUP(DAWG_exists, &dawg, word);
+
+	Py_DECREF(tmp);
 	return ret;
 #undef dawg
+#undef obj
 }
 
 
@@ -216,22 +332,32 @@ dawgmeth_exists(PyObject* self, PyObject* value) {
 
 static PyObject*
 dawgmeth_match(PyObject* self, PyObject* value) {
-#define dawg (((DAWGclass*)self)->dawg)
-	String	word;
-	PyObject*	obj;
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	LookupString word;
+	PyObject*	tmp;
 
-	obj = get_string(value, &word);
-	if (obj == NULL)
+	tmp = pymod_get_lookup_string(value, &word);
+	if (tmp == NULL)
 		return NULL;
 
-	const int ret = DAWG_match(&dawg, word.chars, word.length);
-	Py_DECREF(obj);
+	size_t len;
+	if (dawg.profile)
+		len = DAWG_LOOKUP(DAWG_profile_longest_prefix, &dawg, word);
+	else if (has_da(obj))
+		len = DAWG_LOOKUP(DAWG_da_longest_prefix, &obj->da, word);
+	else
+		len = DAWG_LOOKUP(DAWG_longest_prefix, &dawg, word);
+
+	const int ret = pymod_prefix_length((const DAWG_LETTER_TYPE*)word.chars, word.length, len) > 0;
+	Py_DECREF(tmp);
 
 	if (ret)
 		Py_RETURN_TRUE;
 	else
 		Py_RETURN_FALSE;
 #undef dawg
+#undef obj
 }
 
 
@@ -248,21 +374,42 @@ dawgmeth_iterator(PyObject* self) {
 }
 
 
-#define dawgmeth_find_all_doc \
-	""
+/* arguments of find_all */
+typedef struct FindAllArgs {
+	PyObject*	pattern_obj;	///< pattern object (or NULL)
+	PyObject*	wildcard_obj;	///< wildcard object (or NULL)
+	DAWG_LETTER_TYPE* word;		///< pattern
+	size_t		wordlen;
+	DAWG_LETTER_TYPE wildcard;
+	bool		use_wildcard;
+	PatternMatchType matchtype;
+	DAWG_LETTER_TYPE* buffer;	///< pattern with substituted wildcards (or NULL)
+} FindAllArgs;
 
-static PyObject*
-dawgmeth_find_all(PyObject* self, PyObject* args) {
-#define dawg (((DAWGclass*)self)->dawg)
+
+static void
+find_all_args_release(FindAllArgs* fa) {
+	Py_XDECREF(fa->pattern_obj);
+	Py_XDECREF(fa->wildcard_obj);
+
+	if (fa->buffer)
+		memfree(fa->buffer);
+}
+
+
+/* parse arguments ([pattern, [wildcard, [matchtype]]]), returns -1 on error */
+static int
+get_find_all_args(PyObject* args, FindAllArgs* fa) {
 	PyObject* arg1 = NULL;
 	PyObject* arg2 = NULL;
 	PyObject* arg3 = NULL;
-	DAWG_LETTER_TYPE* word;
-	size_t wordlen;
+	DAWG_LETTER_TYPE* wildcard = NULL;
+	size_t wildcard_length = 0;
 
-	DAWG_LETTER_TYPE wildcard;
-	bool use_wildcard = false;
-	PatternMatchType matchtype = MATCH_AT_LEAST_PREFIX;
+	fa->pattern_obj	 = NULL;
+	fa->wildcard_obj = NULL;
+	fa->buffer		 = NULL;
+	fa->matchtype	 = MATCH_AT_LEAST_PREFIX;
 
 	// arg 1: prefix/prefix pattern
 	if (args) 
@@ -271,14 +418,14 @@ dawgmeth_find_all(PyObject* self, PyObject* args) {
 		arg1 = NULL;
 	
 	if (arg1) {
-		arg1 = pymod_get_string(arg1, &word, &wordlen);
-		if (arg1 == NULL)
+		fa->pattern_obj = pymod_get_string(arg1, &fa->word, &fa->wordlen);
+		if (fa->pattern_obj == NULL)
 			goto error;
 	}
 	else {
 		PyErr_Clear();
-		word = NULL;
-		wordlen = 0;
+		fa->word = NULL;
+		fa->wordlen = 0;
 	}
 
 	// arg 2: wildcard
@@ -288,16 +435,13 @@ dawgmeth_find_all(PyObject* self, PyObject* args) {
 		arg2 = NULL;
 
 	if (arg2) {
-		DAWG_LETTER_TYPE* tmp;
-		size_t len;
-
-		arg2 = pymod_get_string(arg2, &tmp, &len);
-		if (arg2 == NULL)
+		fa->wildcard_obj = pymod_get_string(arg2, &wildcard, &wildcard_length);
+		if (fa->wildcard_obj == NULL)
 			goto error;
 		else {
-			if (len == 1) {
-				wildcard = tmp[0];
-				use_wildcard = true;
+			if (pymod_string_length(arg2, wildcard_length) == 1) {
+				fa->wildcard = wildcard[0];
+				fa->use_wildcard = true;
 			}
 			else {
 				PyErr_SetString(PyExc_ValueError, "wildcard have to be single character");
@@ -307,12 +451,12 @@ dawgmeth_find_all(PyObject* self, PyObject* args) {
 	}
 	else {
 		PyErr_Clear();
-		wildcard = 0;
-		use_wildcard = false;
+		fa->wildcard = 0;
+		fa->use_wildcard = false;
 	}
 
 	// arg3: matchtype
-	matchtype = MATCH_AT_LEAST_PREFIX;
+	fa->matchtype = MATCH_AT_LEAST_PREFIX;
 	if (args) {
 		arg3 = PyTuple_GetItem(args, 2);
 		if (arg3) {
@@ -324,7 +468,7 @@ dawgmeth_find_all(PyObject* self, PyObject* args) {
 				case MATCH_AT_LEAST_PREFIX:
 				case MATCH_AT_MOST_PREFIX:
 				case MATCH_EXACT_LENGTH:
-					matchtype = (PatternMatchType)val;
+					fa->matchtype = (PatternMatchType)val;
 					break;
 
 				default:
@@ -337,183 +481,682 @@ dawgmeth_find_all(PyObject* self, PyObject* args) {
 		}
 		else {
 			PyErr_Clear();
-			if (use_wildcard)
-				matchtype = MATCH_EXACT_LENGTH;
+			if (fa->use_wildcard)
+				fa->matchtype = MATCH_EXACT_LENGTH;
 			else
-				matchtype = MATCH_AT_LEAST_PREFIX;
+				fa->matchtype = MATCH_AT_LEAST_PREFIX;
 		}
 	}
 
+#ifdef DAWG_UTF8
+	// wildcard is a whole UTF-8 sequence; in the pattern it's
+	// replaced by a single byte, that can't appear in UTF-8
+	if (fa->use_wildcard) {
+		size_t i, j;
 
-	// 
-	DAWGIterator* iter;
-	iter = (DAWGIterator*)DAWGIterator_new(
-				(DAWGclass*)self,
-				word,
-				wordlen,
-				use_wildcard,
-				wildcard,
-				matchtype
-			);
+		if (fa->wordlen > 0) {
+			fa->buffer = (DAWG_LETTER_TYPE*)memalloc(fa->wordlen);
+			if (fa->buffer == NULL) {
+				PyErr_NoMemory();
+				goto error;
+			}
 
-	Py_XDECREF(arg1);
-	Py_XDECREF(arg2);
+			for (i=0, j=0; i < fa->wordlen; j++) {
+				if (i + wildcard_length <= fa->wordlen and memcmp(fa->word + i, wildcard, wildcard_length) == 0) {
+					fa->buffer[j] = DAWG_UTF8_WILDCARD;
+					i += wildcard_length;
+				}
+				else
+					fa->buffer[j] = fa->word[i++];
+			}
 
-	if (iter)
-		return (PyObject*)iter;
-	else
-		return NULL;
+			fa->word	= fa->buffer;
+			fa->wordlen	= j;
+		}
+
+		fa->wildcard = DAWG_UTF8_WILDCARD;
+	}
+#endif
+
+	return 0;
 
 error:
-	Py_XDECREF(arg1);
-	Py_XDECREF(arg2);
-	return NULL;
-#undef dawg
+	find_all_args_release(fa);
+	return -1;
 }
 
 
-#define dawgmeth_longest_prefix_doc \
-	"Returns length of the longest prefix of word that exists in a set."
+#define dawgmeth_find_all_doc \
+	""
 
 static PyObject*
-dawgmeth_longest_prefix(PyObject* self, PyObject* value) {
-#define dawg (((DAWGclass*)self)->dawg)
-	String	word;
-	PyObject*	obj;
+dawgmeth_find_all(PyObject* self, PyObject* args) {
+	FindAllArgs fa;
+	PyObject* iter;
 
-	obj = get_string(value, &word);
-	if (obj == NULL)
+	if (get_find_all_args(args, &fa) < 0)
 		return NULL;
 
-	const size_t len = DAWG_longest_prefix(&dawg, word.chars, word.length);
-	Py_DECREF(obj);
-
-	return Py_BuildValue("i", len);
-#undef dawg
-}
-
+	iter = DAWGIterator_new(
+				(DAWGclass*)self,
+				fa.word,
+				fa.wordlen,
+				fa.use_wildcard,
+				fa.wildcard,
+				fa.matchtype
+			);
 
-static Py_ssize_t
-dawgmeth_len(PyObject* self) {
-#define dawg (((DAWGclass*)self)->dawg)
-	return dawg.count;
-#undef dawg
+	find_all_args_release(&fa);
+	return iter;
 }
 
 
-#define dawgmeth_clear_doc \
-	"Erase all words from set."
+#define dawgmeth_contains_ints_doc \
+	"contains_ints(buffer, [width=8]) => bytearray\n" \
+	"Check integer keys (see ``add_ints``), i-th byte of result " \
+	"is 1 if i-th key is in set. Lookups are done without GIL."
 
 static PyObject*
-dawgmeth_clear(PyObject* self, UNUSED PyObject* args) {
+dawgmeth_contains_ints(PyObject* self, PyObject* args, PyObject* kwargs) {
 #define obj ((DAWGclass*)self)
 #define dawg (obj->dawg)
-	int result = DAWG_clear(&dawg);
-	if(result==DAWG_NO_MEM) {
-		PyErr_NoMemory();
+	static char* kwlist[] = {"buffer", "width", NULL};
+
+	PyObject* arg;
+	Py_ssize_t width = 8;
+	Py_buffer view;
+	DAWGIntArray keys;
+	PyObject* result;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|n", kwlist, &arg, &width))
 		return NULL;
-	}
-	obj->version += 1;
-	Py_RETURN_NONE;
-#undef dawg
-#undef obj
-}
 
+	if (pymod_get_int_array(arg, width, &view, &keys) < 0)
+		return NULL;
 
-#define dawgmeth_close_doc \
-	"Don't allow to add any new words. Also free some memory (a hash table) " \
-	"used to perform incremental algorithm." \
-	"Can be reverted only by ``clear()``." \
+	result = PyByteArray_FromStringAndSize(NULL, keys.count);
+	if (result == NULL) {
+		PyBuffer_Release(&view);
+		return NULL;
+	}
 
+	uint8_t* bytes = (uint8_t*)PyByteArray_AS_STRING(result);
 
-static PyObject*
-dawgmeth_close(PyObject* self, UNUSED PyObject* args) {
-#define obj ((DAWGclass*)self)
-#define dawg (obj->dawg)
-	DAWG_close(&dawg);
-	obj->version += 1;
-	Py_RETURN_NONE;
+	obj->readers += 1;
+	Py_BEGIN_ALLOW_THREADS
+	if (has_da(obj))
+		DAWG_da_exists_ints(&obj->da, &keys, bytes);
+	else
+		DAWG_exists_ints(&dawg, &keys, bytes);
+	Py_END_ALLOW_THREADS
+	obj->readers -= 1;
+
+	PyBuffer_Release(&view);
+	return result;
 #undef dawg
 #undef obj
 }
 
 
-#define dawgmeth_get_stats_doc \
-	"Returns dictionary containing some statistics about underlaying data structure:\n" \
-	"* ``nodes_count``	--- number of nodes\n" \
-	"* ``edges_count``	--- number of edges\n" \
-	"* ``words_count``	--- number of distinct words (same as ``len(dawg)``)\n" \
-	"* ``node_size``	--- size of single node (in bytes)\n" \
-	"* ``graph_size``	--- size of whole graph (in bytes); it's about\n" \
-	"  ``nodes_count * node_size + edges_count * pointer size``\n" \
-	"* ``longest_word``	--- length of the longest word\n" \
-	"* ``hash_tbl_size``	--- size of a helper hash table\n" \
-	"* ``hash_tbl_count`` --- number of items in a helper hash table"
+/* clamp integer to range 0..max, returns 1 if it's negative, -1 on error */
+static int
+get_int_bound(PyObject* arg, const uint64_t max, uint64_t* value) {
+	int overflow;
+	const long long tmp = PyLong_AsLongLongAndOverflow(arg, &overflow);
+	if (tmp == -1 and PyErr_Occurred())
+		return -1;
 
-static void update_stats(DAWGclass *obj) {
-	if (obj->stats_version != obj->version) {
-		DAWG_get_stats(&obj->dawg, &obj->stats);
-		obj->stats_version = obj->version;
+	if (overflow < 0 or (overflow == 0 and tmp < 0)) {
+		*value = 0;
+		return 1;
+	}
+	else if (overflow == 0)
+		*value = tmp;
+	else {
+		*value = PyLong_AsUnsignedLongLong(arg);
+		if (*value == (uint64_t)-1 and PyErr_Occurred()) {
+			if (not PyErr_ExceptionMatches(PyExc_OverflowError))
+				return -1;
+
+			PyErr_Clear();
+			*value = max;
+		}
 	}
+
+	if (*value > max)
+		*value = max;
+
+	return 0;
 }
 
 
+#define dawgmeth_find_ints_doc \
+	"find_ints([start, [stop, [width=8]]]) => list\n" \
+	"Returns sorted list of integer keys (see ``add_ints``) " \
+	"of given width in range ``start <= key < stop``; " \
+	"``stop`` equal None means no upper bound."
+
 static PyObject*
-dawgmeth_get_stats(PyObject* self, UNUSED PyObject* args) {
+dawgmeth_find_ints(PyObject* self, PyObject* args, PyObject* kwargs) {
 #define obj ((DAWGclass*)self)
 #define dawg (obj->dawg)
-	update_stats(obj);
+	static char* kwlist[] = {"start", "stop", "width", NULL};
+
+	PyObject* start_obj = NULL;
+	PyObject* stop_obj = Py_None;
+	Py_ssize_t width = 8;
+	uint64_t lo = 0;
+	uint64_t hi;
+	uint64_t* keys;
+	size_t count;
+	size_t i;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "|OOn", kwlist, &start_obj, &stop_obj, &width))
+		return NULL;
 
-    PyObject* dict = Py_BuildValue(
-        "{s:i,s:i,s:i,s:i,s:i,s:i,s:i}",
-#define emit(name) #name, obj->stats.name
-        emit(nodes_count),
-        emit(edges_count),
-        emit(words_count),
-        emit(longest_word),
-        emit(sizeof_node),
-        emit(sizeof_edge),
-        emit(graph_size)
-#undef emit
-    );
+	if (width < 1 or width > DAWG_INT_MAX_WIDTH) {
+		PyErr_Format(PyExc_ValueError, "width must be in range 1..%d", DAWG_INT_MAX_WIDTH);
+		return NULL;
+	}
 
-	return dict;
+	const uint64_t max = (width == 8) ? UINT64_MAX : (UINT64_C(1) << (8 * width)) - 1;
+
+	if (start_obj and get_int_bound(start_obj, max, &lo) < 0)
+		return NULL;
+
+	hi = max;
+	if (stop_obj != Py_None) {
+		// the greatest key is stop - 1
+		PyObject* one = PyLong_FromLong(1);
+		PyObject* last = one ? PyNumber_Subtract(stop_obj, one) : NULL;
+		Py_XDECREF(one);
+		if (last == NULL)
+			return NULL;
+
+		const int ret = get_int_bound(last, max, &hi);
+		Py_DECREF(last);
+		if (ret < 0)
+			return NULL;
+
+		if (ret > 0)	// stop <= 0
+			return PyList_New(0);
+	}
+
+	int ret;
+	obj->readers += 1;
+	Py_BEGIN_ALLOW_THREADS
+	ret = DAWG_find_ints(&dawg, lo, hi, width, &keys, &count);
+	Py_END_ALLOW_THREADS
+	obj->readers -= 1;
+
+	if (ret != DAWG_OK) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	PyObject* list = PyList_New(count);
+	if (list == NULL)
+		goto error;
+
+	for (i=0; i < count; i++) {
+		PyObject* item = PyLong_FromUnsignedLongLong(keys[i]);
+		if (item == NULL) {
+			Py_DECREF(list);
+			list = NULL;
+			goto error;
+		}
+
+		PyList_SET_ITEM(list, i, item);
+	}
+
+error:
+	if (keys)
+		PyMem_RawFree(keys);
+
+	return list;
 #undef dawg
 #undef obj
 }
 
 
-#define dawgmeth_get_hash_stats_doc \
-	"Returns dict containing some info about hash table used by DAWG"
+#define dawgmeth_longest_prefix_doc \
+	"Returns length of the longest prefix of word that exists in a set."
 
 static PyObject*
-dawgmeth_get_hash_stats(PyObject* self, UNUSED PyObject* args) {
+dawgmeth_longest_prefix(PyObject* self, PyObject* value) {
 #define obj ((DAWGclass*)self)
 #define dawg (obj->dawg)
-	DAWGHashStatistics stats;
-	DAWG_get_hash_stats(&dawg, &stats);
+	LookupString word;
+	PyObject*	tmp;
 
-    PyObject* dict = Py_BuildValue(
-        "{s:i,s:i,s:i,s:i}",
-#define emit(name) #name, stats.name
-        emit(table_size),
-        emit(element_size),
-        emit(items_count),
-        emit(item_size)
-#undef emit
-    );
+	tmp = pymod_get_lookup_string(value, &word);
+	if (tmp == NULL)
+		return NULL;
 
-	return dict;
+	size_t len;
+	if (dawg.profile)
+		len = DAWG_LOOKUP(DAWG_profile_longest_prefix, &dawg, word);
+	else if (has_da(obj))
+		len = DAWG_LOOKUP(DAWG_da_longest_prefix, &obj->da, word);
+	else
+		len = DAWG_LOOKUP(DAWG_longest_prefix, &dawg, word);
+
+	len = pymod_prefix_length((const DAWG_LETTER_TYPE*)word.chars, word.length, len);
+	Py_DECREF(tmp);
+
+	return Py_BuildValue("i", len);
 #undef dawg
 #undef obj
 }
 
 
-typedef struct DumpAux {
-	PyObject*	nodes;
-	PyObject*	edges;
-	char		error;
-} DumpAux;
+
+/*	lookups of words start .. end - 1; returns index of the first invalid word,
+	end if all are valid. Profile is used only if it's collected when lookups
+	start, it's not read again without GIL.
+*/
+typedef size_t (*batch_lookup_function)(DAWGclass* obj, const LookupBatch* batch, const size_t start, const size_t end, const bool profile, void* result);
+
+
+static size_t
+exists_many_aux(DAWGclass* obj, const LookupBatch* batch, const size_t start, const size_t end, const bool profile, void* result) {
+#define dawg (obj->dawg)
+	uint8_t* bytes = (uint8_t*)result;
+	LookupString word;
+	size_t i;
+
+	for (i=start; i < end; i++) {
+		if (not pymod_batch_word(batch, i, &word))
+			break;
+
+		if (profile)
+			bytes[i] = DAWG_LOOKUP(DAWG_profile_exists, &dawg, word);
+		else if (has_da(obj))
+			bytes[i] = DAWG_LOOKUP(DAWG_da_exists, &obj->da, word);
+		else
+			bytes[i] = DAWG_LOOKUP(DAWG_exists, &dawg, word);
+	}
+
+	return i;
+#undef dawg
+}
+
+
+static size_t
+longest_prefix_many_aux(DAWGclass* obj, const LookupBatch* batch, const size_t start, const size_t end, const bool profile, void* result) {
+#define dawg (obj->dawg)
+	uint32_t* lengths = (uint32_t*)result;
+	LookupString word;
+	size_t i;
+
+	for (i=start; i < end; i++) {
+		if (not pymod_batch_word(batch, i, &word))
+			break;
+
+		size_t len;
+		if (profile)
+			len = DAWG_LOOKUP(DAWG_profile_longest_prefix, &dawg, word);
+		else if (has_da(obj))
+			len = DAWG_LOOKUP(DAWG_da_longest_prefix, &obj->da, word);
+		else
+			len = DAWG_LOOKUP(DAWG_longest_prefix, &dawg, word);
+
+		lengths[i] = pymod_prefix_length((const DAWG_LETTER_TYPE*)word.chars, word.length, len);
+	}
+
+	return i;
+#undef dawg
+}
+
+
+/*	Run lookups of all words of batch, GIL is released unless profile
+	is collected. Returns -1 and sets exception on error.
+*/
+static int
+batch_lookup(DAWGclass* obj, LookupBatch* batch, batch_lookup_function fun, void* result) {
+	size_t start;
+	size_t end;
+	size_t invalid;
+	int ret = 0;
+
+	// decided once, profiling can't be started nor stopped while DAWG is read
+	const bool profile = (obj->dawg.profile != NULL);
+
+	obj->readers += 1;
+	for (start=0; start < batch->count; start = end) {
+		if (pymod_fill_lookup_batch(batch, start, &end) < 0) {
+			ret = -1;
+			break;
+		}
+
+		if (profile)
+			// visits are counted, GIL is kept
+			invalid = fun(obj, batch, start, end, profile, result);
+		else {
+			Py_BEGIN_ALLOW_THREADS
+			invalid = fun(obj, batch, start, end, profile, result);
+			Py_END_ALLOW_THREADS
+		}
+
+		if (invalid < end) {
+			pymod_batch_word_error(batch, invalid);
+			ret = -1;
+			break;
+		}
+	}
+	obj->readers -= 1;
+
+	return ret;
+}
+
+
+#define dawgmeth_exists_many_doc \
+	"exists_many(words, [offsets]) => bytearray\n" \
+	"Check many words: list of words or, if offsets are given, buffer " \
+	"of letters where i-th word spans ``words[offsets[i]:offsets[i + 1]]`` " \
+	"(Arrow string array). i-th byte of result is 1 if i-th word is in " \
+	"set. Lookups are done without GIL."
+
+static PyObject*
+dawgmeth_exists_many(PyObject* self, PyObject* args) {
+	PyObject* words;
+	PyObject* offsets = NULL;
+	LookupBatch batch;
+	PyObject* result;
+
+	if (not PyArg_ParseTuple(args, "O|O", &words, &offsets))
+		return NULL;
+
+	if (pymod_get_lookup_batch(words, offsets, &batch) < 0)
+		return NULL;
+
+	result = PyByteArray_FromStringAndSize(NULL, batch.count);
+	if (result != NULL and batch_lookup((DAWGclass*)self, &batch, exists_many_aux, PyByteArray_AS_STRING(result)) < 0)
+		Py_CLEAR(result);
+
+	pymod_release_lookup_batch(&batch);
+	return result;
+}
+
+
+#define dawgmeth_longest_prefix_many_doc \
+	"longest_prefix_many(words, [offsets]) => array('I')\n" \
+	"Returns lengths of the longest prefixes of many words, words " \
+	"are given like for ``exists_many``. Lookups are done without GIL."
+
+static PyObject*
+dawgmeth_longest_prefix_many(PyObject* self, PyObject* args) {
+	PyObject* words;
+	PyObject* offsets = NULL;
+	LookupBatch batch;
+	PyObject* result;
+	Py_buffer view;
+
+	if (not PyArg_ParseTuple(args, "O|O", &words, &offsets))
+		return NULL;
+
+	if (pymod_get_lookup_batch(words, offsets, &batch) < 0)
+		return NULL;
+
+	result = pymod_new_uint32_array(batch.count);
+	if (result == NULL)
+		goto error;
+
+	// exported buffer keeps array from resizing
+	if (PyObject_GetBuffer(result, &view, PyBUF_WRITABLE | PyBUF_C_CONTIGUOUS) < 0) {
+		Py_CLEAR(result);
+		goto error;
+	}
+
+	ASSERT(view.len == (Py_ssize_t)(batch.count * sizeof(uint32_t)));
+
+	const int ret = batch_lookup((DAWGclass*)self, &batch, longest_prefix_many_aux, view.buf);
+	PyBuffer_Release(&view);
+	if (ret < 0)
+		Py_CLEAR(result);
+
+error:
+	pymod_release_lookup_batch(&batch);
+	return result;
+}
+
+
+static Py_ssize_t
+dawgmeth_len(PyObject* self) {
+#define dawg (((DAWGclass*)self)->dawg)
+	return dawg.count;
+#undef dawg
+}
+
+
+#define dawgmeth_clear_doc \
+	"Erase all words from set."
+
+static PyObject*
+dawgmeth_clear(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	int result = DAWG_clear(&dawg);
+	if(result==DAWG_NO_MEM) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+	DAWG_da_free(&obj->da);
+	obj->version += 1;
+	Py_RETURN_NONE;
+#undef dawg
+#undef obj
+}
+
+
+/* validate layout argument */
+static int
+get_layout(const int value, DAWGLayout* layout) {
+	switch ((DAWGLayout)value) {
+		case LAYOUT_NONE:
+		case LAYOUT_BFS:
+			*layout = (DAWGLayout)value;
+			return 0;
+
+		default:
+			PyErr_SetString(PyExc_ValueError, "layout have to be one of LAYOUT_NONE, LAYOUT_BFS");
+			return -1;
+	}
+}
+
+
+/* validate compression argument: None or "varint" */
+static int
+get_compression(PyObject* value, DAWGCompression* compression) {
+	if (value == NULL or value == Py_None) {
+		*compression = COMPRESSION_NONE;
+		return 0;
+	}
+
+	if (PyUnicode_Check(value) and PyUnicode_CompareWithASCIIString(value, "varint") == 0) {
+		*compression = COMPRESSION_VARINT;
+		return 0;
+	}
+
+	PyErr_SetString(PyExc_ValueError, "compression have to be None or 'varint'");
+	return -1;
+}
+
+
+/*	Places nodes of closed DAWG and, if enabled, numbers nodes for
+	perfect hashing; then word2index and index2word don't write to
+	nodes of a frozen graph. Returns -1 and sets exception on error.
+*/
+static int
+set_layout(DAWGclass* obj, const DAWGLayout layout) {
+	if (obj->dawg.state != CLOSED)
+		return 0;
+
+	switch (DAWG_set_layout(&obj->dawg, layout)) {
+		case DAWG_OK:
+#ifdef DAWG_PERFECT_HASHING
+			if (DAWG_mph_numerate_nodes(&obj->dawg) != DAWG_OK) {
+				PyErr_NoMemory();
+				return -1;
+			}
+
+			obj->mph_version = obj->version;
+#endif
+			return 0;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return -1;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_set_layout returned unexpected value");
+			return -1;
+	}
+}
+
+
+#define dawgmeth_close_doc \
+	"close([layout, [jump]])\n" \
+	"Don't allow to add any new words. Also free some memory (a hash table) " \
+	"used to perform incremental algorithm." \
+	"Nodes are placed in memory according to ``layout`` " \
+	"(default ``LAYOUT_BFS``)." \
+	"If ``jump`` is 1 or 2, a table of nodes reached by the first " \
+	"``jump`` letters is built, lookups skip top levels of graph " \
+	"(default 0 --- no table)." \
+	"Can be reverted only by ``clear()``." \
+
+
+static PyObject*
+dawgmeth_close(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	static char* kwlist[] = {"layout", "jump", NULL};
+	DAWGLayout layout;
+	int value = LAYOUT_BFS;
+	int jump = 0;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "|ii", kwlist, &value, &jump))
+		return NULL;
+
+	if (get_layout(value, &layout) < 0)
+		return NULL;
+
+	if (jump < 0 or jump > DAWG_JUMP_MAX_DEPTH) {
+		PyErr_SetString(PyExc_ValueError, "jump have to be 0, 1 or 2");
+		return NULL;
+	}
+
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	DAWG_close(&dawg);
+	obj->version += 1;
+	if (set_layout(obj, layout) < 0)
+		return NULL;
+
+	if (DAWG_jump_build(&dawg, jump) != DAWG_OK) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	Py_RETURN_NONE;
+#undef dawg
+#undef obj
+}
+
+
+#define dawgmeth_get_stats_doc \
+	"Returns dictionary containing some statistics about underlaying data structure:\n" \
+	"* ``nodes_count``	--- number of nodes\n" \
+	"* ``edges_count``	--- number of edges\n" \
+	"* ``words_count``	--- number of distinct words (same as ``len(dawg)``)\n" \
+	"* ``node_size``	--- size of single node (in bytes)\n" \
+	"* ``graph_size``	--- size of whole graph (in bytes); it's about\n" \
+	"  ``nodes_count * node_size + edges_count * pointer size``\n" \
+	"* ``longest_word``	--- length of the longest word\n" \
+	"* ``hash_tbl_size``	--- size of a helper hash table\n" \
+	"* ``hash_tbl_count`` --- number of items in a helper hash table\n" \
+	"* ``jump_depth``	--- number of letters resolved by jump table\n" \
+	"* ``jump_size``	--- size of jump table (in bytes)"
+
+/* returns -1 and sets exception on error */
+static int update_stats(DAWGclass *obj) {
+	if (obj->stats_version != obj->version) {
+		if (DAWG_get_stats(&obj->dawg, &obj->stats) != DAWG_OK) {
+			PyErr_NoMemory();
+			return -1;
+		}
+
+		obj->stats_version = obj->version;
+	}
+
+	return 0;
+}
+
+
+static PyObject*
+dawgmeth_get_stats(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	if (update_stats(obj) < 0)
+		return NULL;
+
+    PyObject* dict = Py_BuildValue(
+        "{s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i,s:i}",
+#define emit(name) #name, obj->stats.name
+        emit(nodes_count),
+        emit(edges_count),
+        emit(words_count),
+        emit(longest_word),
+        emit(sizeof_node),
+        emit(sizeof_edge),
+        emit(graph_size),
+        emit(jump_depth),
+        emit(jump_size)
+#undef emit
+    );
+
+	return dict;
+#undef dawg
+#undef obj
+}
+
+
+#define dawgmeth_get_hash_stats_doc \
+	"Returns dict containing some info about hash table used by DAWG"
+
+static PyObject*
+dawgmeth_get_hash_stats(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	DAWGHashStatistics stats;
+	DAWG_get_hash_stats(&dawg, &stats);
+
+    PyObject* dict = Py_BuildValue(
+        "{s:i,s:i,s:i,s:i}",
+#define emit(name) #name, stats.name
+        emit(table_size),
+        emit(element_size),
+        emit(items_count),
+        emit(item_size)
+#undef emit
+    );
+
+	return dict;
+#undef dawg
+#undef obj
+}
+
+
+typedef struct DumpAux {
+	PyObject*	nodes;
+	PyObject*	edges;
+	char		error;
+} DumpAux;
 
 
 static int
@@ -569,131 +1212,697 @@ dawgmeth_dump(PyObject* self, UNUSED PyObject* args) {
 	if (dump.nodes == NULL or dump.edges == NULL)
 		goto error;
 
-	DAWG_traverse_DFS(&dawg, dump_aux, &dump);
-	if (dump.error)
-		goto error;
-	else
-		return Py_BuildValue("OO", dump.nodes, dump.edges);
+	DAWG_traverse_DFS(&dawg, dump_aux, &dump);
+	if (dump.error)
+		goto error;
+	else
+		return Py_BuildValue("OO", dump.nodes, dump.edges);
+
+error:
+	Py_XDECREF(dump.nodes);
+	Py_XDECREF(dump.edges);
+	return NULL;
+#undef dawg
+}
+
+
+typedef struct WordsAux {
+	PyObject* list;
+	DAWG_LETTER_TYPE* buffer;
+	bool error;
+} WordsAux;
+
+
+static int
+words_aux(DAWGNode* node, const size_t depth, WordsAux* words) {
+	PyObject* item;
+	DAWGNode* child;
+	int i;
+
+	if (node->eow) {
+		item = pymod_make_string(words->buffer, depth);
+		if (item == NULL) {
+			words->error = true;
+			return 0;
+		}
+		else if (PyList_Append(words->list, item) < 0) {
+			words->error = true;
+			return 0;
+		}
+	}
+	
+	for (i=0; i < node->n; i++) {
+		words->buffer[depth] = node->next[i].letter;
+		child = node->next[i].child;
+		if (words_aux(child, depth + 1, words) == 0)
+			return 0;
+	}
+
+#undef words
+	return 1;
+}
+
+
+#define dawgmeth_words_doc \
+	"Returns number of distinct words."
+
+static PyObject*
+dawgmeth_words(PyObject* self, UNUSED PyObject* args) {
+#define dawg (((DAWGclass*)self)->dawg)
+	WordsAux words;
+
+	words.error		= false;
+	words.buffer	= NULL;
+	words.list		= NULL;
+
+	words.buffer = (DAWG_LETTER_TYPE*)memalloc((dawg.longest_word + 1) * DAWG_LETTER_SIZE);
+	if (words.buffer == NULL) {
+		PyErr_NoMemory();
+		goto error;
+	}
+
+	words.list = PyList_New(0);
+	if (words.list == NULL)
+		goto error;
+
+	if (dawg.q0 != NULL)
+		words_aux(dawg.q0, 0, &words);
+
+	if (words.error)
+		goto error;
+	else {
+		Py_INCREF(words.list);
+		return words.list;
+	}
+
+error:
+	Py_XDECREF(words.list);
+
+	if (words.buffer != NULL)
+		memfree(words.buffer);
+
+	return NULL;
+#undef dawg
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+/* number nodes if DAWG has changed, returns -1 and sets exception on error */
+static int
+update_mph(DAWGclass* obj) {
+	if (obj->mph_version != obj->version) {
+		if (DAWG_mph_numerate_nodes(&obj->dawg) != DAWG_OK) {
+			PyErr_NoMemory();
+			return -1;
+		}
+
+		obj->mph_version = obj->version;
+	}
+
+	return 0;
+}
+
+#endif
+
+
+/*	numbers of nodes are saved with closed DAWG, then loaded graph
+	is ready for perfect hashing; returns -1 and sets exception on error */
+static int
+dump_numbers(DAWGclass* obj, bool* numbers) {
+	*numbers = false;
+#ifdef DAWG_PERFECT_HASHING
+	if (obj->dawg.state == CLOSED) {
+		if (update_mph(obj) < 0)
+			return -1;
+
+		*numbers = true;
+	}
+#endif
+	return 0;
+}
+
+
+static PyObject*
+dawgobj_bindump(DAWGclass* obj, const DAWGCompression compression) {
+#define dawg (obj->dawg)
+	uint8_t* array;
+	size_t size;
+	bool numbers;
+
+	PyObject* res;
+
+	if (compression == COMPRESSION_NONE and obj->image != NULL and obj->image_version == obj->version) {
+		Py_INCREF(obj->image);
+		return obj->image;
+	}
+
+	if (update_stats(obj) < 0)
+		return NULL;
+
+	if (dump_numbers(obj, &numbers) < 0)
+		return NULL;
+
+	switch (DAWG_save(&dawg, &obj->stats, compression, numbers, &array, &size)) {
+		case DAWG_OK:
+			res = PyBytes_FromStringAndSize((char*)array, size);
+			memfree(array);
+			return res;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_save returned unexpected value");
+			return NULL;
+	}
+#undef dawg
+}
+
+
+#define dawgmeth_bindump_doc \
+	"bindump(compression=None)\n" \
+	"Returns binary image of DAWG. If ``compression`` is 'varint' " \
+	"ids of nodes are omitted and numbers are saved as varints; " \
+	"binload accepts both formats."
+
+static PyObject*
+dawgmeth_bindump(PyObject* self, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"compression", NULL};
+
+	PyObject* value = NULL;
+	DAWGCompression compression;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "|O", kwlist, &value))
+		return NULL;
+
+	if (get_compression(value, &compression) < 0)
+		return NULL;
+
+	return dawgobj_bindump((DAWGclass*)self, compression);
+}
+
+
+/* destination of DAWG_save_stream: file descriptor or Python stream */
+typedef struct DumpTarget {
+	int			fd;			///< file descriptor, -1 if stream is used
+	PyObject*	stream;		///< object having write method
+	int			error;		///< errno of failed write(2)
+} DumpTarget;
+
+
+static int
+dump_target_write(const uint8_t* data, const size_t size, void* extra) {
+#define target ((DumpTarget*)extra)
+	size_t written = 0;
+
+#ifdef DAWG_POSIX
+	if (target->fd >= 0) {
+		Py_BEGIN_ALLOW_THREADS
+		while (written < size) {
+			const ssize_t ret = write(target->fd, data + written, size - written);
+			if (ret >= 0)
+				written += ret;
+			else if (errno != EINTR) {
+				target->error = errno;
+				break;
+			}
+		}
+		Py_END_ALLOW_THREADS
+
+		return (written == size) ? 0 : -1;
+	}
+#endif
+
+	// raw streams might write less than requested
+	while (written < size) {
+		PyObject* chunk = PyBytes_FromStringAndSize((const char*)data + written, size - written);
+		if (chunk == NULL)
+			return -1;
+
+		PyObject* ret = PyObject_CallMethod(target->stream, "write", "O", chunk);
+		Py_DECREF(chunk);
+		if (ret == NULL)
+			return -1;
+
+		if (ret == Py_None)
+			written = size;
+		else {
+			const Py_ssize_t n = PyNumber_AsSsize_t(ret, PyExc_OverflowError);
+			if (n < 0 and PyErr_Occurred()) {
+				Py_DECREF(ret);
+				return -1;
+			}
+
+			written += (n > 0) ? n : 0;
+		}
+
+		Py_DECREF(ret);
+	}
+
+	return 0;
+#undef target
+}
+
+
+#define dawgmeth_bindump_to_doc \
+	"bindump_to(file_or_path, compression=None)\n" \
+	"Write binary image of DAWG (same as returned by bindump) to " \
+	"a path, a file descriptor or an object having write method. " \
+	"Image is written in chunks of 1MB, not built in memory; " \
+	"descriptors are written without GIL."
+
+static PyObject*
+dawgmeth_bindump_to(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	static char* kwlist[] = {"file_or_path", "compression", NULL};
+
+	PyObject* arg;
+	PyObject* value = NULL;
+	DAWGCompression compression;
+	DumpTarget target;
+	bool opened = false;
+	bool numbers;
+	int ret;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|O", kwlist, &arg, &value))
+		return NULL;
+
+	if (get_compression(value, &compression) < 0)
+		return NULL;
+
+	if (update_stats(obj) < 0)
+		return NULL;
+
+	if (dump_numbers(obj, &numbers) < 0)
+		return NULL;
+
+	target.fd		= -1;
+	target.stream	= NULL;
+	target.error	= 0;
+
+	if (PyLong_Check(arg) or PyUnicode_Check(arg) or PyBytes_Check(arg) or PyObject_HasAttrString(arg, "__fspath__")) {
+#ifdef DAWG_POSIX
+		if (PyLong_Check(arg)) {
+			target.fd = PyObject_AsFileDescriptor(arg);
+			if (target.fd < 0)
+				return NULL;
+		}
+		else {
+			PyObject* name;
+			if (not PyUnicode_FSConverter(arg, &name))
+				return NULL;
+
+			Py_BEGIN_ALLOW_THREADS
+			target.fd = open(PyBytes_AS_STRING(name), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+			Py_END_ALLOW_THREADS
+			Py_DECREF(name);
+			if (target.fd < 0) {
+				PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, arg);
+				return NULL;
+			}
+
+			opened = true;
+		}
+#else
+		PyErr_SetString(PyExc_NotImplementedError, "writing files is not supported on this platform");
+		return NULL;
+#endif
+	}
+	else if (PyObject_HasAttrString(arg, "write"))
+		target.stream = arg;
+	else {
+		PyErr_SetString(PyExc_TypeError, "path, file descriptor or object with write method expected");
+		return NULL;
+	}
+
+	// stream might run any code, DAWG mustn't be modified meanwhile
+	obj->readers += 1;
+	ret = DAWG_save_stream(&dawg, &obj->stats, compression, numbers, dump_target_write, &target);
+	obj->readers -= 1;
+
+#ifdef DAWG_POSIX
+	if (opened and close(target.fd) < 0 and ret == DAWG_OK) {
+		target.error = errno;
+		ret = DAWG_WRITE_FAILED;
+	}
+#else
+	(void)opened;
+#endif
+
+	switch (ret) {
+		case DAWG_OK:
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_WRITE_FAILED:
+			if (target.error) {
+				errno = target.error;
+				PyErr_SetFromErrno(PyExc_OSError);
+			}
+			// otherwise exception is set by stream
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_save_stream returned unexpected value");
+			return NULL;
+	}
+#undef dawg
+#undef obj
+}
+
+
+/*	load image, replacing contents of obj; parsing allocates nodes with
+	Python allocator, thus it's done with GIL held */
+static PyObject*
+dawgobj_load(DAWGclass* obj, const uint8_t* array, const size_t size, const DAWGLayout layout, const bool trusted) {
+#define dawg (obj->dawg)
+	bool numbered;
+
+	switch (DAWG_load(&dawg, array, size, trusted, &numbered)) {
+		case DAWG_OK:
+			DAWG_da_free(&obj->da);
+			obj->version = -1;
+			obj->stats_version = -2;
+			obj->image_version = -2;
+#ifdef DAWG_PERFECT_HASHING
+			// numbers come from image (they move with nodes), otherwise
+			// nodes are numbered by the first word2index/index2word
+			obj->mph_version = numbered ? obj->version : -2;
+#endif
+			if (dawg.state == CLOSED) {
+				switch (DAWG_set_layout(&dawg, layout)) {
+					case DAWG_OK:
+						break;
+
+					case DAWG_NO_MEM:
+						PyErr_NoMemory();
+						return NULL;
+
+					default:
+						PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_set_layout returned unexpected value");
+						return NULL;
+				}
+			}
+
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			break;
+
+		case DAWG_DUMP_TRUNCATED:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data truncated"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_MAGICK:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: header corrupted - bad magick"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_STATE:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: header corrupted - invalid DAWG state"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_ROOT_ID:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: header corrupted - invalid root node id"
+			);
+			break;
+
+		case DAWG_DUMP_CORRUPTED_1:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: missing nodes"
+			);
+			break;
+
+		case DAWG_DUMP_CORRUPTED_2:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: invalid index"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_ALPHABET:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: alphabet corrupted"
+			);
+			break;
+
+		case DAWG_DUMP_INCOMPATIBLE:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data incompatible: letters can't be represented by this build"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_NUMBERS:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: numbers of words corrupted"
+			);
+			break;
+
+		case DAWG_DUMP_INVALID_GRAPH:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"input data invalid: graph corrupted"
+			);
+			break;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_load returned unexpected value");
+			break;
+	}
+
+	return NULL;
+#undef dawg
+}
+
+
+static PyObject*
+dawgobj_binload(PyObject* self, PyObject* arg, const DAWGLayout layout, const bool trusted) {
+#define obj ((DAWGclass*)self)
+	Py_buffer view;
+	PyObject* result;
+
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	// any contiguous buffer: bytes, bytearray, mmap, memoryview...
+	if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0)
+		return NULL;
+
+	result = dawgobj_load(obj, (const uint8_t*)view.buf, view.len, layout, trusted);
+
+	PyBuffer_Release(&view);
+	return result;
+#undef obj
+}
+
+
+#define dawgmeth_compile_double_array_doc \
+	"Build double-array (BASE/CHECK) representation of closed DAWG. " \
+	"Then exists, longest_prefix, word2index and index2word cost " \
+	"a single array access per letter. Returns dict with statistics, " \
+	"including ``fill_ratio`` of array."
+
+static PyObject*
+dawgmeth_compile_double_array(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	DAWGDAStatistics stats;
+
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	switch (DAWG_da_compile(&dawg, &obj->da)) {
+		case DAWG_OK:
+#ifdef DAWG_PERFECT_HASHING
+			obj->mph_version = obj->version;
+#endif
+			break;
+
+		case DAWG_NOT_CLOSED:
+			PyErr_SetString(PyExc_ValueError, "DAWG has to be closed");
+			return NULL;
+
+		case DAWG_TOO_BIG:
+			PyErr_SetString(PyExc_ValueError, "DAWG is too big for double-array");
+			return NULL;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_da_compile returned unexpected value");
+			return NULL;
+	}
+
+	DAWG_da_get_stats(&obj->da, &stats);
 
-error:
-	Py_XDECREF(dump.nodes);
-	Py_XDECREF(dump.edges);
-	return NULL;
+	return Py_BuildValue(
+		"{s:n,s:n,s:n,s:n,s:n,s:d}",
+#define emit(name) #name, (Py_ssize_t)stats.name
+		emit(states_count),
+		emit(slots_count),
+		emit(used_slots),
+		emit(alphabet_size),
+		emit(size),
+#undef emit
+		"fill_ratio", (double)stats.used_slots / stats.slots_count
+	);
 #undef dawg
+#undef obj
 }
 
 
-typedef struct WordsAux {
-	PyObject* list;
-	DAWG_LETTER_TYPE* buffer;
-	bool error;
-} WordsAux;
+#define dawgmeth_start_profile_doc \
+	"Start counting visits of nodes made by ``exists``, ``match``, " \
+	"``longest_prefix``, ``find_all`` and iteration; previous counts " \
+	"are discarded. DAWG has to be closed with ``LAYOUT_BFS``. " \
+	"While profiling, lookups don't use double-array."
 
+static PyObject*
+dawgmeth_start_profile(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	if (check_readers(obj) < 0)
+		return NULL;
 
-static int
-words_aux(DAWGNode* node, const size_t depth, WordsAux* words) {
-	PyObject* item;
-	DAWGNode* child;
-	int i;
+	switch (DAWG_profile_start(&dawg)) {
+		case DAWG_OK:
+			Py_RETURN_NONE;
 
-	if (node->eow) {
-#ifdef DAWG_UNICODE
-		item = PyUnicode_FromUnicode(words->buffer, depth);
-#else
-		item = PyBytes_FromStringAndSize((char*)words->buffer, depth);
-#endif
-		if (item == NULL) {
-			words->error = true;
-			return 0;
-		}
-		else if (PyList_Append(words->list, item) < 0) {
-			words->error = true;
-			return 0;
-		}
-	}
-	
-	for (i=0; i < node->n; i++) {
-		words->buffer[depth] = node->next[i].letter;
-		child = node->next[i].child;
-		if (words_aux(child, depth + 1, words) == 0)
-			return 0;
-	}
+		case DAWG_NOT_CLOSED:
+			PyErr_SetString(PyExc_ValueError, "DAWG has to be closed with LAYOUT_BFS");
+			return NULL;
 
-#undef words
-	return 1;
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_profile_start returned unexpected value");
+			return NULL;
+	}
+#undef dawg
+#undef obj
 }
 
 
-#define dawgmeth_words_doc \
-	"Returns number of distinct words."
+#define dawgmeth_get_profile_doc \
+	"get_profile() => bytes\n" \
+	"Returns counts of visits of nodes, gathered since ``start_profile()``. " \
+	"Profile doesn't depend on current layout, it can be saved and passed " \
+	"to ``relayout()`` of a DAWG built from the same words."
 
 static PyObject*
-dawgmeth_words(PyObject* self, UNUSED PyObject* args) {
-#define dawg (((DAWGclass*)self)->dawg)
-	WordsAux words;
+dawgmeth_get_profile(PyObject* self, UNUSED PyObject* args) {
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+	uint8_t* array;
+	size_t size;
+	PyObject* res;
 
-	words.error		= false;
-	words.buffer	= NULL;
-	words.list		= NULL;
+	if (dawg.profile == NULL) {
+		PyErr_SetString(PyExc_ValueError, "profiling is not started");
+		return NULL;
+	}
 
-	words.buffer = (DAWG_LETTER_TYPE*)memalloc((dawg.longest_word + 1) * DAWG_LETTER_SIZE);
-	if (words.buffer == NULL) {
+	if (DAWG_profile_save(&dawg, &array, &size) != DAWG_OK) {
 		PyErr_NoMemory();
-		goto error;
+		return NULL;
 	}
 
-	words.list = PyList_New(0);
-	if (words.list == NULL)
-		goto error;
+	res = PyBytes_FromStringAndSize((char*)array, size);
+	memfree(array);
+	return res;
+#undef dawg
+#undef obj
+}
 
-	if (dawg.q0 != NULL)
-		words_aux(dawg.q0, 0, &words);
 
-	if (words.error)
-		goto error;
-	else {
-		Py_INCREF(words.list);
-		return words.list;
-	}
+#define dawgmeth_stop_profile_doc \
+	"stop_profile() => bytes\n" \
+	"Stop counting visits of nodes, returns profile (see ``get_profile()``)."
 
-error:
-	Py_XDECREF(words.list);
+static PyObject*
+dawgmeth_stop_profile(PyObject* self, PyObject* args) {
+	if (check_readers((DAWGclass*)self) < 0)
+		return NULL;
 
-	if (words.buffer != NULL)
-		memfree(words.buffer);
+	PyObject* res = dawgmeth_get_profile(self, args);
+	if (res)
+		DAWG_profile_stop(&((DAWGclass*)self)->dawg);
 
-	return NULL;
-#undef dawg
+	return res;
 }
 
 
-#define dawgmeth_bindump_doc \
-	"Returns binary image of DAWG"
+#define dawgmeth_relayout_doc \
+	"relayout(profile)\n" \
+	"Place nodes in memory in order of decreasing counts of visits " \
+	"given by ``profile`` (see ``get_profile()``): nodes used most " \
+	"often are next to each other at the beginning of graph, nodes " \
+	"never visited are placed at the end in BFS order. Stops profiling."
 
 static PyObject*
-dawgmeth_bindump(PyObject* self, UNUSED PyObject* args) {
+dawgmeth_relayout(PyObject* self, PyObject* arg) {
 #define obj ((DAWGclass*)self)
 #define dawg (obj->dawg)
-	uint8_t* array;
-	size_t size;
+	Py_buffer view;
+	int ret;
 
-	PyObject* res;
+	if (check_readers(obj) < 0)
+		return NULL;
 
-	update_stats(obj);
+	if (PyObject_GetBuffer(arg, &view, PyBUF_SIMPLE) < 0)
+		return NULL;
+
+	ret = DAWG_profile_relayout(&dawg, (const uint8_t*)view.buf, (size_t)view.len);
+	PyBuffer_Release(&view);
 
-	switch (DAWG_save(&dawg, &obj->stats, &array, &size)) {
+	switch (ret) {
 		case DAWG_OK:
-			res = PyBytes_FromStringAndSize((char*)array, size);
-			memfree(array);
-			return res;
+#ifdef DAWG_PERFECT_HASHING
+			// numbers are moved along with nodes
+			if (obj->mph_version == obj->version)
+				obj->mph_version += 1;
+#endif
+			obj->version += 1;
+			Py_RETURN_NONE;
+
+		case DAWG_NOT_CLOSED:
+			PyErr_SetString(PyExc_ValueError, "DAWG has to be closed");
+			return NULL;
+
+		case DAWG_PROFILE_MISMATCH:
+			PyErr_SetString(PyExc_ValueError, "profile doesn't match DAWG");
+			return NULL;
 
 		case DAWG_NO_MEM:
 			PyErr_NoMemory();
 			return NULL;
 
 		default:
-			memfree(array);
-			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_save returned unexpected value");
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_profile_relayout returned unexpected value");
 			return NULL;
 	}
 #undef dawg
@@ -702,89 +1911,134 @@ dawgmeth_bindump(PyObject* self, UNUSED PyObject* args) {
 
 
 #define dawgmeth_binload_doc \
-	"Load DAWG with data returned by bindump"
+	"binload(buffer, layout=LAYOUT_BFS, trusted=False)\n" \
+	"Load DAWG with data returned by bindump, given as any object " \
+	"supporting buffer protocol (bytes, bytearray, mmap, memoryview). " \
+	"Nodes of closed DAWG are placed in memory according to ``layout``. " \
+	"If ``trusted`` is true, ids, letters and shape of graph are not validated; " \
+	"use only for images written by bindump."
 
 static PyObject*
-dawgmeth_binload(PyObject* self, PyObject* arg) {
-#define obj ((DAWGclass*)self)
-#define dawg (obj->dawg)
-	if (not PyBytes_Check(arg)) {
-		PyErr_SetString(PyExc_TypeError, "bytes object expected");
+dawgmeth_binload(PyObject* self, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"buffer", "layout", "trusted", NULL};
+
+	PyObject* arg;
+	DAWGLayout layout;
+	int value = LAYOUT_BFS;
+	int trusted = 0;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|ip", kwlist, &arg, &value, &trusted))
 		return NULL;
-	}
 
-	void* array;
-	ssize_t size;
+	if (get_layout(value, &layout) < 0)
+		return NULL;
+
+	return dawgobj_binload(self, arg, layout, trusted);
+}
+
+
+#define dawgmeth_binload_file_doc \
+	"binload_file(path_or_fd, layout=LAYOUT_BFS, trusted=False)\n" \
+	"Load DAWG from a file written with data returned by bindump; " \
+	"argument is a path or a file descriptor (read from its current " \
+	"position to the end, not closed). Same as binload, but data is " \
+	"read directly, without temporary Python object."
+
+static PyObject*
+dawgmeth_binload_file(PyObject* self, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"path_or_fd", "layout", "trusted", NULL};
+
+	PyObject* arg;
+	DAWGLayout layout;
+	int value = LAYOUT_BFS;
+	int trusted = 0;
+	uint8_t* array;
+	size_t size;
+	PyObject* result;
 
-	if (PyBytes_AsStringAndSize(arg, (char**)&array, &size) < 0)
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|ip", kwlist, &arg, &value, &trusted))
 		return NULL;
-	else
-		Py_INCREF(arg);
 
-	const int ret = DAWG_load(&dawg, array, size);
-	Py_DECREF(arg);
-	switch (ret) {
-		case DAWG_OK:
-			obj->version = -1;
-			obj->stats_version = -2;
-#ifdef DAWG_PERFECT_HASHING
-			obj->mph_version = -2;
-#endif
+	if (get_layout(value, &layout) < 0)
+		return NULL;
 
-			Py_RETURN_NONE;
+	if (check_readers((DAWGclass*)self) < 0)
+		return NULL;
 
-		case DAWG_NO_MEM:
-			PyErr_NoMemory();
-			return NULL;
+	if (pymod_read_file(arg, &array, &size) < 0)
+		return NULL;
 
-		case DAWG_DUMP_TRUNCATED:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data truncated"
-			);
-			return NULL;
+	result = dawgobj_load((DAWGclass*)self, array, size, layout, trusted);
 
-		case DAWG_DUMP_INVALID_MAGICK:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data invalid: header corrupted - bad magick"
-			);
-			return NULL;
+	PyMem_RawFree(array);
+	return result;
+}
 
-		case DAWG_DUMP_INVALID_STATE:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data invalid: header corrupted - invalid DAWG state"
-			);
-			return NULL;
 
-		case DAWG_DUMP_INVALID_ROOT_ID:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data invalid: header corrupted - invalid root node id"
-			);
-			return NULL;
+#define dawgmeth_open_doc \
+	"open(path, trusted=False) => CompactDAWG\n" \
+	"Map into memory a file written by CompactDAWG.save; " \
+	"same as CompactDAWG.open."
 
-		case DAWG_DUMP_CORRUPTED_1:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data invalid: missing nodes"
-			);
-			return NULL;
+static PyObject*
+dawgmeth_open(PyObject* cls, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"path", "trusted", NULL};
+	PyDAWGState* state;
+	PyObject* path;
+	int trusted = 0;
 
-		case DAWG_DUMP_CORRUPTED_2:
-			PyErr_SetString(
-				PyExc_ValueError,
-				"input data invalid: invalid index"
-			);
-			return NULL;
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "O|p", kwlist, &path, &trusted))
+		return NULL;
 
-		default:
-			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_load returned unexpected value");
-			return NULL;
+	state = pydawg_get_state((PyTypeObject*)cls);
+	if (state == NULL)
+		return NULL;
+
+	return compactobj_open(state->compact_dawg_type, path, trusted);
+}
+
+
+/*	buffer protocol: read-only image returned by bindump(); exported
+	buffer keeps its image, thus DAWG can be modified while it's used.
+	Image is cached while any buffer is exported, then exporting (or
+	pickling with protocol 5) of unchanged DAWG doesn't save it again;
+	it's released with the last buffer, not to double memory usage.
+*/
+static int
+dawgobj_getbuffer(PyObject* self, Py_buffer* view, int flags) {
+	DAWGclass* dawg = (DAWGclass*)self;
+	PyObject* image = dawgobj_bindump(dawg, COMPRESSION_NONE);
+	if (image == NULL) {
+		view->obj = NULL;
+		return -1;
 	}
-#undef obj
-#undef dawg
+
+	if (PyBuffer_FillInfo(view, self, PyBytes_AS_STRING(image), PyBytes_GET_SIZE(image), 1, flags) < 0) {
+		Py_DECREF(image);
+		return -1;
+	}
+
+	view->internal = image;
+	if (dawg->image != image) {
+		Py_XDECREF(dawg->image);
+		Py_INCREF(image);
+		dawg->image = image;
+		dawg->image_version = dawg->version;
+	}
+
+	dawg->exports += 1;
+	return 0;
+}
+
+
+static void
+dawgobj_releasebuffer(PyObject* self, Py_buffer* view) {
+	DAWGclass* dawg = (DAWGclass*)self;
+
+	Py_DECREF((PyObject*)view->internal);
+	dawg->exports -= 1;
+	if (dawg->exports == 0)
+		Py_CLEAR(dawg->image);
 }
 
 
@@ -793,18 +2047,38 @@ dawgmeth_binload(PyObject* self, PyObject* arg) {
 
 static PyObject*
 dawgmeth___reduce__(PyObject* self, UNUSED PyObject* args) {
-#define obj ((DAWGclass*)self)
-#define dawg (obj->dawg)
 	// return pair: type, bytes
 	PyObject* bytes;
 
-	bytes = dawgmeth_bindump(self, NULL);
+	bytes = dawgobj_bindump((DAWGclass*)self, COMPRESSION_NONE);
 	if (bytes)
-		return Py_BuildValue("O(O)", Py_TYPE(self), bytes);
+		return Py_BuildValue("O(N)", Py_TYPE(self), bytes);
 	else
 		return NULL;
-#undef obj
-#undef dawg
+}
+
+
+#define dawgmeth___reduce_ex___doc \
+	"reduce protocol; image is passed as PickleBuffer since protocol 5, " \
+	"then it might be transferred out-of-band and loaded in place"
+
+static PyObject*
+dawgmeth___reduce_ex__(PyObject* self, PyObject* arg) {
+	const long protocol = PyLong_AsLong(arg);
+	if (protocol == -1 and PyErr_Occurred())
+		return NULL;
+
+#if PY_VERSION_HEX >= 0x03080000
+	if (protocol >= 5) {
+		PyObject* buffer = PyPickleBuffer_FromObject(self);
+		if (buffer)
+			return Py_BuildValue("O(N)", Py_TYPE(self), buffer);
+		else
+			return NULL;
+	}
+#endif
+
+	return dawgmeth___reduce__(self, NULL);
 }
 
 
@@ -819,23 +2093,24 @@ static PyObject*
 dawgmeth_word2index(PyObject* self, PyObject* arg) {
 #define obj ((DAWGclass*)self)
 #define dawg (obj->dawg)
-	String word;
+	LookupString word;
 	PyObject* bytes;
 
-	bytes = get_string(arg, &word);
+	bytes = pymod_get_lookup_string(arg, &word);
 	if (bytes == NULL)
 		return NULL;
 
-	if (obj->mph_version != obj->version) {
-		DAWG_mph_numerate_nodes(&dawg);
-		obj->mph_version = obj->version;
-	}
+	size_t result;
+	if (has_da(obj))
+		result = DAWG_LOOKUP(DAWG_da_word2index, &obj->da, word);
+	else {
+		if (update_mph(obj) < 0) {
+			Py_DECREF(bytes);
+			return NULL;
+		}
 
-	const size_t result = DAWG_mph_word2index(
-							&dawg,
-							word.chars,
-							word.length
-						);
+		result = DAWG_LOOKUP(DAWG_mph_word2index, &dawg, word);
+	}
 	Py_DECREF(bytes);
 
 	switch (result) {
@@ -864,15 +2139,18 @@ dawgmeth_index2word(PyObject* self, PyObject* arg) {
 	if (index == -1 and PyErr_Occurred())
 		return NULL;
 
-	if (obj->mph_version != obj->version) {
-		DAWG_mph_numerate_nodes(&dawg);
-		obj->mph_version = obj->version;
-	}
-	
 	DAWG_LETTER_TYPE* word;
 	size_t wordlen;
+	int result;
+
+	if (has_da(obj))
+		result = DAWG_da_index2word(&obj->da, index, &word, &wordlen);
+	else {
+		if (update_mph(obj) < 0)
+			return NULL;
 
-	const int result = DAWG_mph_index2word(&dawg, index, &word, &wordlen);
+		result = DAWG_mph_index2word(&dawg, index, &word, &wordlen);
+	}
 	switch (result) {
 		case DAWG_NOT_EXISTS:
 			Py_RETURN_NONE;
@@ -884,11 +2162,7 @@ dawgmeth_index2word(PyObject* self, PyObject* arg) {
 		case DAWG_EXISTS:
 			{
 			PyObject* result;
-#ifdef DAWG_UNICODE
-			result = PyUnicode_FromUnicode(word, wordlen);
-#else
-			result = PyBytes_FromStringAndSize((const char*)word, (ssize_t)wordlen);
-#endif
+			result = pymod_make_string(word, wordlen);
 			memfree(word);
 			return result;
 			}
@@ -904,9 +2178,6 @@ dawgmeth_index2word(PyObject* self, PyObject* arg) {
 
 
 
-static
-PySequenceMethods dawg_as_sequence;
-
 static
 PyMemberDef dawg_members[] = {
 	{
@@ -926,23 +2197,39 @@ static
 PyMethodDef dawg_methods[] = {
 	method(add_word,			METH_O),
 	method(add_word_unchecked,	METH_O),
+	{"add_ints", (PyCFunction)dawgmeth_add_ints, METH_VARARGS | METH_KEYWORDS, dawgmeth_add_ints_doc},
+	{"contains_ints", (PyCFunction)dawgmeth_contains_ints, METH_VARARGS | METH_KEYWORDS, dawgmeth_contains_ints_doc},
+	{"find_ints", (PyCFunction)dawgmeth_find_ints, METH_VARARGS | METH_KEYWORDS, dawgmeth_find_ints_doc},
 	method(exists,				METH_O),
 	method(match,				METH_O),
 	method(longest_prefix,		METH_O),
+	method(exists_many,			METH_VARARGS),
+	method(longest_prefix_many,	METH_VARARGS),
 	method(words,				METH_NOARGS),
 	method(find_all,			METH_VARARGS),
 	method(clear,				METH_NOARGS),
-	method(close,				METH_NOARGS),
-	{"freeze", dawgmeth_close, METH_NOARGS, dawgmeth_close_doc},	// alias
+	{"close", (PyCFunction)dawgmeth_close, METH_VARARGS | METH_KEYWORDS, dawgmeth_close_doc},
+	{"freeze", (PyCFunction)dawgmeth_close, METH_VARARGS | METH_KEYWORDS, dawgmeth_close_doc},	// alias
 
 #ifdef DAWG_PERFECT_HASHING
 	method(word2index,			METH_O),
 	method(index2word,			METH_O),
 #endif
 
-	method(bindump,				METH_NOARGS),
-	method(binload,				METH_O),
+	method(compile_double_array,	METH_NOARGS),
+
+	method(start_profile,		METH_NOARGS),
+	method(get_profile,			METH_NOARGS),
+	method(stop_profile,		METH_NOARGS),
+	method(relayout,			METH_O),
+
+	{"bindump", (PyCFunction)dawgmeth_bindump, METH_VARARGS | METH_KEYWORDS, dawgmeth_bindump_doc},
+	{"bindump_to", (PyCFunction)dawgmeth_bindump_to, METH_VARARGS | METH_KEYWORDS, dawgmeth_bindump_to_doc},
+	{"binload", (PyCFunction)dawgmeth_binload, METH_VARARGS | METH_KEYWORDS, dawgmeth_binload_doc},
+	{"binload_file", (PyCFunction)dawgmeth_binload_file, METH_VARARGS | METH_KEYWORDS, dawgmeth_binload_file_doc},
+	{"open", (PyCFunction)dawgmeth_open, METH_VARARGS | METH_KEYWORDS | METH_CLASS, dawgmeth_open_doc},
 	method(__reduce__,			METH_NOARGS),
+	method(__reduce_ex__,		METH_O),
 
 	method(get_stats,			METH_NOARGS),
 	method(get_hash_stats,		METH_NOARGS),
@@ -953,43 +2240,26 @@ PyMethodDef dawg_methods[] = {
 #undef method
 
 static
-PyTypeObject dawg_type = {
-	PY_OBJECT_HEAD_INIT
-	"pydawg.DAWG",								/* tp_name */
-	sizeof(DAWGclass),							/* tp_size */
-	0,											/* tp_itemsize? */
-	(destructor)dawgobj_del,		       	  	/* tp_dealloc */
-	0,                                      	/* tp_print */
-	0,                                         	/* tp_getattr */
-	0,                                          /* tp_setattr */
-	0,                                          /* tp_reserved */
-	0,											/* tp_repr */
-	0,                                          /* tp_as_number */
-	0,                                          /* tp_as_sequence */
-	0,                                          /* tp_as_mapping */
-	0,                                          /* tp_hash */
-	0,                                          /* tp_call */
-	0,                                          /* tp_str */
-	0,                                          /* tp_getattro */
-	0,                                          /* tp_setattro */
-	0,                                          /* tp_as_buffer */
-	Py_TPFLAGS_DEFAULT,                         /* tp_flags */
-	0,                                          /* tp_doc */
-	0,                                          /* tp_traverse */
-	0,                                          /* tp_clear */
-	0,                                          /* tp_richcompare */
-	0,                                          /* tp_weaklistoffset */
-	dawgmeth_iterator,							/* tp_iter */
-	0,                                          /* tp_iternext */
-	dawg_methods,								/* tp_methods */
-	dawg_members,								/* tp_members */
-	0,                                          /* tp_getset */
-	0,                                          /* tp_base */
-	0,                                          /* tp_dict */
-	0,                                          /* tp_descr_get */
-	0,                                          /* tp_descr_set */
-	0,                                          /* tp_dictoffset */
-	0,											/* tp_init */
-	0,                                          /* tp_alloc */
-	dawgobj_new,								/* tp_new */
+PyType_Slot dawg_type_slots[] = {
+	{Py_tp_dealloc,		dawgobj_del},
+	{Py_tp_iter,		dawgmeth_iterator},
+	{Py_tp_methods,		dawg_methods},
+	{Py_tp_members,		dawg_members},
+	{Py_tp_new,			dawgobj_new},
+	{Py_sq_length,		dawgmeth_len},
+	{Py_sq_contains,	dawgmeth_contains},
+	{Py_bf_getbuffer,	dawgobj_getbuffer},
+	{Py_bf_releasebuffer,	dawgobj_releasebuffer},
+	{0, NULL}
+};
+
+
+// SequenceDAWG is derived from DAWG
+static
+PyType_Spec dawg_type_spec = {
+	"pydawg.DAWG",
+	sizeof(DAWGclass),
+	0,
+	Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+	dawg_type_slots
 };
@@ -13,6 +13,7 @@
 #define dawgclass_h_included__
 
 #include "dawg.h"
+#include "dawg_da.h"
 
 typedef struct DAWGclass {
     PyObject_HEAD
@@ -25,6 +26,14 @@ typedef struct DAWGclass {
 #endif
 	int stats_version;		///< version for statistics
 	DAWGStatistics stats;	///< statistics
+
+	DAWGDoubleArray da;		///< double-array, valid if da.slots != NULL
+
+	int readers;			///< number of lookups running without GIL
+
+	PyObject* image;		///< image (bytes) cached while buffers are exported, NULL if none
+	int image_version;		///< version of image
+	int exports;			///< number of buffers exported by buffer protocol
 } DAWGclass;
 
 #endif
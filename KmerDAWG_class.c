@@ -0,0 +1,445 @@
+/*
+	This is part of pydawg Python module.
+
+	Definition of Python class KmerDAWG.
+	(wrapper for functions from dawg_kmer.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "KmerDAWG_class.h"
+
+
+/*	Convert int (packed k-mer), str or bytes to packed k-mer.
+
+	@returns
+		1 - valid k-mer
+		0 - not a k-mer of length k
+		-1 - error, exception is set
+*/
+static int
+kmer_from_object(PyObject* obj, const int k, uint64_t* value) {
+	Py_ssize_t i;
+	int base;
+
+	if (PyLong_Check(obj)) {
+		*value = PyLong_AsUnsignedLongLong(obj);
+		if (*value == (uint64_t)-1 and PyErr_Occurred()) {
+			if (PyErr_ExceptionMatches(PyExc_OverflowError)) {
+				PyErr_Clear();
+				return 0;
+			}
+			else
+				return -1;
+		}
+
+		return (*value & ~DAWG_kmer_mask(k)) == 0;
+	}
+	else if (PyUnicode_Check(obj)) {
+		if (PyUnicode_READY(obj) < 0)
+			return -1;
+
+		if (PyUnicode_GET_LENGTH(obj) != k)
+			return 0;
+
+		const int kind = PyUnicode_KIND(obj);
+		const void* data = PyUnicode_DATA(obj);
+
+		*value = 0;
+		for (i=0; i < k; i++) {
+			base = DAWG_kmer_base(PyUnicode_READ(kind, data, i));
+			if (base < 0)
+				return 0;
+
+			*value = (*value << 2) | base;
+		}
+
+		return 1;
+	}
+	else if (PyBytes_Check(obj)) {
+		if (PyBytes_GET_SIZE(obj) != k)
+			return 0;
+
+		const uint8_t* data = (const uint8_t*)PyBytes_AS_STRING(obj);
+
+		*value = 0;
+		for (i=0; i < k; i++) {
+			base = DAWG_kmer_base(data[i]);
+			if (base < 0)
+				return 0;
+
+			*value = (*value << 2) | base;
+		}
+
+		return 1;
+	}
+	else {
+		PyErr_SetString(PyExc_TypeError, "int, string or bytes expected");
+		return -1;
+	}
+}
+
+
+/* get contiguous buffer of 64-bit integers */
+static int
+kmer_get_buffer(PyObject* obj, Py_buffer* view) {
+	if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+		return -1;
+
+	const char* format = view->format ? view->format : "B";
+	if (*format == '@' or *format == '=')
+		format += 1;
+
+	if (view->itemsize != 8 or format[0] == 0 or format[1] != 0 or strchr("QqLlNn", format[0]) == NULL) {
+		PyBuffer_Release(view);
+		PyErr_SetString(PyExc_TypeError, "buffer of native 64-bit integers expected");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/* collect packed k-mers from buffer or iterable */
+static uint64_t*
+kmer_collect(PyObject* arg, const int k, size_t* count) {
+	uint64_t* words;
+	size_t capacity;
+	size_t i;
+
+	if (PyObject_CheckBuffer(arg)) {
+		Py_buffer view;
+		if (kmer_get_buffer(arg, &view) < 0)
+			return NULL;
+
+		const uint64_t* data = (const uint64_t*)view.buf;
+		const uint64_t mask = DAWG_kmer_mask(k);
+
+		*count = view.len / 8;
+		words = (uint64_t*)memalloc((*count + 1) * sizeof(uint64_t));
+		if (words == NULL) {
+			PyBuffer_Release(&view);
+			PyErr_NoMemory();
+			return NULL;
+		}
+
+		for (i=0; i < *count; i++) {
+			if (data[i] & ~mask) {
+				memfree(words);
+				PyBuffer_Release(&view);
+				PyErr_Format(PyExc_ValueError, "item #%zu is not a valid %d-mer", i, k);
+				return NULL;
+			}
+
+			words[i] = data[i];
+		}
+
+		PyBuffer_Release(&view);
+		return words;
+	}
+
+	PyObject* iter = PyObject_GetIter(arg);
+	if (iter == NULL)
+		return NULL;
+
+	PyObject* item;
+
+	*count = 0;
+	capacity = 1024;
+	words = (uint64_t*)memalloc(capacity * sizeof(uint64_t));
+	if (words == NULL) {
+		Py_DECREF(iter);
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	while ((item = PyIter_Next(iter)) != NULL) {
+		if (*count == capacity) {
+			uint64_t* tmp = (uint64_t*)memrealloc(words, 2 * capacity * sizeof(uint64_t));
+			if (tmp == NULL) {
+				PyErr_NoMemory();
+				goto error;
+			}
+
+			words = tmp;
+			capacity *= 2;
+		}
+
+		switch (kmer_from_object(item, k, &words[*count])) {
+			case 1:
+				*count += 1;
+				break;
+
+			case 0:
+				PyErr_Format(PyExc_ValueError, "%R is not a valid %d-mer", item, k);
+				goto error;
+
+			default:
+				goto error;
+		}
+
+		Py_DECREF(item);
+	}
+
+	Py_DECREF(iter);
+	if (PyErr_Occurred()) {
+		memfree(words);
+		return NULL;
+	}
+
+	return words;
+
+error:
+	Py_DECREF(item);
+	Py_DECREF(iter);
+	memfree(words);
+	return NULL;
+}
+
+
+static PyObject*
+kmerobj_new(PyTypeObject* type, PyObject* args, PyObject* kwargs) {
+	static char* kwlist[] = {"k", "kmers", "canonical", NULL};
+
+	KmerDAWGclass* obj;
+	PyObject* arg;
+	int k;
+	int canonical = 0;
+
+	if (not PyArg_ParseTupleAndKeywords(args, kwargs, "iO|p", kwlist, &k, &arg, &canonical))
+		return NULL;
+
+	if (k < 1 or k > KMER_MAX_K) {
+		PyErr_Format(PyExc_ValueError, "k must be in range 1..%d", KMER_MAX_K);
+		return NULL;
+	}
+
+	size_t count;
+	uint64_t* words = kmer_collect(arg, k, &count);
+	if (words == NULL)
+		return NULL;
+
+	obj = (KmerDAWGclass*)PyObject_New(KmerDAWGclass, type);
+	if (UNLIKELY(obj == NULL)) {
+		memfree(words);
+		return NULL;
+	}
+
+	DAWG_kmer_init(&obj->kmer);
+
+	int ret;
+	Py_BEGIN_ALLOW_THREADS
+	ret = DAWG_kmer_build(&obj->kmer, words, count, k, canonical);
+	Py_END_ALLOW_THREADS
+
+	memfree(words);
+
+	switch (ret) {
+		case DAWG_OK:
+			return (PyObject*)obj;
+
+		case DAWG_NO_MEM:
+			Py_DECREF(obj);
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_TOO_BIG:
+			Py_DECREF(obj);
+			PyErr_SetString(PyExc_ValueError, "too many nodes");
+			return NULL;
+
+		default:
+			Py_DECREF(obj);
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_kmer_build returned unexpected value");
+			return NULL;
+	}
+}
+
+
+static void
+kmerobj_del(PyObject* self) {
+	PyTypeObject* type = Py_TYPE(self);
+
+	DAWG_kmer_free(&((KmerDAWGclass*)self)->kmer);
+	PyObject_Del(self);
+	Py_DECREF(type);
+}
+
+
+#define kmer (((KmerDAWGclass*)self)->kmer)
+
+static int
+kmermeth_contains(PyObject* self, PyObject* value) {
+	uint64_t word;
+
+	switch (kmer_from_object(value, kmer.k, &word)) {
+		case 1:
+			return DAWG_kmer_exists(&kmer, word);
+
+		case 0:
+			return 0;
+
+		default:
+			return -1;
+	}
+}
+
+
+#define kmermeth_exists_doc \
+	"Check if k-mer (packed integer, string or bytes) is in set."
+
+static PyObject*
+kmermeth_exists(PyObject* self, PyObject* value) {
+	switch (kmermeth_contains(self, value)) {
+		case 1:
+			Py_RETURN_TRUE;
+
+		case 0:
+			Py_RETURN_FALSE;
+
+		default:
+			return NULL;
+	}
+}
+
+
+#define kmermeth_contains_many_doc \
+	"contains_many(buffer) => bytearray\n" \
+	"Check all packed k-mers from buffer of 64-bit integers,\n" \
+	"i-th byte of result is 1 if i-th k-mer is in set."
+
+static PyObject*
+kmermeth_contains_many(PyObject* self, PyObject* arg) {
+	Py_buffer view;
+	PyObject* result;
+
+	if (kmer_get_buffer(arg, &view) < 0)
+		return NULL;
+
+	const size_t count = view.len / 8;
+	result = PyByteArray_FromStringAndSize(NULL, count);
+	if (result == NULL) {
+		PyBuffer_Release(&view);
+		return NULL;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	DAWG_kmer_exists_many(&kmer, (const uint64_t*)view.buf, count, (uint8_t*)PyByteArray_AS_STRING(result));
+	Py_END_ALLOW_THREADS
+
+	PyBuffer_Release(&view);
+	return result;
+}
+
+
+#define kmermeth_kmers_doc \
+	"Returns list of all packed k-mers, in increasing order."
+
+static PyObject*
+kmermeth_kmers(PyObject* self, UNUSED PyObject* args) {
+	PyObject* list;
+	PyObject* item;
+	uint64_t* words;
+	size_t i;
+
+	words = (uint64_t*)memalloc((kmer.words_count + 1) * sizeof(uint64_t));
+	if (words == NULL) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	DAWG_kmer_words(&kmer, words);
+
+	list = PyList_New(kmer.words_count);
+	if (list == NULL)
+		goto error;
+
+	for (i=0; i < kmer.words_count; i++) {
+		item = PyLong_FromUnsignedLongLong(words[i]);
+		if (item == NULL) {
+			Py_DECREF(list);
+			goto error;
+		}
+
+		PyList_SET_ITEM(list, i, item);
+	}
+
+	memfree(words);
+	return list;
+
+error:
+	memfree(words);
+	return NULL;
+}
+
+
+static Py_ssize_t
+kmermeth_len(PyObject* self) {
+	return kmer.words_count;
+}
+
+
+#define kmermeth_get_stats_doc \
+	"Returns dictionary containing some statistics about structure:\n" \
+	"- k\n" \
+	"- canonical\n" \
+	"- nodes_count\n" \
+	"- words_count\n" \
+	"- size -- size of structure in bytes"
+
+static PyObject*
+kmermeth_get_stats(PyObject* self, UNUSED PyObject* args) {
+	DAWGKmerStatistics stats;
+
+	DAWG_kmer_get_stats(&kmer, &stats);
+
+	return Py_BuildValue(
+		"{s:n,s:O,s:n,s:n,s:n}",
+		"k", (Py_ssize_t)stats.k,
+		"canonical", kmer.canonical ? Py_True : Py_False,
+#define emit(name) #name, (Py_ssize_t)stats.name
+		emit(nodes_count),
+		emit(words_count),
+		emit(size)
+#undef emit
+	);
+}
+
+#undef kmer
+
+
+#define method(name, kind) {#name, kmermeth_##name, kind, kmermeth_##name##_doc}
+static
+PyMethodDef kmer_dawg_methods[] = {
+	method(exists,				METH_O),
+	method(contains_many,		METH_O),
+	method(kmers,				METH_NOARGS),
+
+	method(get_stats,			METH_NOARGS),
+
+	{NULL, NULL, 0, NULL}
+};
+#undef method
+
+
+static
+PyType_Slot kmer_dawg_type_slots[] = {
+	{Py_tp_dealloc,		kmerobj_del},
+	{Py_tp_methods,		kmer_dawg_methods},
+	{Py_tp_new,			kmerobj_new},
+	{Py_sq_length,		kmermeth_len},
+	{Py_sq_contains,	kmermeth_contains},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec kmer_dawg_type_spec = {
+	"pydawg.KmerDAWG",
+	sizeof(KmerDAWGclass),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	kmer_dawg_type_slots
+};
@@ -0,0 +1,24 @@
+/*
+	This is part of pydawg Python module.
+
+	Declaration of Python class KmerDAWG -- read-only set
+	of fixed length DNA words.
+	(wrapper for functions from dawg_kmer.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef kmerdawgclass_h_included__
+#define kmerdawgclass_h_included__
+
+#include "dawg_kmer.h"
+
+typedef struct KmerDAWGclass {
+	PyObject_HEAD
+
+	DAWGKmer kmer;	///< k-mers graph
+} KmerDAWGclass;
+
+#endif
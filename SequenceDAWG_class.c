@@ -0,0 +1,633 @@
+/*
+	This is part of pydawg Python module.
+
+	Definition of Python class SequenceDAWG.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "SequenceDAWG_class.h"
+
+
+static void
+seq_put_token(DAWG_LETTER_TYPE* letters, const uint32_t token) {
+#if DAWG_TOKEN_LETTERS == 1
+	letters[0] = token;
+#else
+	letters[0] = (token >> 24);
+	letters[1] = (token >> 16) & 0xff;
+	letters[2] = (token >> 8) & 0xff;
+	letters[3] = token & 0xff;
+#endif
+}
+
+
+static uint32_t
+seq_get_token(const DAWG_LETTER_TYPE* letters) {
+#if DAWG_TOKEN_LETTERS == 1
+	return letters[0];
+#else
+	return ((uint32_t)letters[0] << 24) | ((uint32_t)letters[1] << 16) | ((uint32_t)letters[2] << 8) | letters[3];
+#endif
+}
+
+
+/* get contiguous buffer of unsigned integers, returns -1 and sets exception on error */
+static int
+seq_get_buffer(PyObject* obj, Py_buffer* view) {
+	if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+		return -1;
+
+	const char* format = view->format ? view->format : "B";
+	if (*format == '@' or *format == '=')
+		format += 1;
+
+	if (format[0] == 0 or format[1] != 0 or strchr("BHILQN", format[0]) == NULL) {
+		PyBuffer_Release(view);
+		PyErr_SetString(PyExc_TypeError, "buffer of unsigned integers expected");
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/* convert count integers from buffer to tokens, returns -1 and sets exception on error */
+static int
+seq_from_buffer(const Py_buffer* view, const size_t count, DAWG_LETTER_TYPE* letters) {
+	uint64_t value;
+	size_t i;
+
+	for (i=0; i < count; i++) {
+		switch (view->itemsize) {
+			case 1:
+				value = ((const uint8_t*)view->buf)[i];
+				break;
+
+			case 2:
+				value = ((const uint16_t*)view->buf)[i];
+				break;
+
+			case 4:
+				value = ((const uint32_t*)view->buf)[i];
+				break;
+
+			default:
+				value = ((const uint64_t*)view->buf)[i];
+				break;
+		}
+
+		if (value > UINT32_MAX) {
+			PyErr_SetString(PyExc_OverflowError, "token doesn't fit in 32 bits");
+			return -1;
+		}
+
+		seq_put_token(letters + i * DAWG_TOKEN_LETTERS, (uint32_t)value);
+	}
+
+	return 0;
+}
+
+
+/* convert sequence of tokens (buffer or sequence of integers) to word, word->chars has to be freed */
+static int
+get_sequence(PyObject* obj, String* word) {
+	Py_ssize_t count;
+	Py_ssize_t i;
+
+	word->chars = NULL;
+	word->length = 0;
+
+	if (PyObject_CheckBuffer(obj)) {
+		Py_buffer view;
+		if (seq_get_buffer(obj, &view) < 0)
+			return -1;
+
+		count = view.len / view.itemsize;
+		word->chars = (DAWG_LETTER_TYPE*)memalloc((count * DAWG_TOKEN_LETTERS + 1) * DAWG_LETTER_SIZE);
+		if (word->chars == NULL) {
+			PyBuffer_Release(&view);
+			PyErr_NoMemory();
+			return -1;
+		}
+
+		const int ret = seq_from_buffer(&view, count, word->chars);
+		PyBuffer_Release(&view);
+		if (ret < 0)
+			goto error;
+
+		word->length = count * DAWG_TOKEN_LETTERS;
+		return 0;
+	}
+
+	PyObject* seq = PySequence_Fast(obj, "sequence of tokens expected");
+	if (seq == NULL)
+		return -1;
+
+	count = PySequence_Fast_GET_SIZE(seq);
+	word->chars = (DAWG_LETTER_TYPE*)memalloc((count * DAWG_TOKEN_LETTERS + 1) * DAWG_LETTER_SIZE);
+	if (word->chars == NULL) {
+		Py_DECREF(seq);
+		PyErr_NoMemory();
+		return -1;
+	}
+
+	for (i=0; i < count; i++) {
+		const unsigned long value = PyLong_AsUnsignedLong(PySequence_Fast_GET_ITEM(seq, i));
+		if (value == (unsigned long)-1 and PyErr_Occurred()) {
+			Py_DECREF(seq);
+			goto error;
+		}
+
+		if (value > UINT32_MAX) {
+			Py_DECREF(seq);
+			PyErr_SetString(PyExc_OverflowError, "token doesn't fit in 32 bits");
+			goto error;
+		}
+
+		seq_put_token(word->chars + i * DAWG_TOKEN_LETTERS, (uint32_t)value);
+	}
+
+	Py_DECREF(seq);
+	word->length = count * DAWG_TOKEN_LETTERS;
+	return 0;
+
+error:
+	memfree(word->chars);
+	word->chars = NULL;
+	return -1;
+}
+
+
+/* returns tuple of tokens */
+static PyObject*
+make_sequence(const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	const size_t count = wordlen / DAWG_TOKEN_LETTERS;
+	PyObject* tuple;
+	PyObject* item;
+	size_t i;
+
+	tuple = PyTuple_New(count);
+	if (tuple == NULL)
+		return NULL;
+
+	for (i=0; i < count; i++) {
+		item = PyLong_FromUnsignedLong(seq_get_token(word + i * DAWG_TOKEN_LETTERS));
+		if (item == NULL) {
+			Py_DECREF(tuple);
+			return NULL;
+		}
+
+		PyTuple_SET_ITEM(tuple, i, item);
+	}
+
+	return tuple;
+}
+
+
+#define obj ((DAWGclass*)self)
+#define dawg (obj->dawg)
+
+static PyObject*
+seq_add(PyObject* self, PyObject* value, const bool checked) {
+	String word;
+
+	if (check_readers(obj) < 0)
+		return NULL;
+
+	if (get_sequence(value, &word) < 0)
+		return NULL;
+
+	const int ret = checked ? DAWG_add_word(&dawg, word) : DAWG_add_word_unchecked(&dawg, word);
+	memfree(word.chars);
+
+	switch (ret) {
+		case 1:
+			obj->version += 1;
+			Py_RETURN_TRUE;
+
+		case 0:
+			Py_RETURN_FALSE;
+
+		case DAWG_FROZEN:
+			PyErr_SetString(
+				PyExc_AttributeError,
+				"DAWG has been freezed, no further chanages are allowed"
+			);
+			return NULL;
+
+		case DAWG_WORD_LESS:
+			PyErr_SetString(
+				PyExc_ValueError,
+				"sequence is less then previosuly added, can't update DAWG"
+			);
+			return NULL;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			Py_RETURN_NONE;
+	}
+}
+
+
+#define seqmeth_add_word_doc \
+	"Add sequence of tokens, returns True if it didn't exists in a set. " \
+	"Sequences have to be added in lexicographic order."
+
+static PyObject*
+seqmeth_add_word(PyObject* self, PyObject* value) {
+	return seq_add(self, value, true);
+}
+
+
+#define seqmeth_add_word_unchecked_doc \
+	"Does the same thing as ``add_word`` but do not check order of sequences."
+
+static PyObject*
+seqmeth_add_word_unchecked(PyObject* self, PyObject* value) {
+	return seq_add(self, value, false);
+}
+
+
+static int
+seqmeth_contains(PyObject* self, PyObject* value) {
+	String word;
+
+	if (get_sequence(value, &word) < 0)
+		return -1;
+
+	int ret;
+	if (dawg.profile)
+		ret = DAWG_profile_exists(&dawg, word.chars, word.length);
+	else if (has_da(obj))
+		ret = DAWG_da_exists(&obj->da, word.chars, word.length);
+	else
+		ret = DAWG_exists(&dawg, word.chars, word.length);
+
+	memfree(word.chars);
+	return ret;
+}
+
+
+#define seqmeth_exists_doc \
+	"Check if sequence is in set."
+
+static PyObject*
+seqmeth_exists(PyObject* self, PyObject* value) {
+	switch (seqmeth_contains(self, value)) {
+		case 1:
+			Py_RETURN_TRUE;
+
+		case 0:
+			Py_RETURN_FALSE;
+
+		default:
+			return NULL;
+	}
+}
+
+
+#define seqmeth_longest_prefix_doc \
+	"Returns number of tokens of the longest prefix of sequence that exists in a set."
+
+static PyObject*
+seqmeth_longest_prefix(PyObject* self, PyObject* value) {
+	String word;
+
+	if (get_sequence(value, &word) < 0)
+		return NULL;
+
+	size_t len;
+	if (dawg.profile)
+		len = DAWG_profile_longest_prefix(&dawg, word.chars, word.length);
+	else if (has_da(obj))
+		len = DAWG_da_longest_prefix(&obj->da, word.chars, word.length);
+	else
+		len = DAWG_longest_prefix(&dawg, word.chars, word.length);
+
+	memfree(word.chars);
+	return Py_BuildValue("n", (Py_ssize_t)(len / DAWG_TOKEN_LETTERS));
+}
+
+
+#define seqmeth_contains_many_doc \
+	"contains_many(sequences) => bytearray\n" \
+	"Check many sequences: 2D buffer of unsigned integers (one sequence " \
+	"per row) or iterable of sequences. i-th byte of result is 1 if " \
+	"i-th sequence is in set. Lookups are done without GIL."
+
+static PyObject*
+seqmeth_contains_many(PyObject* self, PyObject* arg) {
+	DAWG_LETTER_TYPE* letters = NULL;
+	size_t* offsets = NULL;		// i-th sequence is letters[offsets[i] .. offsets[i + 1])
+	size_t count = 0;
+	size_t size = 0;
+	size_t i;
+
+	PyObject* result = NULL;
+
+	if (PyObject_CheckBuffer(arg)) {
+		Py_buffer view;
+		if (seq_get_buffer(arg, &view) < 0)
+			return NULL;
+
+		if (view.ndim != 2) {
+			PyBuffer_Release(&view);
+			PyErr_SetString(PyExc_ValueError, "2D buffer expected");
+			return NULL;
+		}
+
+		count = view.shape[0];
+		const size_t row = view.shape[1] * DAWG_TOKEN_LETTERS;
+
+		letters = (DAWG_LETTER_TYPE*)memalloc((count * row + 1) * DAWG_LETTER_SIZE);
+		offsets = (size_t*)memalloc((count + 1) * sizeof(size_t));
+		if (letters == NULL or offsets == NULL) {
+			PyBuffer_Release(&view);
+			PyErr_NoMemory();
+			goto error;
+		}
+
+		const int ret = seq_from_buffer(&view, count * view.shape[1], letters);
+		PyBuffer_Release(&view);
+		if (ret < 0)
+			goto error;
+
+		for (i=0; i <= count; i++)
+			offsets[i] = i * row;
+	}
+	else {
+		PyObject* seq = PySequence_Fast(arg, "2D buffer or iterable of sequences expected");
+		if (seq == NULL)
+			return NULL;
+
+		count = PySequence_Fast_GET_SIZE(seq);
+		offsets = (size_t*)memalloc((count + 1) * sizeof(size_t));
+		if (offsets == NULL) {
+			Py_DECREF(seq);
+			PyErr_NoMemory();
+			goto error;
+		}
+
+		size_t capacity = 0;
+		offsets[0] = 0;
+		for (i=0; i < count; i++) {
+			String word;
+			if (get_sequence(PySequence_Fast_GET_ITEM(seq, i), &word) < 0) {
+				Py_DECREF(seq);
+				goto error;
+			}
+
+			if (size + word.length > capacity) {
+				capacity = 2 * (size + word.length) + 64;
+				DAWG_LETTER_TYPE* tmp = (DAWG_LETTER_TYPE*)memrealloc(letters, capacity * DAWG_LETTER_SIZE);
+				if (tmp == NULL) {
+					memfree(word.chars);
+					Py_DECREF(seq);
+					PyErr_NoMemory();
+					goto error;
+				}
+
+				letters = tmp;
+			}
+
+			memcpy(letters + size, word.chars, word.length * DAWG_LETTER_SIZE);
+			memfree(word.chars);
+			size += word.length;
+			offsets[i + 1] = size;
+		}
+
+		Py_DECREF(seq);
+	}
+
+	result = PyByteArray_FromStringAndSize(NULL, count);
+	if (result == NULL)
+		goto error;
+
+	uint8_t* bytes = (uint8_t*)PyByteArray_AS_STRING(result);
+
+	obj->readers += 1;
+	Py_BEGIN_ALLOW_THREADS
+	for (i=0; i < count; i++) {
+		const DAWG_LETTER_TYPE* word = letters + offsets[i];
+		const size_t wordlen = offsets[i + 1] - offsets[i];
+		if (has_da(obj))
+			bytes[i] = DAWG_da_exists(&obj->da, word, wordlen);
+		else
+			bytes[i] = DAWG_exists(&dawg, word, wordlen);
+	}
+	Py_END_ALLOW_THREADS
+	obj->readers -= 1;
+
+error:
+	if (letters)
+		memfree(letters);
+
+	if (offsets)
+		memfree(offsets);
+
+	return result;
+}
+
+
+static int
+seq_words_aux(DAWGNode* node, const size_t depth, DAWG_LETTER_TYPE* buffer, PyObject* list) {
+	size_t i;
+
+	if (node->eow) {
+		PyObject* item = make_sequence(buffer, depth);
+		if (item == NULL)
+			return -1;
+
+		const int ret = PyList_Append(list, item);
+		Py_DECREF(item);
+		if (ret < 0)
+			return -1;
+	}
+
+	for (i=0; i < node->n; i++) {
+		buffer[depth] = node->next[i].letter;
+		if (seq_words_aux(node->next[i].child, depth + 1, buffer, list) < 0)
+			return -1;
+	}
+
+	return 0;
+}
+
+
+#define seqmeth_words_doc \
+	"Returns list of all sequences (tuples of tokens)."
+
+static PyObject*
+seqmeth_words(PyObject* self, UNUSED PyObject* args) {
+	DAWG_LETTER_TYPE* buffer;
+	PyObject* list;
+
+	buffer = (DAWG_LETTER_TYPE*)memalloc((dawg.longest_word + 1) * DAWG_LETTER_SIZE);
+	if (buffer == NULL) {
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	list = PyList_New(0);
+	if (list != NULL and dawg.q0 != NULL) {
+		if (seq_words_aux(dawg.q0, 0, buffer, list) < 0) {
+			Py_DECREF(list);
+			list = NULL;
+		}
+	}
+
+	memfree(buffer);
+	return list;
+}
+
+
+static PyObject*
+seqmeth_iterator(PyObject* self) {
+	PyObject* list;
+	PyObject* iter;
+
+	list = seqmeth_words(self, NULL);
+	if (list == NULL)
+		return NULL;
+
+	iter = PyObject_GetIter(list);
+	Py_DECREF(list);
+	return iter;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+
+#define seqmeth_word2index_doc \
+	"word2index(sequence) => integer\n" \
+	"Returns unique integer in range 1..len() identifies a sequence. " \
+	"If sequence is not present in DAWG, returns None"
+
+static PyObject*
+seqmeth_word2index(PyObject* self, PyObject* arg) {
+	String word;
+
+	if (get_sequence(arg, &word) < 0)
+		return NULL;
+
+	size_t result;
+	if (has_da(obj))
+		result = DAWG_da_word2index(&obj->da, word.chars, word.length);
+	else {
+		if (update_mph(obj) < 0) {
+			memfree(word.chars);
+			return NULL;
+		}
+
+		result = DAWG_mph_word2index(&dawg, word.chars, word.length);
+	}
+
+	memfree(word.chars);
+
+	switch (result) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		default:
+			return Py_BuildValue("n", (Py_ssize_t)result);
+	}
+}
+
+
+#define seqmeth_index2word_doc \
+	"index2word(integer) => tuple\n" \
+	"Returns sequence identified by given integer."
+
+static PyObject*
+seqmeth_index2word(PyObject* self, PyObject* arg) {
+	Py_ssize_t index;
+
+	index = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+	if (index == -1 and PyErr_Occurred())
+		return NULL;
+
+	DAWG_LETTER_TYPE* word;
+	size_t wordlen;
+	int result;
+
+	if (has_da(obj))
+		result = DAWG_da_index2word(&obj->da, index, &word, &wordlen);
+	else {
+		if (update_mph(obj) < 0)
+			return NULL;
+
+		result = DAWG_mph_index2word(&dawg, index, &word, &wordlen);
+	}
+
+	switch (result) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_EXISTS:
+			{
+			PyObject* tuple = make_sequence(word, wordlen);
+			memfree(word);
+			return tuple;
+			}
+
+		default:
+			ASSERT(0);
+			return NULL;
+	}
+}
+#endif
+
+#undef dawg
+#undef obj
+
+
+#define method(name, kind) {#name, seqmeth_##name, kind, seqmeth_##name##_doc}
+static
+PyMethodDef sequence_dawg_methods[] = {
+	method(add_word,			METH_O),
+	method(add_word_unchecked,	METH_O),
+	method(exists,				METH_O),
+	method(longest_prefix,		METH_O),
+	method(contains_many,		METH_O),
+	method(words,				METH_NOARGS),
+
+#ifdef DAWG_PERFECT_HASHING
+	method(word2index,			METH_O),
+	method(index2word,			METH_O),
+#endif
+
+	{NULL, NULL, 0, NULL}
+};
+#undef method
+
+
+static
+PyType_Slot sequence_dawg_type_slots[] = {
+	{Py_tp_dealloc,		dawgobj_del},
+	{Py_tp_iter,		seqmeth_iterator},
+	{Py_tp_methods,		sequence_dawg_methods},
+	{Py_tp_new,			dawgobj_new},
+	{Py_sq_length,		dawgmeth_len},
+	{Py_sq_contains,	seqmeth_contains},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec sequence_dawg_type_spec = {
+	"pydawg.SequenceDAWG",
+	sizeof(DAWGclass),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	sequence_dawg_type_slots
+};
@@ -0,0 +1,26 @@
+/*
+	This is part of pydawg Python module.
+
+	Declaration of Python class SequenceDAWG -- DAWG of sequences
+	of 32-bit tokens (e.g. n-grams of token ids). Class derives
+	from DAWG and shares its graph, only conversion of words differs.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef sequencedawgclass_h_included__
+#define sequencedawgclass_h_included__
+
+#include "DAWG_class.h"
+
+// number of letters per token: a token is a single UCS-4 letter
+// or 4 bytes in big-endian order (order of tokens is kept)
+#if DAWG_LETTER_SIZE == 4
+#	define DAWG_TOKEN_LETTERS 1
+#else
+#	define DAWG_TOKEN_LETTERS 4
+#endif
+
+#endif
@@ -0,0 +1,536 @@
+/*
+	This is part of pydawg Python module.
+
+	Definition of Python class SuccinctDAWG and its iterator.
+	(wrapper for functions from dawg_succinct.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "SuccinctDAWG_class.h"
+
+
+static int
+succinct_load(SuccinctDAWGclass* obj, PyObject* arg) {
+	void* array;
+	Py_ssize_t size;
+
+	if (PyBytes_AsStringAndSize(arg, (char**)&array, &size) < 0)
+		return -1;
+
+	switch (DAWG_succinct_load(&obj->succinct, array, size)) {
+		case DAWG_OK:
+			return 0;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return -1;
+
+		case DAWG_DUMP_TRUNCATED:
+			PyErr_SetString(PyExc_ValueError, "input data truncated");
+			return -1;
+
+		case DAWG_DUMP_INVALID_MAGICK:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: header corrupted - bad magick");
+			return -1;
+
+		case DAWG_DUMP_CORRUPTED_1:
+			PyErr_SetString(PyExc_ValueError, "input data invalid: structure corrupted");
+			return -1;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_succinct_load returned unexpected value");
+			return -1;
+	}
+}
+
+
+static int
+succinct_compile(SuccinctDAWGclass* obj, DAWGclass* dawg) {
+	switch (DAWG_succinct_compile(&dawg->dawg, &obj->succinct)) {
+		case DAWG_OK:
+#ifdef DAWG_PERFECT_HASHING
+			dawg->mph_version = dawg->version;
+#endif
+			return 0;
+
+		case DAWG_NOT_CLOSED:
+			PyErr_SetString(PyExc_ValueError, "DAWG has to be closed");
+			return -1;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return -1;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_succinct_compile returned unexpected value");
+			return -1;
+	}
+}
+
+
+static PyObject*
+succinctobj_new(PyTypeObject* type, PyObject* args, UNUSED PyObject* kwargs) {
+	SuccinctDAWGclass* obj;
+	PyObject* arg;
+	PyDAWGState* state;
+
+	if (not PyArg_ParseTuple(args, "O", &arg))
+		return NULL;
+
+	state = pydawg_get_state(type);
+	if (state == NULL)
+		return NULL;
+
+	if (not PyObject_TypeCheck(arg, state->dawg_type) and not PyBytes_Check(arg)) {
+		PyErr_SetString(PyExc_TypeError, "DAWG or bytes object expected");
+		return NULL;
+	}
+
+	obj = (SuccinctDAWGclass*)PyObject_New(SuccinctDAWGclass, type);
+	if (UNLIKELY(obj == NULL))
+		return NULL;
+
+	DAWG_succinct_init(&obj->succinct);
+
+	int ret;
+	if (PyBytes_Check(arg))
+		ret = succinct_load(obj, arg);
+	else
+		ret = succinct_compile(obj, (DAWGclass*)arg);
+
+	if (ret < 0) {
+		Py_DECREF(obj);
+		return NULL;
+	}
+
+	return (PyObject*)obj;
+}
+
+
+static void
+succinctobj_del(PyObject* self) {
+	PyTypeObject* type = Py_TYPE(self);
+
+	DAWG_succinct_free(&((SuccinctDAWGclass*)self)->succinct);
+	PyObject_Del(self);
+	Py_DECREF(type);
+}
+
+
+#define succinct (((SuccinctDAWGclass*)self)->succinct)
+
+static int
+succinctmeth_contains(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return -1;
+
+	const int ret = DAWG_succinct_exists(&succinct, word.chars, word.length);
+
+	Py_DECREF(tmp);
+	return ret;
+}
+
+
+#define succinctmeth_exists_doc \
+	"Check if word is in set."
+
+static PyObject*
+succinctmeth_exists(PyObject* self, PyObject* value) {
+	switch (succinctmeth_contains(self, value)) {
+		case 1:
+			Py_RETURN_TRUE;
+
+		case 0:
+			Py_RETURN_FALSE;
+
+		default:
+			return NULL;
+	}
+}
+
+
+#define succinctmeth_match_doc \
+	"Check if word or any of its prefix is in a set."
+
+static PyObject*
+succinctmeth_match(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return NULL;
+
+	const size_t len = DAWG_succinct_longest_prefix(&succinct, word.chars, word.length);
+	const int ret = pymod_prefix_length(word.chars, word.length, len) > 0;
+	Py_DECREF(tmp);
+
+	if (ret)
+		Py_RETURN_TRUE;
+	else
+		Py_RETURN_FALSE;
+}
+
+
+#define succinctmeth_longest_prefix_doc \
+	"Returns length of the longest prefix of word that exists in a set."
+
+static PyObject*
+succinctmeth_longest_prefix(PyObject* self, PyObject* value) {
+	String	word;
+	PyObject*	tmp;
+
+	tmp = get_string(value, &word);
+	if (tmp == NULL)
+		return NULL;
+
+	const size_t len = pymod_prefix_length(word.chars, word.length, DAWG_succinct_longest_prefix(&succinct, word.chars, word.length));
+	Py_DECREF(tmp);
+
+	return Py_BuildValue("i", len);
+}
+
+
+static Py_ssize_t
+succinctmeth_len(PyObject* self) {
+	return succinct.words_count;
+}
+
+
+#define succinctmeth_words_doc \
+	"Returns list of all words."
+
+static PyObject*
+succinctmeth_words(PyObject* self, UNUSED PyObject* args) {
+	return PySequence_List(self);
+}
+
+
+#define succinctmeth_get_stats_doc \
+	"Returns dictionary containing some statistics about succinct structure:\n" \
+	"- nodes_count\n" \
+	"- edges_count\n" \
+	"- words_count\n" \
+	"- longest_word\n" \
+	"- alphabet_size\n" \
+	"- letter_bits, child_bits, count_bits -- widths of packed fields\n" \
+	"- size -- size of structure in bytes"
+
+static PyObject*
+succinctmeth_get_stats(PyObject* self, UNUSED PyObject* args) {
+	DAWGSuccinctStatistics stats;
+
+	DAWG_succinct_get_stats(&succinct, &stats);
+
+	return Py_BuildValue(
+		"{s:n,s:n,s:n,s:n,s:n,s:n,s:n,s:n,s:n}",
+#define emit(name) #name, (Py_ssize_t)stats.name
+		emit(nodes_count),
+		emit(edges_count),
+		emit(words_count),
+		emit(longest_word),
+		emit(alphabet_size),
+		emit(letter_bits),
+		emit(child_bits),
+		emit(count_bits),
+		emit(size)
+#undef emit
+	);
+}
+
+
+#define succinctmeth_bindump_doc \
+	"Returns binary image of SuccinctDAWG"
+
+static PyObject*
+succinctmeth_bindump(PyObject* self, UNUSED PyObject* args) {
+	uint8_t* array;
+	size_t size;
+
+	PyObject* res;
+
+	switch (DAWG_succinct_save(&succinct, &array, &size)) {
+		case DAWG_OK:
+			res = PyBytes_FromStringAndSize((char*)array, size);
+			memfree(array);
+			return res;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		default:
+			PyErr_SetString(PyExc_AssertionError, "internal error, function DAWG_succinct_save returned unexpected value");
+			return NULL;
+	}
+}
+
+
+#define succinctmeth___reduce___doc \
+	"reduce protocol"
+
+static PyObject*
+succinctmeth___reduce__(PyObject* self, UNUSED PyObject* args) {
+	// return pair: type, bytes
+	PyObject* bytes;
+	PyObject* res;
+
+	bytes = succinctmeth_bindump(self, NULL);
+	if (bytes == NULL)
+		return NULL;
+
+	res = Py_BuildValue("O(O)", Py_TYPE(self), bytes);
+	Py_DECREF(bytes);
+	return res;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+
+#define succinctmeth_word2index_doc \
+	"word2index(word) => integer\n" \
+	"Returns unique integer in range 1..len() identifies a word." \
+	"If word is not present in DAWG, returns None"
+
+static PyObject*
+succinctmeth_word2index(PyObject* self, PyObject* arg) {
+	String word;
+	PyObject* bytes;
+
+	bytes = get_string(arg, &word);
+	if (bytes == NULL)
+		return NULL;
+
+	const size_t result = DAWG_succinct_word2index(&succinct, word.chars, word.length);
+	Py_DECREF(bytes);
+
+	switch (result) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		default:
+			return Py_BuildValue("n", (Py_ssize_t)result);
+	}
+}
+
+
+#define succinctmeth_index2word_doc \
+	"index2word(integer) => string\n" \
+	"Returns word identified by given integer."
+
+static PyObject*
+succinctmeth_index2word(PyObject* self, PyObject* arg) {
+	Py_ssize_t index;
+
+	index = PyNumber_AsSsize_t(arg, PyExc_OverflowError);
+	if (index == -1 and PyErr_Occurred())
+		return NULL;
+
+	if (index < 1)
+		Py_RETURN_NONE;
+
+	DAWG_LETTER_TYPE* word;
+	size_t wordlen;
+
+	switch (DAWG_succinct_index2word(&succinct, index, &word, &wordlen)) {
+		case DAWG_NOT_EXISTS:
+			Py_RETURN_NONE;
+
+		case DAWG_NO_MEM:
+			PyErr_NoMemory();
+			return NULL;
+
+		case DAWG_EXISTS:
+			{
+			PyObject* result;
+			result = pymod_make_string(word, wordlen);
+			memfree(word);
+			return result;
+			}
+
+		default:
+			ASSERT(0);
+			return NULL;
+	}
+}
+#endif
+
+
+static PyObject*
+succinctmeth_iterator(PyObject* self) {
+	SuccinctDAWGIterator* iter;
+	PyDAWGState* state;
+
+	state = pydawg_get_state(Py_TYPE(self));
+	if (state == NULL)
+		return NULL;
+
+	iter = (SuccinctDAWGIterator*)PyObject_New(SuccinctDAWGIterator, state->succinct_dawg_iterator_type);
+	if (iter == NULL)
+		return NULL;
+
+	iter->dawg		= (SuccinctDAWGclass*)self;
+	iter->top		= 0;
+	iter->started	= false;
+	iter->stack		= (SuccinctDAWGIteratorItem*)memalloc((succinct.longest_word + 1) * sizeof(SuccinctDAWGIteratorItem));
+	iter->buffer	= (DAWG_LETTER_TYPE*)memalloc((succinct.longest_word + 1) * DAWG_LETTER_SIZE);
+
+	Py_INCREF(self);
+
+	if (iter->stack == NULL or iter->buffer == NULL) {
+		Py_DECREF(iter);
+		PyErr_NoMemory();
+		return NULL;
+	}
+
+	if (succinct.nodes_count > 0) {
+		const DAWGSuccinctRange range = DAWG_succinct_edges(&succinct, 0);
+		iter->stack[0].node	= 0;
+		iter->stack[0].edge	= range.first;
+		iter->stack[0].end	= range.end;
+		iter->top = 1;
+	}
+
+	return (PyObject*)iter;
+}
+
+#undef succinct
+
+
+#define iter ((SuccinctDAWGIterator*)self)
+#define succinct (iter->dawg->succinct)
+
+static void
+succinctiter_del(PyObject* self) {
+	PyTypeObject* type = Py_TYPE(self);
+
+	if (iter->stack)
+		memfree(iter->stack);
+
+	if (iter->buffer)
+		memfree(iter->buffer);
+
+	Py_DECREF(iter->dawg);
+	PyObject_Del(self);
+	Py_DECREF(type);
+}
+
+
+static PyObject*
+succinctiter_iter(PyObject* self) {
+	Py_INCREF(self);
+	return self;
+}
+
+
+static PyObject*
+succinctiter_next(PyObject* self) {
+	if (UNLIKELY(not iter->started)) {
+		iter->started = true;
+		if (iter->top > 0 and DAWG_succinct_eow(&succinct, 0))
+			goto output;
+	}
+
+	// DFS, edges are visited in order of letters
+	while (iter->top > 0) {
+		SuccinctDAWGIteratorItem* item = &iter->stack[iter->top - 1];
+		if (item->edge == item->end) {
+			iter->top -= 1;
+			continue;
+		}
+
+		const size_t edge	= item->edge++;
+		const size_t child	= DAWG_succinct_child(&succinct, edge);
+		const DAWGSuccinctRange range = DAWG_succinct_edges(&succinct, child);
+
+		ASSERT(iter->top <= succinct.longest_word);
+		iter->buffer[iter->top - 1] = DAWG_succinct_letter(&succinct, edge);
+
+		item = &iter->stack[iter->top++];
+		item->node	= child;
+		item->edge	= range.first;
+		item->end	= range.end;
+
+		if (DAWG_succinct_eow(&succinct, child))
+			goto output;
+	}
+
+	return NULL; /* Stop iteration */
+
+output:
+	return pymod_make_string(iter->buffer, iter->top - 1);
+}
+
+#undef succinct
+#undef iter
+
+
+#define method(name, kind) {#name, succinctmeth_##name, kind, succinctmeth_##name##_doc}
+static
+PyMethodDef succinct_dawg_methods[] = {
+	method(exists,				METH_O),
+	method(match,				METH_O),
+	method(longest_prefix,		METH_O),
+	method(words,				METH_NOARGS),
+
+#ifdef DAWG_PERFECT_HASHING
+	method(word2index,			METH_O),
+	method(index2word,			METH_O),
+#endif
+
+	method(bindump,				METH_NOARGS),
+	method(__reduce__,			METH_NOARGS),
+
+	method(get_stats,			METH_NOARGS),
+
+	{NULL, NULL, 0, NULL}
+};
+#undef method
+
+
+static
+PyType_Slot succinct_dawg_type_slots[] = {
+	{Py_tp_dealloc,		succinctobj_del},
+	{Py_tp_iter,		succinctmeth_iterator},
+	{Py_tp_methods,		succinct_dawg_methods},
+	{Py_tp_new,			succinctobj_new},
+	{Py_sq_length,		succinctmeth_len},
+	{Py_sq_contains,	succinctmeth_contains},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec succinct_dawg_type_spec = {
+	"pydawg.SuccinctDAWG",
+	sizeof(SuccinctDAWGclass),
+	0,
+	Py_TPFLAGS_DEFAULT,
+	succinct_dawg_type_slots
+};
+
+
+static
+PyType_Slot succinct_dawg_iterator_type_slots[] = {
+	{Py_tp_dealloc,		succinctiter_del},
+	{Py_tp_iter,		succinctiter_iter},
+	{Py_tp_iternext,	succinctiter_next},
+	{0, NULL}
+};
+
+
+static
+PyType_Spec succinct_dawg_iterator_type_spec = {
+	"pydawg.SuccinctDAWGIterator",
+	sizeof(SuccinctDAWGIterator),
+	0,
+	Py_TPFLAGS_DEFAULT | DAWG_TPFLAGS_NO_NEW,
+	succinct_dawg_iterator_type_slots
+};
@@ -0,0 +1,42 @@
+/*
+	This is part of pydawg Python module.
+
+	Declaration of Python class SuccinctDAWG -- read-only
+	succinct representation of closed DAWG.
+	(wrapper for functions from dawg_succinct.{c,h})
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef succinctdawgclass_h_included__
+#define succinctdawgclass_h_included__
+
+#include "dawg_succinct.h"
+
+typedef struct SuccinctDAWGclass {
+	PyObject_HEAD
+
+	DAWGSuccinct succinct;	///< succinct data
+} SuccinctDAWGclass;
+
+
+typedef struct SuccinctDAWGIteratorItem {
+	size_t	node;	///< node
+	size_t	edge;	///< next edge to visit
+	size_t	end;	///< past the last edge of node
+} SuccinctDAWGIteratorItem;
+
+
+typedef struct SuccinctDAWGIterator {
+	PyObject_HEAD
+
+	SuccinctDAWGclass* dawg;			///< SuccinctDAWG
+	SuccinctDAWGIteratorItem* stack;	///< path from root, longest_word + 1 items
+	size_t	top;						///< number of items on stack
+	DAWG_LETTER_TYPE* buffer;			///< string buffer
+	bool	started;					///< empty word has been checked
+} SuccinctDAWGIterator;
+
+#endif
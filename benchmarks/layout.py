@@ -0,0 +1,119 @@
+"""
+	This is part of pydawg Python module.
+
+	Benchmark of node layout: lookup throughput and LLC misses
+	of a DAWG closed with LAYOUT_NONE (nodes left in allocation
+	order) and LAYOUT_BFS. Both are built from words, an image
+	wouldn't do: binload places nodes in BFS order anyway.
+
+	Usage: python3 benchmarks/layout.py [words count] [queries count]
+
+	LLC misses are counted with ``perf stat`` when it's available;
+	counters of building alone are subtracted from counters of
+	building followed by lookups.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+"""
+
+import os
+import sys
+import time
+import random
+import shutil
+import subprocess
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), '..'))
+import pydawg
+
+
+ALPHABET = "abcdefghijklmnopqrstuvwxyz"
+SEED     = 42
+
+
+def conv(word):
+	if pydawg.unicode:
+		return word
+	else:
+		return bytes(word, 'ascii')
+
+
+def random_words(count, seed):
+	rnd = random.Random(seed)
+	return [conv(''.join(rnd.choice(ALPHABET) for _ in range(rnd.randint(4, 16)))) for _ in range(count)]
+
+
+def build(words_count, layout):
+	D = pydawg.DAWG()
+	for word in sorted(set(random_words(words_count, SEED))):
+		D.add_word_unchecked(word)
+
+	D.close(layout)
+	return D
+
+
+def lookup(D, queries):
+	return sum(map(D.exists, queries))
+
+
+def run(words_count, layout, queries_count, mode):
+	"subprocess body: build and optionally do lookups"
+	D = build(words_count, layout)
+	if mode == 'lookup':
+		queries = random_words(queries_count, SEED + 1)
+		lookup(D, queries)
+
+
+def perf_counters(words_count, layout, queries_count, mode):
+	events = 'LLC-loads,LLC-load-misses'
+	cmd = ['perf', 'stat', '-x,', '-e', events,
+	       sys.executable, __file__, '--run', str(words_count), str(layout), str(queries_count), mode]
+
+	res = subprocess.run(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, universal_newlines=True)
+	counters = {}
+	for line in res.stderr.splitlines():
+		fields = line.split(',')
+		if len(fields) > 2 and fields[2] in events.split(','):
+			try:
+				counters[fields[2]] = int(fields[0])
+			except ValueError:
+				return None # counter not supported
+
+	return counters if len(counters) == 2 else None
+
+
+def main(words_count, queries_count):
+	queries = random_words(queries_count, SEED + 1)
+	has_perf = shutil.which('perf') is not None
+	for name, layout in [('LAYOUT_NONE', pydawg.LAYOUT_NONE), ('LAYOUT_BFS', pydawg.LAYOUT_BFS)]:
+		print("building DAWG of %d words..." % words_count)
+		D = build(words_count, layout)
+		print("graph size: %0.1f MB" % (D.get_stats()['graph_size'] / 2**20))
+		lookup(D, queries[:1000]) # warm-up
+
+		t1 = time.time()
+		lookup(D, queries)
+		t2 = time.time()
+		del D
+
+		print("%-12s: %8.0f lookups/s" % (name, queries_count / (t2 - t1)), end='')
+		if has_perf:
+			base = perf_counters(words_count, layout, queries_count, 'build')
+			full = perf_counters(words_count, layout, queries_count, 'lookup')
+			if base and full:
+				loads  = full['LLC-loads'] - base['LLC-loads']
+				misses = full['LLC-load-misses'] - base['LLC-load-misses']
+				print(", LLC loads %d, LLC misses %d (%0.2f per lookup)" % (loads, misses, misses / queries_count), end='')
+			else:
+				print(", LLC counters not supported", end='')
+		print()
+
+
+if __name__ == '__main__':
+	if len(sys.argv) > 1 and sys.argv[1] == '--run':
+		run(int(sys.argv[2]), int(sys.argv[3]), int(sys.argv[4]), sys.argv[5])
+	else:
+		words_count   = int(sys.argv[1]) if len(sys.argv) > 1 else 2000000
+		queries_count = int(sys.argv[2]) if len(sys.argv) > 2 else 1000000
+		main(words_count, queries_count)
@@ -17,16 +17,19 @@
 #include <iso646.h>
 
 // setup supported character set
-#ifdef DAWG_UNICODE
-#	ifdef Py_UNICODE_WIDE
-		// Python use UCS-4
-#		define DAWG_LETTER_TYPE	Py_UNICODE
-#		define DAWG_LETTER_SIZE 4
-#	else
-		// Python use UCS-2
-#		define DAWG_LETTER_TYPE	Py_UNICODE
-#		define DAWG_LETTER_SIZE 2
+#if defined(DAWG_UTF8)
+	// unicode strings are saved as UTF-8 sequences
+#	ifndef DAWG_UNICODE
+#		define DAWG_UNICODE
 #	endif
+#	define DAWG_LETTER_TYPE	uint8_t
+#	define DAWG_LETTER_SIZE 1
+#elif defined(DAWG_UNICODE)
+	// letters are code points; lookups accept also narrow
+	// PEP 393 kinds of strings (see dawg_lookup.c)
+#	define DAWG_LETTER_TYPE	Py_UCS4
+#	define DAWG_LETTER_SIZE 4
+#	define DAWG_LOOKUP_KINDS
 #else
 	// only bytes are supported
 #	define DAWG_LETTER_TYPE	uint8_t
@@ -47,6 +50,29 @@
 #	define	UNUSED
 #endif
 
+#ifdef __GNUC__
+#	define	POPCOUNT64(x)	__builtin_popcountll(x)
+#	define	CTZ64(x)		__builtin_ctzll(x)
+#else
+	static inline int POPCOUNT64(uint64_t x) {
+		int n = 0;
+		while (x) {
+			x &= x - 1;
+			n += 1;
+		}
+		return n;
+	}
+
+	static inline int CTZ64(uint64_t x) {
+		int n = 0;
+		while ((x & 1) == 0) {
+			x >>= 1;
+			n += 1;
+		}
+		return n;
+	}
+#endif
+
 #ifdef DEBUG
 #	include <assert.h>
 #	define	ASSERT(expr)	do {if (!(expr)) {printf("%s:%s:%d - '%s' failed!\n", __FILE__, __FUNCTION__, __LINE__, #expr); abort();} }while(0)
@@ -64,6 +90,10 @@
 #	error "Can't obtain the pointer size"
 #endif
 
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#	define	DAWG_BIG_ENDIAN
+#endif
+
 #if PYDAWG_POINTER_SIZE == 4
 #	define	MACHINE32BIT
 typedef uint32_t nodeid_t;
@@ -100,9 +130,16 @@ void *memcalloc(size_t nmemb, size_t size) {
     return addr;
 }
 
+void* memrealloc(void* addr, size_t size) {
+    void* new = PyMem_Realloc(addr, size);
+    printf("realloc %p -> %p %u\n", addr, new, size);
+    return new;
+}
+
 #else
 #   define memalloc PyMem_Malloc
 #   define memfree  PyMem_Free
+#   define memrealloc PyMem_Realloc
 #   if PY_VERSION_HEX >=  0x03050000
 #     define memcalloc	PyMem_Calloc
 #   else
@@ -114,10 +151,20 @@ void *memcalloc(size_t nmemb, size_t size) {
 #   endif
 #endif
 
-#if defined(_WIN32) || defined(_WIN64)
-#   define PY_OBJECT_HEAD_INIT PyVarObject_HEAD_INIT(NULL, 0)
+// iterators are created only by methods of their DAWGs
+#ifdef Py_TPFLAGS_DISALLOW_INSTANTIATION
+#	define DAWG_TPFLAGS_NO_NEW Py_TPFLAGS_DISALLOW_INSTANTIATION
 #else
-#   define PY_OBJECT_HEAD_INIT PyVarObject_HEAD_INIT(&PyType_Type, 0)
+#	define DAWG_TPFLAGS_NO_NEW 0
+#endif
+
+#if !defined(_WIN32) && !defined(_WIN64)
+	// file descriptors, memory mapped files
+#	define DAWG_POSIX
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
 #endif
 
 #ifndef __cplusplus
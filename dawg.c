@@ -26,7 +26,13 @@ DAWG_init(DAWG* dawg) {
 	dawg->count	= 0;
 	dawg->state	= EMPTY;
 	dawg->longest_word = 0;
-	dawg->visited_marker = 1;
+	dawg->nodes	= NULL;
+	dawg->edges	= NULL;
+	dawg->nodes_count = 0;
+	dawg->profile	= NULL;
+	dawg->summary	= NULL;
+	DAWG_alphabet_init(&dawg->alphabet);
+	DAWG_jump_init(&dawg->jump);
 
 	hashtable_init(&dawg->reg, 101);
 
@@ -185,6 +191,13 @@ DAWG_close(DAWG* dawg) {
 			dawg->prev_word.length	= 0;
 		}
 		dawg->state = CLOSED;
+
+		// alphabet is an optional filter, lack of memory is not an error;
+		// DAWG closed again already has it
+		DAWGAlphabet alphabet;
+		if (dawg->alphabet.letters == NULL and DAWG_get_alphabet(dawg, &alphabet) == DAWG_OK)
+			dawg->alphabet = alphabet;
+
 		return 1;
 	}
 	else
@@ -387,27 +400,45 @@ DAWG_clear_aux(DAWGNode* node, UNUSED const size_t depth, void* extra) {
 
 static int
 DAWG_clear(DAWG* dawg) {
+	DAWG_profile_stop(dawg);
 
 	// Delete all nodes
-	if(dawg->q0) {
+	if (dawg->nodes) {
+		memfree(dawg->nodes);
+		if (dawg->edges)
+			memfree(dawg->edges);
+
+		dawg->nodes = NULL;
+		dawg->edges = NULL;
+		dawg->nodes_count = 0;
+	}
+	else if(dawg->q0) {
 		DAWGStatistics stats;
 		DAWGNode **aux;
 		DAWGNode **aux_copy;
 		size_t i;
 		// Find how many nodes
-		DAWG_get_stats(dawg, &stats);
+		if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+			return DAWG_NO_MEM;
 		// Get the list of pointers to each node
 		aux = memcalloc(stats.nodes_count, sizeof(DAWGNode *));
 		if(aux==NULL)
 			return DAWG_NO_MEM;
 		aux_copy = aux;
-		DAWG_traverse_DFS_once(dawg, DAWG_clear_aux, &aux_copy);
+		if (DAWG_traverse_DFS_once(dawg, DAWG_clear_aux, &aux_copy) < 0) {
+			memfree(aux);
+			return DAWG_NO_MEM;
+		}
 		// Go over the list and free all nodes
 		for(i=0; i<stats.nodes_count; i++)
-			memfree( aux[i] );
+			dawgnode_free( aux[i] );
 		memfree(aux);
 	}
 
+	DAWG_alphabet_free(&dawg->alphabet);
+	DAWG_jump_free(&dawg->jump);
+	DAWG_summary_free(dawg);
+
 	// Clear the main structure
 	dawg->q0	= NULL;
 	dawg->count	= 0;
@@ -455,29 +486,155 @@ DAWG_traverse_DFS(DAWG* dawg, DAWG_traverse_callback callback, void* extra) {
 }
 
 
-void
-DAWG_traverse_clear_visited(DAWGNode* node) {
-	node->visited = 0;
+/*
+	Set of visited nodes. Traversals don't mark nodes, thus reading
+	a graph never writes to memory of nodes (pages of DAWG shared
+	with forked processes stay shared).
 
-	int i;
-	for (i=0; i < node->n; i++)
-		DAWG_traverse_clear_visited(node->next[i].child);
+	If nodes are placed in a continuous block (see DAWG_relayout)
+	node is identified by its index and a bitmap is used; otherwise
+	addresses of nodes are kept in an open addressing hash set.
+*/
+typedef struct DAWGVisited {
+	DAWGNode*	base;		///< nodes block or NULL
+	uint64_t*	bitmap;		///< bit per node of block
+
+	DAWGNode**	table;		///< hash set of nodes
+	size_t		size;		///< size of table (power of two)
+	size_t		count;		///< number of nodes in table
+	int			shift;		///< hash(node) >> shift is a slot index
+} DAWGVisited;
+
+
+#define VISITED_INITIAL_BITS	10
+
+
+static int
+visited_init(DAWG* dawg, DAWGVisited* visited) {
+	visited->base	= dawg->nodes;
+	visited->bitmap	= NULL;
+	visited->table	= NULL;
+	visited->count	= 0;
+	visited->size	= 0;
+	visited->shift	= 0;
+
+	if (visited->base) {
+		visited->bitmap = memcalloc(dawg->nodes_count/64 + 1, sizeof(uint64_t));
+		if (visited->bitmap == NULL)
+			return DAWG_NO_MEM;
+	}
+	else {
+		visited->size	= (size_t)1 << VISITED_INITIAL_BITS;
+		visited->shift	= 64 - VISITED_INITIAL_BITS;
+		visited->table	= memcalloc(visited->size, sizeof(DAWGNode*));
+		if (visited->table == NULL)
+			return DAWG_NO_MEM;
+	}
+
+	return DAWG_OK;
 }
 
 
-int
-DAWG_traverse_DFS_once_aux(DAWGNode* node, const size_t depth, const uint16_t visited, DAWG_traverse_callback callback, void* extra) {
-	if (node->visited != visited) {
-		node->visited = visited;
-		int i;
-		for (i=0; i < node->n; i++)
-			if (DAWG_traverse_DFS_once_aux(node->next[i].child, depth + 1, visited, callback, extra) == 0)
-				return 0;
+static void
+visited_free(DAWGVisited* visited) {
+	if (visited->bitmap)
+		memfree(visited->bitmap);
+
+	if (visited->table)
+		memfree(visited->table);
+}
+
+
+static size_t PURE
+visited_slot(const DAWGVisited* visited, const DAWGNode* node) {
+	// Fibonacci hashing
+	return (size_t)(((uint64_t)(uintptr_t)node * UINT64_C(0x9e3779b97f4a7c15)) >> visited->shift);
+}
+
 
-		return callback(node, depth, extra);
+static void
+visited_insert(DAWGVisited* visited, DAWGNode* node) {
+	const size_t mask = visited->size - 1;
+	size_t i = visited_slot(visited, node);
+	while (visited->table[i])
+		i = (i + 1) & mask;
+
+	visited->table[i] = node;
+	visited->count += 1;
+}
+
+
+static int
+visited_grow(DAWGVisited* visited) {
+	DAWGNode** old = visited->table;
+	const size_t size = visited->size;
+	size_t i;
+
+	visited->table = memcalloc(2 * size, sizeof(DAWGNode*));
+	if (visited->table == NULL) {
+		visited->table = old;
+		return DAWG_NO_MEM;
 	}
-	else
+
+	visited->size	= 2 * size;
+	visited->shift	-= 1;
+	visited->count	= 0;
+	for (i=0; i < size; i++)
+		if (old[i])
+			visited_insert(visited, old[i]);
+
+	memfree(old);
+	return DAWG_OK;
+}
+
+
+/* returns 1 if node is added, 0 if it was visited before, or DAWG_NO_MEM */
+static int
+visited_add(DAWGVisited* visited, DAWGNode* node) {
+	if (visited->base) {
+		const size_t id = (size_t)(node - visited->base);
+		const uint64_t bit = UINT64_C(1) << (id % 64);
+		if (visited->bitmap[id / 64] & bit)
+			return 0;
+
+		visited->bitmap[id / 64] |= bit;
+		return 1;
+	}
+	else {
+		const size_t mask = visited->size - 1;
+		size_t i = visited_slot(visited, node);
+		while (visited->table[i]) {
+			if (visited->table[i] == node)
+				return 0;
+
+			i = (i + 1) & mask;
+		}
+
+		if (2 * (visited->count + 1) > visited->size) {
+			if (visited_grow(visited) != DAWG_OK)
+				return DAWG_NO_MEM;
+		}
+
+		visited_insert(visited, node);
 		return 1;
+	}
+}
+
+
+static int
+DAWG_traverse_DFS_once_aux(DAWGNode* node, const size_t depth, DAWGVisited* visited, DAWG_traverse_callback callback, void* extra) {
+	const int added = visited_add(visited, node);
+	if (added <= 0)
+		return (added == 0) ? 1 : added;
+
+	int i;
+	for (i=0; i < node->n; i++) {
+		const int result = DAWG_traverse_DFS_once_aux(node->next[i].child, depth + 1, visited, callback, extra);
+		if (result <= 0)
+			return result;
+	}
+
+	return callback(node, depth, extra);
 }
 
 
@@ -487,22 +644,206 @@ DAWG_traverse_DFS_once(DAWG* dawg, DAWG_traverse_callback callback, void* extra)
 	ASSERT(callback);
 
 	if (dawg->q0) {
-		if (dawg->visited_marker == 0) {
-			// counter wrapped, visited fields have to be cleared
-			//puts("cleared");
-			DAWG_traverse_clear_visited(dawg->q0);
-			dawg->visited_marker += 1;
-		}
+		DAWGVisited visited;
+		if (visited_init(dawg, &visited) != DAWG_OK)
+			return DAWG_NO_MEM;
 
-		const int ret = DAWG_traverse_DFS_once_aux(dawg->q0, 0, dawg->visited_marker, callback, extra);
-		dawg->visited_marker += 1;
-		return ret;
+		const int result = DAWG_traverse_DFS_once_aux(dawg->q0, 0, &visited, callback, extra);
+		visited_free(&visited);
+		return result;
 	}
 	else
 		return 1;
 }
 
 
+static int
+DAWG_get_nodes_BFS(DAWG* dawg, DAWGNode** nodes) {
+	ASSERT(dawg);
+	ASSERT(nodes);
+
+	if (dawg->q0 == NULL)
+		return DAWG_OK;
+
+	DAWGVisited visited;
+	if (visited_init(dawg, &visited) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	// nodes array serves as a queue
+	size_t head = 0;
+	size_t tail = 0;
+	size_t i;
+	int result = DAWG_OK;
+
+	visited_add(&visited, dawg->q0);
+	nodes[tail++] = dawg->q0;
+	while (head < tail) {
+		DAWGNode* node = nodes[head++];
+		for (i=0; i < node->n; i++) {
+			DAWGNode* child = node->next[i].child;
+			const int added = visited_add(&visited, child);
+			if (added > 0)
+				nodes[tail++] = child;
+			else if (added < 0) {
+				result = DAWG_NO_MEM;
+				goto finish;
+			}
+		}
+	}
+
+finish:
+	visited_free(&visited);
+	return result;
+}
+
+
+/*	checks if nodes block is in BFS order (e.g. loaded from image);
+	then nodes discovered by BFS are exactly the next ones in block,
+	thus block serves as a queue and no visited set is needed */
+static bool PURE
+DAWG_is_BFS_placed(const DAWG* dawg) {
+	size_t head, tail;
+	size_t i;
+
+	if (dawg->nodes == NULL or dawg->q0 != dawg->nodes)
+		return false;
+
+	tail = 1;
+	for (head=0; head < tail; head++) {
+		const DAWGNode* node = &dawg->nodes[head];
+		for (i=0; i < node->n; i++) {
+			const size_t index = node->next[i].child - dawg->nodes;
+			if (index == tail)
+				tail += 1;
+			else if (index > tail)
+				return false;
+		}
+	}
+
+	// there are no unreachable nodes
+	return tail == dawg->nodes_count;
+}
+
+
+static int
+DAWG_relayout(DAWG* dawg, DAWGNode** order, const size_t count) {
+	ASSERT(dawg);
+	ASSERT(order);
+
+	if (dawg->state != CLOSED)
+		return DAWG_NOT_CLOSED;
+
+	// counts and summaries are indexed by position of node
+	DAWG_profile_stop(dawg);
+	DAWG_summary_free(dawg);
+
+	size_t i;
+	size_t edges_count = 0;
+	for (i=0; i < count; i++)
+		edges_count += order[i]->n;
+
+	DAWGNode* nodes = memalloc(count * sizeof(DAWGNode));
+	DAWGEdge* edges = NULL;
+	if (edges_count > 0)
+		edges = memalloc(edges_count * sizeof(DAWGEdge));
+
+	if (nodes == NULL or (edges_count > 0 and edges == NULL)) {
+		if (nodes)
+			memfree(nodes);
+
+		return DAWG_NO_MEM;
+	}
+
+	// 1. copy nodes and edges; old node's field next
+	//    keeps then the new address of node
+	DAWGEdge* edge = edges;
+	for (i=0; i < count; i++) {
+		DAWGNode* old = order[i];
+
+		nodes[i] = *old;
+		if (old->n > 0) {
+			memcpy(edge, old->next, old->n * sizeof(DAWGEdge));
+			nodes[i].next = edge;
+			edge += old->n;
+		}
+		else
+			nodes[i].next = NULL;
+
+		if (dawg->nodes == NULL and old->next)
+			memfree(old->next);
+
+		old->next = (DAWGEdge*)&nodes[i];
+	}
+
+#define new_address(node) ((DAWGNode*)((node)->next))
+	// 2. update edges
+	for (i=0; i < edges_count; i++)
+		edges[i].child = new_address(edges[i].child);
+
+	dawg->q0 = new_address(dawg->q0);
+	for (i=0; i < dawg->jump.size; i++)
+		if (dawg->jump.nodes[i])
+			dawg->jump.nodes[i] = new_address(dawg->jump.nodes[i]);
+#undef new_address
+
+	// 3. free old nodes
+	if (dawg->nodes) {
+		memfree(dawg->nodes);
+		if (dawg->edges)
+			memfree(dawg->edges);
+	}
+	else {
+		for (i=0; i < count; i++)
+			memfree(order[i]);
+	}
+
+	dawg->nodes = nodes;
+	dawg->edges = edges;
+	dawg->nodes_count = count;
+
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_set_layout(DAWG* dawg, const DAWGLayout layout) {
+	ASSERT(dawg);
+
+	DAWGStatistics stats;
+	DAWGNode** order;
+	int result;
+
+	switch (layout) {
+		case LAYOUT_NONE:
+			return DAWG_OK;
+
+		case LAYOUT_BFS:
+			if (dawg->state != CLOSED)
+				return DAWG_NOT_CLOSED;
+
+			if (DAWG_is_BFS_placed(dawg))
+				return DAWG_OK;
+
+			if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+				return DAWG_NO_MEM;
+
+			order = memalloc(stats.nodes_count * sizeof(DAWGNode*));
+			if (order == NULL)
+				return DAWG_NO_MEM;
+
+			result = DAWG_get_nodes_BFS(dawg, order);
+			if (result == DAWG_OK)
+				result = DAWG_relayout(dawg, order, stats.nodes_count);
+			memfree(order);
+			return result;
+
+		default:
+			ASSERT(0);
+			return DAWG_OK;
+	}
+}
+
+
 int
 DAWG_get_stats_aux(DAWGNode* node, UNUSED const size_t depth, UNUSED void* extra) {
 #define stats ((DAWGStatistics*)extra)
@@ -514,7 +855,7 @@ DAWG_get_stats_aux(DAWGNode* node, UNUSED const size_t depth, UNUSED void* extra
 }
 
 
-static void 
+static int
 DAWG_get_stats(DAWG* dawg, DAWGStatistics* stats) {
 	ASSERT(dawg);
 	ASSERT(stats);
@@ -526,8 +867,13 @@ DAWG_get_stats(DAWG* dawg, DAWGStatistics* stats) {
 	stats->sizeof_node	= sizeof(DAWGNode);
 	stats->sizeof_edge	= sizeof(DAWGEdge);
 	stats->graph_size	= 0;
+	stats->jump_depth	= dawg->jump.depth;
+	stats->jump_size	= dawg->jump.size * sizeof(DAWGNode*);
 
-	DAWG_traverse_DFS_once(dawg, DAWG_get_stats_aux, stats);
+	if (DAWG_traverse_DFS_once(dawg, DAWG_get_stats_aux, stats) < 0)
+		return DAWG_NO_MEM;
+	else
+		return DAWG_OK;
 }
 
 
@@ -543,46 +889,31 @@ DAWG_get_hash_stats(DAWG* dawg, DAWGHashStatistics* stats) {
 }
 
 
-static bool PURE
-DAWG_exists(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
-    ASSERT(dawg);
-
-    size_t i=0;
-    DAWGNode* node = dawg->q0;
-
-    for (/**/; i < wordlen; i++) {
-        node = dawgnode_get_child(node, word[i]);
-        if (node == NULL) {
-            return false;
-        }
-    }
-
-    return node->eow;
-}
-
-
-static size_t PURE
-DAWG_longest_prefix(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
-    ASSERT(dawg);
-
-    DAWGNode* node = dawg->q0;
-    size_t i=0;
-    for (/**/; i < wordlen; i++) {
-        node = dawgnode_get_child(node, word[i]);
-        if (node == NULL) {
-            break;
-        }
-    }
-
-    return i;
-}
-
-
-static bool PURE
-DAWG_match(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
-	return DAWG_longest_prefix(dawg, word, wordlen) > 0;
-}
-
-
+#include "dawg_alphabet.c"
+#include "dawg_jump.c"
+#include "dawg_summary.c"
 #include "dawg_pickle.c"
 #include "dawg_mph.c"
+#include "dawg_da.c"
+#include "dawg_succinct.c"
+#include "dawg_compact.c"
+#include "dawg_shared.c"
+#include "dawg_kmer.c"
+#include "dawg_ints.c"
+#include "dawg_profile.c"
+
+// lookups of words made of DAWG letters
+#define LOOKUP_CHAR_TYPE	DAWG_LETTER_TYPE
+#define LOOKUP_NAME(name)	name
+#include "dawg_lookup.c"
+
+#ifdef DAWG_LOOKUP_KINDS
+// lookups of str objects of narrow kinds
+#	define LOOKUP_CHAR_TYPE		Py_UCS1
+#	define LOOKUP_NAME(name)	name##_ucs1
+#	include "dawg_lookup.c"
+
+#	define LOOKUP_CHAR_TYPE		Py_UCS2
+#	define LOOKUP_NAME(name)	name##_ucs2
+#	include "dawg_lookup.c"
+#endif
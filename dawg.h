@@ -13,6 +13,9 @@
 
 #include "common.h"
 #include "dawgnode.h"
+#include "dawg_alphabet.h"
+#include "dawg_jump.h"
+#include "dawg_summary.h"
 
 #define	DAWG_OK 		(0)
 #define DAWG_EXISTS		(1)
@@ -20,6 +23,10 @@
 #define DAWG_NO_MEM		(-1)
 #define DAWG_WORD_LESS	(-2)
 #define DAWG_FROZEN		(-3)
+#define DAWG_NOT_CLOSED	(-4)
+#define DAWG_TOO_BIG	(-5)
+#define DAWG_PROFILE_MISMATCH	(-6)
+#define DAWG_WRITE_FAILED	(-7)
 
 #define DAWG_DUMP_TRUNCATED			(-100)
 #define DAWG_DUMP_INVALID_MAGICK	(-101)
@@ -27,6 +34,10 @@
 #define DAWG_DUMP_INVALID_ROOT_ID	(-103)
 #define DAWG_DUMP_CORRUPTED_1		(-104)
 #define DAWG_DUMP_CORRUPTED_2		(-105)
+#define DAWG_DUMP_INVALID_ALPHABET	(-106)
+#define DAWG_DUMP_INCOMPATIBLE		(-107)
+#define DAWG_DUMP_INVALID_NUMBERS	(-108)
+#define DAWG_DUMP_INVALID_GRAPH		(-109)
 
 
 static bool PURE
@@ -61,6 +72,17 @@ typedef struct String {
 } String;
 
 
+#define DAWG_INT_MAX_WIDTH	8
+
+/* array of fixed width integer keys (see dawg_ints.c) */
+typedef struct DAWGIntArray {
+	const void*	data;
+	size_t	count;		///< number of keys
+	size_t	itemsize;	///< 1 - keys are big-endian byte strings; 2, 4, 8 - native integers
+	size_t	width;		///< width of key in bytes (1 .. DAWG_INT_MAX_WIDTH)
+} DAWGIntArray;
+
+
 typedef enum {
 	EMPTY,
 	ACTIVE,
@@ -68,6 +90,18 @@ typedef enum {
 } DAWGState;
 
 
+typedef enum {
+	LAYOUT_NONE,		///< nodes are kept where they have been allocated
+	LAYOUT_BFS			///< nodes are placed in breadth-first order
+} DAWGLayout;
+
+
+typedef enum {
+	COMPRESSION_NONE,	///< fixed size fields
+	COMPRESSION_VARINT	///< ids implied by order, variable length counts and children
+} DAWGCompression;
+
+
 typedef struct DAWGStatistics {
 	size_t	nodes_count;
 	size_t	edges_count;
@@ -77,6 +111,9 @@ typedef struct DAWGStatistics {
 	size_t	sizeof_node;
 	size_t	sizeof_edge;
 	size_t	graph_size;
+
+	size_t	jump_depth;		///< letters resolved by jump table
+	size_t	jump_size;		///< size of jump table (in bytes)
 } DAWGStatistics;
 
 
@@ -93,10 +130,18 @@ typedef struct DAWG {
 	uint64_t	count;			///< number of distinct words
 	uint64_t	longest_word;	///< length of the longest word (useful when iterating through words, cheap to keep up to date)
 	DAWGState	state;			///< DAWG state
-	uint16_t	visited_marker;	///< visited marker (used by DAWG_traverse_DFS_once)
 
 	HashTable	reg;			///< registry -- valid states
 	String		prev_word;		///< previosuly added word
+
+	DAWGNode*	nodes;			///< nodes block (see DAWG_relayout), NULL if nodes are allocated separately
+	DAWGEdge*	edges;			///< edges block (see DAWG_relayout)
+	size_t		nodes_count;	///< number of nodes in nodes block
+	uint64_t*	profile;		///< visits of nodes from nodes block, NULL if profiling is off (see dawg_profile.c)
+
+	DAWGAlphabet alphabet;		///< letters used by closed DAWG, words with other letters are rejected up front
+	DAWGJump	jump;			///< nodes reached by the first letters, built on request for closed DAWG
+	DAWGSummary* summary;		///< summaries of subgraphs, indexed like nodes block, NULL if not available (see dawg_summary.c)
 } DAWG;
 
 
@@ -141,14 +186,40 @@ DAWG_traverse_DFS(DAWG* dawg, DAWG_traverse_callback callback, void* extra);
 
 
 /* traverse in DFS order, nodes are visited exactly once
-   callback is called after visiting children
+   callback is called after visiting children;
+   nodes are not modified (visited ones are kept in a side set),
+   returns DAWG_NO_MEM if the set can't be allocated
  */
 static int
 DAWG_traverse_DFS_once(DAWG* dawg, DAWG_traverse_callback callback, void* extra);
 
 
-/* calculate some graph statistics */
-static void
+/* saves nodes in BFS order, array have to be big enough to store all nodes;
+   returns DAWG_OK or DAWG_NO_MEM
+ */
+static int
+DAWG_get_nodes_BFS(DAWG* dawg, DAWGNode** nodes);
+
+
+/**	Move nodes to continuous memory blocks, nodes are placed in given order.
+	DAWG have to be closed.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+*/
+static int
+DAWG_relayout(DAWG* dawg, DAWGNode** order, const size_t count);
+
+
+/* place nodes according to layout type; see DAWG_relayout */
+static int
+DAWG_set_layout(DAWG* dawg, const DAWGLayout layout);
+
+
+/* calculate some graph statistics, returns DAWG_OK or DAWG_NO_MEM */
+static int
 DAWG_get_stats(DAWG* dawg, DAWGStatistics* stats);
 
 
@@ -167,10 +238,151 @@ static size_t PURE
 DAWG_longest_prefix(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen);
 
 
+/**	Build jump table resolving first depth letters (0 removes table);
+	depth is decreased if table would have more than DAWG_JUMP_MAX_SIZE
+	entries. DAWG have to be closed, otherwise table is not built.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_jump_build(DAWG* dawg, int depth);
+
+
+/**	Compute summaries of subgraphs; nodes have to be placed in
+	a block and alphabet has to be known, otherwise summaries are
+	not available. Summaries are built on first use (by find_all)
+	and dropped when nodes are moved.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_summary_build(DAWG* dawg);
+
+
+/* free summaries */
+static void
+DAWG_summary_free(DAWG* dawg);
+
+
+/* summary of subgraph rooted at node, NULL if not available */
+static const DAWGSummary* PURE
+DAWG_summary_get(const DAWG* dawg, const DAWGNode* node);
+
+
+/* like DAWG_exists, counts visited nodes; profiling has to be on */
+static bool
+DAWG_profile_exists(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* like DAWG_longest_prefix, counts visited nodes; profiling has to be on */
+static size_t
+DAWG_profile_longest_prefix(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/**	Start counting visits of nodes, previous counts are discarded.
+	Nodes have to be placed in a block (see DAWG_relayout).
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+*/
+static int
+DAWG_profile_start(DAWG* dawg);
+
+
+/* stop counting visits of nodes */
+static void
+DAWG_profile_stop(DAWG* dawg);
+
+
+/* count visit of node, if profiling is on */
+static void
+DAWG_profile_visit(DAWG* dawg, const DAWGNode* node);
+
+
+/**	Save counts of visits, nodes are in BFS order and each count
+	is 8-byte little-endian integer; profiling has to be on.
+
+	@param[out]	array		array of 8 * nodes_count bytes,
+							have to be freed manually
+	@param[out]	size		size of array
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_profile_save(DAWG* dawg, uint8_t** array, size_t* size);
+
+
+/**	Place nodes in order of decreasing counts of visits from
+	given profile (see DAWG_profile_save), nodes never visited
+	are placed at the end in BFS order. Stops profiling.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+		DAWG_PROFILE_MISMATCH - profile was made for a different graph
+*/
+static int
+DAWG_profile_relayout(DAWG* dawg, const uint8_t* array, const size_t size);
+
+
+/**	Add integer keys, keys have to be sorted.
+
+	@param[out]	processed	number of keys processed before an error
+	@param[out]	added		number of new words
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_FROZEN
+		DAWG_WORD_LESS
+		DAWG_TOO_BIG - key doesn't fit in width bytes
+*/
+static int
+DAWG_add_ints(DAWG* dawg, const DAWGIntArray* keys, size_t* processed, size_t* added);
+
+
+/* result[i] = 1 if i-th key exists in DAWG */
+static void
+DAWG_exists_ints(DAWG* dawg, const DAWGIntArray* keys, uint8_t* result);
+
+
+/**	Find keys of given width in range lo..hi (inclusive).
+	Function is called without GIL, memory is taken from raw allocator.
+
+	@param[out]	keys		array of keys in increasing order, NULL
+							if no key was found; have to be freed
+							with PyMem_RawFree
+	@param[out]	count		number of keys
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_find_ints(DAWG* dawg, const uint64_t lo, const uint64_t hi, const size_t width, uint64_t** keys, size_t* count);
+
+
+/* collect letters used by edges; closed DAWG returns copy of its alphabet */
+static int
+DAWG_get_alphabet(DAWG* dawg, DAWGAlphabet* alphabet);
+
+
 /**	Save DAWG in byte array.
 
 	@param[in]	dawg		DAWG object
 	@param[in]	stats		current statistics about DAWG
+	@param[in]	compression	format of nodes
+	@param[in]	numbers		save numbers of words reachable from nodes
+							(closed DAWG, nodes have to be numerated)
 
 	@param[out]	array		address of array containg DAWG,
 							array have to be freed manually
@@ -181,14 +393,44 @@ DAWG_longest_prefix(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordl
 		DAWG_NO_MEM
 */
 static int
-DAWG_save(DAWG* dawg, DAWGStatistics* stats, uint8_t** array, size_t* size);
+DAWG_save(DAWG* dawg, DAWGStatistics* stats, const DAWGCompression compression, const bool numbers, uint8_t** array, size_t* size);
+
+
+/* receives consecutive chunks of image; returns 0 on success */
+typedef int (*DAWGWriteFun)(const uint8_t* data, const size_t size, void* extra);
+
+#define DAWG_SAVE_CHUNK_SIZE	(1024*1024)
 
 
-/** Loads DAWG from data returned by DAWG_save.
+/** Save DAWG in the DAWG_save format, passing chunks of image
+	to write function. Chunks have at most DAWG_SAVE_CHUNK_SIZE
+	bytes, unless a single node doesn't fit. Stats have to be
+	current (nodes_count is used). Nodes block in BFS order needs
+	no other memory, otherwise nodes are numbered in BFS order
+	first (order and ids of all nodes are kept).
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_WRITE_FAILED	--- write function failed
+*/
+static int
+DAWG_save_stream(DAWG* dawg, DAWGStatistics* stats, const DAWGCompression compression, const bool numbers, DAWGWriteFun write, void* extra);
+
+
+/** Loads DAWG from data returned by DAWG_save, in any compression,
+	by any build (see dump_letters_compatible).
+
+	Nodes of closed DAWG are placed in a block, in order of image.
 
 	@param[in,out]	dawg		DAWG object
 	@param[in]		array		data
 	@param[in]		size		data size
+	@param[in]		trusted		skip checks of ids, letters and shape of graph
+								(image is still checked for truncation);
+								corrupted image leads to undefined behaviour
+	@param[out]		numbered	nodes got numbers saved in image, perfect
+								hashing doesn't need DAWG_mph_numerate_nodes
 
 	@returns
 		DAWG_OK
@@ -199,9 +441,14 @@ DAWG_save(DAWG* dawg, DAWGStatistics* stats, uint8_t** array, size_t* size);
 		DAWG_DUMP_INVALID_ROOT_ID
 		DAWG_DUMP_CORRUPTED_1
 		DAWG_DUMP_CORRUPTED_2
+		DAWG_DUMP_INVALID_ALPHABET
+		DAWG_DUMP_INCOMPATIBLE		--- letters can't be represented by this build
+		DAWG_DUMP_INVALID_NUMBERS	--- numbers of nodes don't match graph
+		DAWG_DUMP_INVALID_GRAPH		--- graph has cycles, unsorted edges or
+										doesn't match counts saved in header
 */
 static int
-DAWG_load(DAWG* dawg, uint8_t* array, size_t size);
+DAWG_load(DAWG* dawg, const uint8_t* array, const size_t size, const bool trusted, bool* numbered);
 
 
 #ifdef DAWG_PERFECT_HASHING
@@ -209,11 +456,23 @@ DAWG_load(DAWG* dawg, uint8_t* array, size_t size);
 	Count and save number of words reachable from each state
 	This is required by DAWG_mph_get_word_index() and
 	DAWG_mph_get_word_from_index().
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
 */
-static void
+static int
 DAWG_mph_numerate_nodes(DAWG* dawg);
 
 
+/*
+	Checks if numbers of nodes placed in a block are consistent:
+	number of node is eow plus sum of numbers of its children.
+*/
+static bool PURE
+DAWG_mph_check_numbers(const DAWGNode* nodes, const size_t nodes_count);
+
+
 /*
 	Returns unique index of a word. Index is in a range
 	(1 .. dawg->count) or 0 if word isn't not present in
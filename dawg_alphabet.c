@@ -0,0 +1,213 @@
+/*
+	This is part of pydawg Python module.
+
+	Alphabet of a DAWG.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+static void
+DAWG_alphabet_init(DAWGAlphabet* alphabet) {
+	alphabet->size		= 0;
+	alphabet->letters	= NULL;
+	alphabet->lut_size	= 0;
+	alphabet->lut		= NULL;
+}
+
+
+static void
+DAWG_alphabet_free(DAWGAlphabet* alphabet) {
+	if (alphabet->letters)
+		memfree(alphabet->letters);
+
+	if (alphabet->lut)
+		memfree(alphabet->lut);
+
+	DAWG_alphabet_init(alphabet);
+}
+
+
+static int
+DAWG_alphabet_set(DAWGAlphabet* alphabet, const DAWG_LETTER_TYPE* letters, const size_t size) {
+	size_t i;
+
+	DAWG_alphabet_free(alphabet);
+
+	alphabet->lut_size = (size > 0) ? (size_t)letters[size - 1] + 1 : 0;
+	if (alphabet->lut_size > DAWG_ALPHABET_LUT_MAX)
+		alphabet->lut_size = DAWG_ALPHABET_LUT_MAX;
+
+	alphabet->letters	= memalloc((size + 1) * DAWG_LETTER_SIZE);
+	alphabet->lut		= memcalloc(alphabet->lut_size + 1, sizeof(uint32_t));
+	if (alphabet->letters == NULL or alphabet->lut == NULL) {
+		DAWG_alphabet_free(alphabet);
+		return DAWG_NO_MEM;
+	}
+
+	for (i=0; i < size; i++) {
+		ASSERT(i == 0 or letters[i - 1] < letters[i]);
+		alphabet->letters[i] = letters[i];
+		if ((size_t)letters[i] < alphabet->lut_size)
+			alphabet->lut[letters[i]] = (uint32_t)(i + 1);
+	}
+
+	alphabet->size = size;
+	return DAWG_OK;
+}
+
+
+static uint32_t PURE
+DAWG_alphabet_code(const DAWGAlphabet* alphabet, const DAWG_LETTER_TYPE letter) {
+	if (LIKELY((size_t)letter < alphabet->lut_size))
+		return alphabet->lut[letter];
+
+	// binary search
+	int a = 0;
+	int b = (int)alphabet->size - 1;
+	int c;
+	while (a <= b) {
+		c = (a + b)/2;
+		if (alphabet->letters[c] == letter)
+			return (uint32_t)c + 1;
+		else if (alphabet->letters[c] > letter)
+			b = c - 1;
+		else
+			a = c + 1;
+	}
+
+	return 0;
+}
+
+
+// greater letters (e.g. 32-bit tokens) are collected and sorted
+#define ALPHABET_PRESENT_MAX	(0x110000)
+
+typedef struct AlphabetAux {
+	size_t		max_letter;	///< the greatest letter
+	size_t		edges;		///< number of edges
+	uint8_t*	present;	///< present[letter] is non-zero if letter is used
+	DAWG_LETTER_TYPE*	letters;	///< letters of all edges
+	size_t		count;		///< number of letters
+} AlphabetAux;
+
+
+static int
+alphabet_max_letter(DAWGNode* node, UNUSED const size_t depth, void* extra) {
+#define aux ((AlphabetAux*)extra)
+	// edges are sorted, the last one has the greatest letter
+	if (node->n > 0 and (size_t)node->next[node->n - 1].letter > aux->max_letter)
+		aux->max_letter = (size_t)node->next[node->n - 1].letter;
+
+	aux->edges += node->n;
+	return 1;
+#undef aux
+}
+
+
+static int
+alphabet_mark_letters(DAWGNode* node, UNUSED const size_t depth, void* extra) {
+#define aux ((AlphabetAux*)extra)
+	size_t i;
+	for (i=0; i < node->n; i++)
+		aux->present[node->next[i].letter] = 1;
+
+	return 1;
+#undef aux
+}
+
+
+static int
+alphabet_collect_letters(DAWGNode* node, UNUSED const size_t depth, void* extra) {
+#define aux ((AlphabetAux*)extra)
+	size_t i;
+	for (i=0; i < node->n; i++)
+		aux->letters[aux->count++] = node->next[i].letter;
+
+	return 1;
+#undef aux
+}
+
+
+static int
+alphabet_compare(const void* a, const void* b) {
+	const DAWG_LETTER_TYPE x = *(const DAWG_LETTER_TYPE*)a;
+	const DAWG_LETTER_TYPE y = *(const DAWG_LETTER_TYPE*)b;
+
+	return (x > y) - (x < y);
+}
+
+
+static int
+DAWG_get_alphabet(DAWG* dawg, DAWGAlphabet* alphabet) {
+	ASSERT(dawg);
+	ASSERT(alphabet);
+
+	AlphabetAux aux;
+	size_t i, size;
+
+	DAWG_alphabet_init(alphabet);
+
+	if (dawg->state == CLOSED and dawg->alphabet.letters)
+		return DAWG_alphabet_set(alphabet, dawg->alphabet.letters, dawg->alphabet.size);
+
+	aux.max_letter	= 0;
+	aux.edges		= 0;
+	if (DAWG_traverse_DFS_once(dawg, alphabet_max_letter, &aux) < 0)
+		return DAWG_NO_MEM;
+
+	if (aux.max_letter >= ALPHABET_PRESENT_MAX) {
+		aux.count	= 0;
+		aux.letters	= memalloc((aux.edges + 1) * DAWG_LETTER_SIZE);
+		if (aux.letters == NULL)
+			return DAWG_NO_MEM;
+
+		if (DAWG_traverse_DFS_once(dawg, alphabet_collect_letters, &aux) < 0) {
+			memfree(aux.letters);
+			return DAWG_NO_MEM;
+		}
+
+		qsort(aux.letters, aux.count, DAWG_LETTER_SIZE, alphabet_compare);
+		for (i=0, size=0; i < aux.count; i++)
+			if (size == 0 or aux.letters[size - 1] != aux.letters[i])
+				aux.letters[size++] = aux.letters[i];
+
+		const int result = DAWG_alphabet_set(alphabet, aux.letters, size);
+		memfree(aux.letters);
+
+		return result;
+	}
+
+	aux.present = memcalloc(aux.max_letter + 1, 1);
+	if (aux.present == NULL)
+		return DAWG_NO_MEM;
+
+	if (DAWG_traverse_DFS_once(dawg, alphabet_mark_letters, &aux) < 0) {
+		memfree(aux.present);
+		return DAWG_NO_MEM;
+	}
+
+	size = 0;
+	for (i=0; i <= aux.max_letter; i++)
+		size += aux.present[i];
+
+	DAWG_LETTER_TYPE* letters = memalloc((size + 1) * DAWG_LETTER_SIZE);
+	if (letters == NULL) {
+		memfree(aux.present);
+		return DAWG_NO_MEM;
+	}
+
+	size = 0;
+	for (i=0; i <= aux.max_letter; i++)
+		if (aux.present[i])
+			letters[size++] = (DAWG_LETTER_TYPE)i;
+
+	memfree(aux.present);
+
+	const int result = DAWG_alphabet_set(alphabet, letters, size);
+	memfree(letters);
+
+	return result;
+}
@@ -0,0 +1,57 @@
+/*
+	This is part of pydawg Python module.
+
+	Alphabet of a DAWG -- set of letters used by edges, mapped
+	to dense codes 1 .. size (0 means "not in alphabet").
+	Codes preserve order of letters.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_alphabet_h_included__
+#define dawg_alphabet_h_included__
+
+#include "common.h"
+
+#define DAWG_ALPHABET_LUT_MAX	(0x10000)
+
+typedef struct DAWGAlphabet {
+	size_t	size;				///< number of distinct letters
+	DAWG_LETTER_TYPE* letters;	///< sorted letters, code of letters[i] is i + 1
+	size_t	lut_size;			///< size of lut, letters >= lut_size are binary searched
+	uint32_t* lut;				///< letter => code
+} DAWGAlphabet;
+
+
+/* init empty alphabet */
+static void
+DAWG_alphabet_init(DAWGAlphabet* alphabet);
+
+
+/* free memory */
+static void
+DAWG_alphabet_free(DAWGAlphabet* alphabet);
+
+
+/* set alphabet from sorted array of distinct letters, array is copied */
+static int
+DAWG_alphabet_set(DAWGAlphabet* alphabet, const DAWG_LETTER_TYPE* letters, const size_t size);
+
+
+/* returns code of letter, or 0 if letter is not in the alphabet */
+static uint32_t PURE
+DAWG_alphabet_code(const DAWGAlphabet* alphabet, const DAWG_LETTER_TYPE letter);
+
+
+/* returns length of the longest prefix of word made of alphabet letters;
+   empty alphabet structure (not computed) accepts any letter */
+static size_t PURE
+DAWG_alphabet_prefix(const DAWGAlphabet* alphabet, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* returns letter of given code (1 .. size) */
+#define DAWG_alphabet_letter(alphabet, code) ((alphabet)->letters[(code) - 1])
+
+#endif
@@ -0,0 +1,718 @@
+/*
+	This is part of pydawg Python module.
+
+	Compacted representation of a closed DAWG.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "dawg_compact.h"
+
+#define COMPACT_NONE	((uint32_t)-1)
+
+
+static void
+DAWG_compact_init(DAWGCompact* compact) {
+	compact->image			= NULL;
+	compact->nodes_count	= 0;
+	compact->edges_count	= 0;
+	compact->labels_size	= 0;
+	compact->words_count	= 0;
+	compact->longest_word	= 0;
+	compact->nodes			= NULL;
+	compact->edges			= NULL;
+	compact->labels			= NULL;
+}
+
+
+static void
+DAWG_compact_free(DAWGCompact* compact) {
+	// image is owned by caller of DAWG_compact_view
+	if (compact->image == NULL) {
+		if (compact->nodes)
+			memfree(compact->nodes);
+
+		if (compact->edges)
+			memfree(compact->edges);
+
+		if (compact->labels)
+			memfree(compact->labels);
+	}
+
+	DAWG_compact_init(compact);
+}
+
+
+/* chain of unary, non-final nodes */
+typedef struct CompactChain {
+	uint32_t	label;		///< offset of letters in the pool
+	uint32_t	length;		///< number of letters
+	uint32_t	target;		///< the first node past the chain
+} CompactChain;
+
+
+typedef struct CompactAux {
+	DAWGNode**		nodes;		///< nodes in BFS order
+	addr_HashTable	index;		///< node => index in nodes
+	uint32_t*		ids;		///< index => compact node id, COMPACT_NONE for chain nodes
+	CompactChain*	chains;		///< index => chain starting at the node
+
+	DAWG_LETTER_TYPE*	labels;	///< label pool
+	size_t			labels_size;
+	size_t			labels_capacity;
+} CompactAux;
+
+
+#define node_index(aux, node) (addr_hashtable_get(&(aux)->index, (node))->data)
+
+
+static int
+compact_append_letter(CompactAux* aux, const DAWG_LETTER_TYPE letter) {
+	if (aux->labels_size == aux->labels_capacity) {
+		const size_t capacity = aux->labels_capacity ? 2 * aux->labels_capacity : 1024;
+		DAWG_LETTER_TYPE* tmp = memrealloc(aux->labels, capacity * DAWG_LETTER_SIZE);
+		if (tmp == NULL)
+			return DAWG_NO_MEM;
+
+		aux->labels = tmp;
+		aux->labels_capacity = capacity;
+	}
+
+	aux->labels[aux->labels_size++] = letter;
+	return DAWG_OK;
+}
+
+
+/* find chain starting at node of given index; letters are appended to the pool */
+static int
+compact_chain(CompactAux* aux, const size_t start) {
+	const size_t label = aux->labels_size;
+	size_t length = 0;
+	size_t walked = 0;
+	uint32_t target;
+	size_t i, k;
+
+	ASSERT(aux->ids[start] == COMPACT_NONE);
+
+	i = start;
+	while (aux->ids[i] == COMPACT_NONE and aux->chains[i].target == COMPACT_NONE) {
+		ASSERT(aux->nodes[i]->n == 1);
+		if (compact_append_letter(aux, aux->nodes[i]->next[0].letter) != DAWG_OK)
+			return DAWG_NO_MEM;
+
+		i = node_index(aux, aux->nodes[i]->next[0].child);
+		walked += 1;
+	}
+
+	length = walked;
+	if (aux->ids[i] != COMPACT_NONE)
+		target = aux->ids[i];
+	else {
+		// the rest of chain is already known, copy its letters
+		const CompactChain chain = aux->chains[i];
+		for (k=0; k < chain.length; k++)
+			if (compact_append_letter(aux, aux->labels[chain.label + k]) != DAWG_OK)
+				return DAWG_NO_MEM;
+
+		length += chain.length;
+		target  = chain.target;
+	}
+
+	if (aux->labels_size > UINT32_MAX)
+		return DAWG_TOO_BIG;
+
+	// each node of chain starts a suffix of the label
+	i = start;
+	for (k=0; k < walked; k++) {
+		aux->chains[i].label	= label + k;
+		aux->chains[i].length	= length - k;
+		aux->chains[i].target	= target;
+
+		i = node_index(aux, aux->nodes[i]->next[0].child);
+	}
+
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_compact_compile(DAWG* dawg, DAWGCompact* compact) {
+	ASSERT(dawg);
+	ASSERT(compact);
+
+	if (dawg->state != CLOSED)
+		return DAWG_NOT_CLOSED;
+
+	DAWGStatistics stats;
+	CompactAux aux;
+	size_t i, j;
+	int result;
+
+	DAWG_compact_free(compact);
+	if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	if (stats.nodes_count >= UINT32_MAX or stats.edges_count >= UINT32_MAX)
+		return DAWG_TOO_BIG;
+
+#ifdef DAWG_PERFECT_HASHING
+	if (DAWG_mph_numerate_nodes(dawg) != DAWG_OK)
+		return DAWG_NO_MEM;
+#endif
+
+	aux.labels			= NULL;
+	aux.labels_size		= 0;
+	aux.labels_capacity	= 0;
+	aux.nodes	= memalloc(stats.nodes_count * sizeof(DAWGNode*));
+	aux.ids		= memalloc(stats.nodes_count * sizeof(uint32_t));
+	aux.chains	= memalloc(stats.nodes_count * sizeof(CompactChain));
+	if (addr_hashtable_init(&aux.index, stats.nodes_count * 10/7 + 1) < 0) {
+		result = DAWG_NO_MEM;
+		goto error_hashtable;
+	}
+
+	result = DAWG_NO_MEM;
+	if (aux.nodes == NULL or aux.ids == NULL or aux.chains == NULL)
+		goto error;
+
+	// 1. number nodes in BFS order, nodes of chains are skipped
+	if (DAWG_get_nodes_BFS(dawg, aux.nodes) != DAWG_OK)
+		goto error;
+
+	compact->nodes_count = 0;
+	compact->edges_count = 0;
+	for (i=0; i < stats.nodes_count; i++) {
+		DAWGNode* node = aux.nodes[i];
+		if (addr_hashtable_add(&aux.index, node, i) < 0)
+			goto error;
+
+		aux.chains[i].target = COMPACT_NONE;
+		if (i == 0 or node->eow or node->n != 1) {
+			aux.ids[i] = compact->nodes_count++;
+			compact->edges_count += node->n;
+		}
+		else
+			aux.ids[i] = COMPACT_NONE;
+	}
+
+	compact->nodes = memalloc(compact->nodes_count * sizeof(DAWGCompactNode));
+	compact->edges = memalloc((compact->edges_count + 1) * sizeof(DAWGCompactEdge));
+	if (compact->nodes == NULL or compact->edges == NULL)
+		goto error;
+
+	// 2. fill nodes and edges
+	size_t edge = 0;
+	for (i=0; i < stats.nodes_count; i++) {
+		if (aux.ids[i] == COMPACT_NONE)
+			continue;
+
+		DAWGNode* node = aux.nodes[i];
+		DAWGCompactNode* cnode = &compact->nodes[aux.ids[i]];
+
+		cnode->edges	= edge;
+		cnode->n		= node->n;
+		cnode->eow		= node->eow;
+#ifdef DAWG_PERFECT_HASHING
+		cnode->number	= node->number;
+#endif
+
+		for (j=0; j < node->n; j++, edge++) {
+			DAWGCompactEdge* cedge = &compact->edges[edge];
+			const size_t child = node_index(&aux, node->next[j].child);
+
+			cedge->letter = node->next[j].letter;
+			if (aux.ids[child] != COMPACT_NONE) {
+				cedge->label	= 0;
+				cedge->length	= 0;
+				cedge->child	= aux.ids[child];
+			}
+			else {
+				if (aux.chains[child].target == COMPACT_NONE) {
+					result = compact_chain(&aux, child);
+					if (result != DAWG_OK)
+						goto error;
+
+					result = DAWG_NO_MEM;
+				}
+
+				cedge->label	= aux.chains[child].label;
+				cedge->length	= aux.chains[child].length;
+				cedge->child	= aux.chains[child].target;
+			}
+		}
+	}
+
+	ASSERT(edge == compact->edges_count);
+
+	compact->labels			= aux.labels;
+	compact->labels_size	= aux.labels_size;
+	compact->words_count	= dawg->count;
+	compact->longest_word	= dawg->longest_word;
+	aux.labels = NULL;
+
+	result = DAWG_OK;
+
+error:
+	addr_hashtable_destroy(&aux.index);
+
+error_hashtable:
+	if (aux.nodes)
+		memfree(aux.nodes);
+
+	if (aux.ids)
+		memfree(aux.ids);
+
+	if (aux.chains)
+		memfree(aux.chains);
+
+	if (aux.labels)
+		memfree(aux.labels);
+
+	if (result != DAWG_OK)
+		DAWG_compact_free(compact);
+
+	return result;
+}
+
+#undef node_index
+
+
+static void
+DAWG_compact_get_stats(const DAWGCompact* compact, DAWGCompactStatistics* stats) {
+	stats->nodes_count	= compact->nodes_count;
+	stats->edges_count	= compact->edges_count;
+	stats->labels_size	= compact->labels_size;
+	stats->words_count	= compact->words_count;
+	stats->longest_word	= compact->longest_word;
+
+	stats->size = compact->nodes_count * sizeof(DAWGCompactNode) +
+				  compact->edges_count * sizeof(DAWGCompactEdge) +
+				  compact->labels_size * DAWG_LETTER_SIZE;
+}
+
+
+#define compact_align(offset) (((offset) + 7) & ~(size_t)7)
+
+/* offsets of arrays in image */
+typedef struct CompactImageLayout {
+	size_t	nodes;
+	size_t	edges;
+	size_t	labels;
+	size_t	size;
+} CompactImageLayout;
+
+
+static void
+compact_image_layout(const uint64_t nodes_count, const uint64_t edges_count, const uint64_t labels_size, CompactImageLayout* layout) {
+	layout->nodes	= COMPACT_IMAGE_HEADER_SIZE;
+	layout->edges	= compact_align(layout->nodes + nodes_count * sizeof(DAWGCompactNode));
+	layout->labels	= compact_align(layout->edges + edges_count * sizeof(DAWGCompactEdge));
+	layout->size	= layout->labels + labels_size * DAWG_LETTER_SIZE;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+#	define COMPACT_IMAGE_FLAGS	1
+#else
+#	define COMPACT_IMAGE_FLAGS	0
+#endif
+
+
+static int
+DAWG_compact_save(const DAWGCompact* compact, uint8_t** array, size_t* size) {
+	CompactImageLayout layout;
+	size_t i;
+
+	compact_image_layout(compact->nodes_count, compact->edges_count, compact->labels_size, &layout);
+
+	// zeroed, so padding of structures is deterministic
+	uint8_t* image = (uint8_t*)memcalloc(layout.size, 1);
+	if (image == NULL)
+		return DAWG_NO_MEM;
+
+	uint32_t* header32 = (uint32_t*)image;
+	uint64_t* header64 = (uint64_t*)(image + 24);
+	header32[0] = COMPACT_IMAGE_MAGICK;
+	header32[1] = COMPACT_IMAGE_VERSION;
+	header32[2] = DAWG_LETTER_SIZE;
+	header32[3] = COMPACT_IMAGE_FLAGS;
+	header32[4] = sizeof(DAWGCompactNode);
+	header32[5] = sizeof(DAWGCompactEdge);
+	header64[0] = compact->nodes_count;
+	header64[1] = compact->edges_count;
+	header64[2] = compact->labels_size;
+	header64[3] = compact->words_count;
+	header64[4] = compact->longest_word;
+
+	DAWGCompactNode* nodes = (DAWGCompactNode*)(image + layout.nodes);
+	for (i=0; i < compact->nodes_count; i++) {
+		nodes[i].edges	= compact->nodes[i].edges;
+		nodes[i].n		= compact->nodes[i].n;
+		nodes[i].eow	= compact->nodes[i].eow;
+#ifdef DAWG_PERFECT_HASHING
+		nodes[i].number	= compact->nodes[i].number;
+#endif
+	}
+
+	DAWGCompactEdge* edges = (DAWGCompactEdge*)(image + layout.edges);
+	for (i=0; i < compact->edges_count; i++) {
+		edges[i].letter	= compact->edges[i].letter;
+		edges[i].label	= compact->edges[i].label;
+		edges[i].length	= compact->edges[i].length;
+		edges[i].child	= compact->edges[i].child;
+	}
+
+	if (compact->labels_size > 0)
+		memcpy(image + layout.labels, compact->labels, compact->labels_size * DAWG_LETTER_SIZE);
+
+	*array	= image;
+	*size	= layout.size;
+	return DAWG_OK;
+}
+
+
+/*
+	Check indices of nodes, edges and labels, then check if graph is
+	acyclic and agrees with counts saved in header (and MPH numbers);
+	queries trust all of them. Nodes are visited in topological order
+	(Kahn's algorithm), like in load_check_graph.
+*/
+static int
+compact_check_image(const DAWGCompact* compact) {
+	const size_t n = compact->nodes_count;
+	size_t*		indegree = memcalloc(n, sizeof(size_t));
+	size_t*		order	 = memalloc(n * sizeof(size_t));
+	uint64_t*	height	 = memcalloc(n, sizeof(uint64_t));
+	uint64_t*	count	 = memalloc(n * sizeof(uint64_t));
+	size_t head, tail;
+	size_t i, j;
+	int result;
+
+	if (indegree == NULL or order == NULL or height == NULL or count == NULL) {
+		result = DAWG_NO_MEM;
+		goto end;
+	}
+
+	for (i=0; i < n; i++) {
+		const DAWGCompactNode* node = &compact->nodes[i];
+		if ((uint64_t)node->edges + node->n > compact->edges_count) {
+			result = DAWG_DUMP_CORRUPTED_2;
+			goto end;
+		}
+
+		// bool is a char, other values would break comparisons
+		if ((uint8_t)node->eow > 1) {
+			result = DAWG_DUMP_INVALID_GRAPH;
+			goto end;
+		}
+
+		for (j=node->edges; j < node->edges + node->n; j++) {
+			const DAWGCompactEdge* edge = &compact->edges[j];
+			if (edge->child >= n or (uint64_t)edge->label + edge->length > compact->labels_size) {
+				result = DAWG_DUMP_CORRUPTED_2;
+				goto end;
+			}
+
+			// edges are sorted by the first letter
+			if (j > node->edges and edge[-1].letter >= edge->letter) {
+				result = DAWG_DUMP_INVALID_GRAPH;
+				goto end;
+			}
+
+			indegree[edge->child] += 1;
+		}
+	}
+
+	tail = 0;
+	for (i=0; i < n; i++)
+		if (indegree[i] == 0)
+			order[tail++] = i;
+
+	for (head=0; head < tail; head++) {
+		const DAWGCompactNode* node = &compact->nodes[order[head]];
+		for (j=node->edges; j < node->edges + node->n; j++) {
+			const size_t child = compact->edges[j].child;
+			if (--indegree[child] == 0)
+				order[tail++] = child;
+		}
+	}
+
+	result = DAWG_DUMP_INVALID_GRAPH;
+	if (tail != n)	// cycle
+		goto end;
+
+	// height is the longest path in letters, labels included
+	for (i=n; i > 0; i--) {
+		const size_t id = order[i - 1];
+		const DAWGCompactNode* node = &compact->nodes[id];
+
+		count[id] = node->eow;
+		for (j=node->edges; j < node->edges + node->n; j++) {
+			const DAWGCompactEdge* edge = &compact->edges[j];
+			if (height[id] < height[edge->child] + 1 + edge->length)
+				height[id] = height[edge->child] + 1 + edge->length;
+
+			// saturated, corrupted graph may have more paths than 2^64
+			if (count[edge->child] > UINT64_MAX - count[id])
+				count[id] = UINT64_MAX;
+			else
+				count[id] += count[edge->child];
+		}
+
+#ifdef DAWG_PERFECT_HASHING
+		if (node->number < 0 or count[id] != (uint64_t)node->number) {
+			result = DAWG_DUMP_INVALID_NUMBERS;
+			goto end;
+		}
+#endif
+	}
+
+	if (n == 0 or (count[0] == compact->words_count and height[0] == compact->longest_word))
+		result = DAWG_OK;
+
+end:
+	if (indegree)	memfree(indegree);
+	if (order)		memfree(order);
+	if (height)		memfree(height);
+	if (count)		memfree(count);
+
+	return result;
+}
+
+
+static int
+DAWG_compact_view(DAWGCompact* compact, const uint8_t* image, const size_t size, const bool trusted) {
+	CompactImageLayout layout;
+	DAWGCompact view;
+	int result;
+
+	if (size < COMPACT_IMAGE_HEADER_SIZE)
+		return DAWG_DUMP_TRUNCATED;
+
+	const uint32_t* header32 = (const uint32_t*)image;
+	const uint64_t* header64 = (const uint64_t*)(image + 24);
+	if (header32[0] != COMPACT_IMAGE_MAGICK or
+		header32[1] != COMPACT_IMAGE_VERSION or
+		header32[2] != DAWG_LETTER_SIZE or
+		header32[3] != COMPACT_IMAGE_FLAGS or
+		header32[4] != sizeof(DAWGCompactNode) or
+		header32[5] != sizeof(DAWGCompactEdge))
+		return DAWG_DUMP_INVALID_MAGICK;
+
+	const uint64_t nodes_count = header64[0];
+	const uint64_t edges_count = header64[1];
+	const uint64_t labels_size = header64[2];
+
+	// ids are 32-bit, also prevents overflows below
+	if (nodes_count > UINT32_MAX or edges_count > UINT32_MAX or labels_size > UINT32_MAX)
+		return DAWG_DUMP_CORRUPTED_1;
+
+	// words without root
+	if (nodes_count == 0 and header64[3] != 0)
+		return DAWG_DUMP_CORRUPTED_1;
+
+	// empty graph
+	if (nodes_count == 0 and header64[4] != 0)
+		return DAWG_DUMP_CORRUPTED_1;
+
+	compact_image_layout(nodes_count, edges_count, labels_size, &layout);
+	if (size < layout.size)
+		return DAWG_DUMP_TRUNCATED;
+
+	view.image			= image;
+	view.nodes_count	= nodes_count;
+	view.edges_count	= edges_count;
+	view.labels_size	= labels_size;
+	view.words_count	= header64[3];
+	view.longest_word	= header64[4];
+	view.nodes			= (DAWGCompactNode*)(image + layout.nodes);
+	view.edges			= (DAWGCompactEdge*)(image + layout.edges);
+	view.labels			= (DAWG_LETTER_TYPE*)(image + layout.labels);
+
+	if (not trusted) {
+		result = compact_check_image(&view);
+		if (result != DAWG_OK)
+			return result;
+	}
+
+	DAWG_compact_free(compact);
+	*compact = view;
+
+	return DAWG_OK;
+}
+
+
+static const DAWGCompactEdge* PURE
+DAWG_compact_find_edge(const DAWGCompact* compact, const DAWGCompactNode* node, const DAWG_LETTER_TYPE letter) {
+	const DAWGCompactEdge* edges = &compact->edges[node->edges];
+
+	// binary search, edges are sorted by the first letter
+	int a = 0;
+	int b = (int)node->n - 1;
+	int c;
+	while (a <= b) {
+		c = (a + b)/2;
+		if (edges[c].letter == letter)
+			return &edges[c];
+		else if (edges[c].letter > letter)
+			b = c - 1;
+		else
+			a = c + 1;
+	}
+
+	return NULL;
+}
+
+
+#define compact_label(compact, edge) (&(compact)->labels[(edge)->label])
+
+
+static bool PURE
+DAWG_compact_exists(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(compact->nodes_count == 0))
+		return false;
+
+	const DAWGCompactNode* node = compact->nodes;
+	size_t i = 0;
+	while (i < wordlen) {
+		const DAWGCompactEdge* edge = DAWG_compact_find_edge(compact, node, word[i]);
+		if (edge == NULL)
+			return false;
+
+		i += 1;
+		if (edge->length > 0) {
+			if (edge->length > wordlen - i)
+				return false;
+
+			if (memcmp(compact_label(compact, edge), word + i, edge->length * DAWG_LETTER_SIZE) != 0)
+				return false;
+
+			i += edge->length;
+		}
+
+		node = &compact->nodes[edge->child];
+	}
+
+	return node->eow;
+}
+
+
+static size_t PURE
+DAWG_compact_longest_prefix(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(compact->nodes_count == 0))
+		return 0;
+
+	const DAWGCompactNode* node = compact->nodes;
+	size_t i = 0;
+	while (i < wordlen) {
+		const DAWGCompactEdge* edge = DAWG_compact_find_edge(compact, node, word[i]);
+		if (edge == NULL)
+			break;
+
+		i += 1;
+		if (edge->length > 0) {
+			const DAWG_LETTER_TYPE* label = compact_label(compact, edge);
+			const size_t n = (edge->length < wordlen - i) ? edge->length : wordlen - i;
+
+			if (n < edge->length or memcmp(label, word + i, n * DAWG_LETTER_SIZE) != 0) {
+				// path ends inside the label
+				size_t k = 0;
+				while (k < n and label[k] == word[i + k])
+					k += 1;
+
+				return i + k;
+			}
+
+			i += edge->length;
+		}
+
+		node = &compact->nodes[edge->child];
+	}
+
+	return i;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+static size_t PURE
+DAWG_compact_word2index(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(compact->nodes_count == 0))
+		return DAWG_NOT_EXISTS;
+
+	const DAWGCompactNode* node = compact->nodes;
+	size_t index = 0;
+	size_t i = 0;
+	while (i < wordlen) {
+		const DAWGCompactEdge* edge = DAWG_compact_find_edge(compact, node, word[i]);
+		const DAWGCompactEdge* e;
+		if (edge == NULL)
+			return DAWG_NOT_EXISTS;
+
+		i += 1;
+		if (edge->length > 0) {
+			if (edge->length > wordlen - i)
+				return DAWG_NOT_EXISTS;
+
+			if (memcmp(compact_label(compact, edge), word + i, edge->length * DAWG_LETTER_SIZE) != 0)
+				return DAWG_NOT_EXISTS;
+
+			i += edge->length;
+		}
+
+		for (e = &compact->edges[node->edges]; e < edge; e++)
+			index += compact->nodes[e->child].number;
+
+		node = &compact->nodes[edge->child];
+		if (node->eow)
+			index += 1;
+	}
+
+	return node->eow ? index : DAWG_NOT_EXISTS;
+}
+
+
+static int
+DAWG_compact_index2word(const DAWGCompact* compact, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen) {
+	// the empty word has no index
+	if (index < 1 or compact->nodes_count == 0 or index > compact->words_count - compact->nodes[0].eow)
+		return DAWG_NOT_EXISTS;
+
+	*wordlen = 0;
+	*word = (DAWG_LETTER_TYPE*)memalloc((compact->longest_word + 1) * DAWG_LETTER_SIZE);
+	if (*word == NULL)
+		return DAWG_NO_MEM;
+
+	const DAWGCompactNode* node = compact->nodes;
+	size_t count = index;
+	size_t i;
+	do {
+		const DAWGCompactEdge* edge = &compact->edges[node->edges];
+		for (i=0; i < node->n; i++, edge++) {
+			const DAWGCompactNode* child = &compact->nodes[edge->child];
+			if ((size_t)child->number < count)
+				count -= child->number;
+			else {
+				(*word)[*wordlen] = edge->letter;
+				if (edge->length > 0)
+					memcpy(*word + *wordlen + 1, compact_label(compact, edge), edge->length * DAWG_LETTER_SIZE);
+
+				*wordlen += 1 + edge->length;
+
+				node = child;
+				if (node->eow)
+					count -= 1;
+
+				break;
+			}
+		}
+	}
+	while (count > 0);
+
+	return DAWG_EXISTS;
+}
+#endif
+
+#undef compact_label
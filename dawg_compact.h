@@ -0,0 +1,180 @@
+/*
+	This is part of pydawg Python module.
+
+	Compacted (path compressed), read-only representation of
+	a closed DAWG.
+
+	Maximal chains of nodes having single edge and no end-of-word
+	marker are collapsed into single edge labelled with a string.
+	The first letter of label is stored in the edge (edges of a node
+	are sorted by it), the rest of label is kept in a label pool
+	shared by all edges entering the same chain.
+
+	Nodes are numbered in BFS order, the root has number 0.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_compact_h_included__
+#define dawg_compact_h_included__
+
+#include "common.h"
+#include "dawg.h"
+
+typedef struct DAWGCompactNode {
+	uint32_t	edges;		///< index of the first edge
+	uint32_t	n;			///< number of edges
+	bool		eow;		///< end of word marker
+#ifdef DAWG_PERFECT_HASHING
+	int			number;		///< number of words reachable from this node
+#endif
+} DAWGCompactNode;
+
+
+typedef struct DAWGCompactEdge {
+	DAWG_LETTER_TYPE	letter;	///< the first letter of label
+	uint32_t	label;		///< offset of the rest of label in the pool
+	uint32_t	length;		///< length of the rest of label
+	uint32_t	child;		///< destination node
+} DAWGCompactEdge;
+
+
+typedef struct DAWGCompact {
+	const uint8_t*	image;		///< image the arrays point into (see DAWG_compact_view), NULL if arrays are allocated
+
+	size_t	nodes_count;
+	size_t	edges_count;
+	size_t	labels_size;		///< number of letters in the pool
+	size_t	words_count;
+	size_t	longest_word;
+
+	DAWGCompactNode*	nodes;
+	DAWGCompactEdge*	edges;
+	DAWG_LETTER_TYPE*	labels;	///< label pool
+} DAWGCompact;
+
+
+typedef struct DAWGCompactStatistics {
+	size_t	nodes_count;
+	size_t	edges_count;
+	size_t	labels_size;
+	size_t	words_count;
+	size_t	longest_word;
+	size_t	size;
+} DAWGCompactStatistics;
+
+
+/* init empty structure */
+static void
+DAWG_compact_init(DAWGCompact* compact);
+
+
+/* free memory */
+static void
+DAWG_compact_free(DAWGCompact* compact);
+
+
+/**	Build compacted representation of closed DAWG.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+		DAWG_TOO_BIG
+*/
+static int
+DAWG_compact_compile(DAWG* dawg, DAWGCompact* compact);
+
+
+/*	Image of structure, queried in place once mapped into memory:
+
+	- header (64 bytes):
+		- magick		: 4 bytes
+		- version		: 4 bytes
+		- letter size	: 4 bytes
+		- flags			: 4 bytes (bit 0 - perfect hashing numbers)
+		- node size		: 4 bytes
+		- edge size		: 4 bytes
+		- nodes count, edges count, labels size, words count,
+		  longest word	: 8 bytes each
+	- nodes		: array of DAWGCompactNode
+	- edges		: array of DAWGCompactEdge
+	- labels	: label pool
+
+	Arrays start at offsets aligned to 8 bytes. Integers are saved
+	in native byte order, thus image can be used only on machines
+	of the same endianness (magick doesn't match otherwise).
+*/
+#define COMPACT_IMAGE_HEADER_SIZE	64
+#define COMPACT_IMAGE_MAGICK		0x43574450	// 'PDWC'
+#define COMPACT_IMAGE_VERSION		1
+
+
+/**	Save image of structure.
+
+	@param[out]	array		image, have to be freed manually
+	@param[out]	size		size of image
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_compact_save(const DAWGCompact* compact, uint8_t** array, size_t* size);
+
+
+/**	Set structure to arrays of image saved by DAWG_compact_save,
+	nothing is copied; image has to be aligned to 8 bytes and
+	kept unchanged until structure is freed. Header is always
+	validated; unless image is trusted, one pass over it checks
+	indices, shape of graph and counts, structure is not changed
+	on error.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_DUMP_TRUNCATED
+		DAWG_DUMP_INVALID_MAGICK
+		DAWG_DUMP_CORRUPTED_1		--- counts in header
+		DAWG_DUMP_CORRUPTED_2		--- index of edge, node or label out of range
+		DAWG_DUMP_INVALID_GRAPH		--- cycles, unsorted edges, counts don't match graph
+		DAWG_DUMP_INVALID_NUMBERS	--- MPH numbers don't match graph
+*/
+static int
+DAWG_compact_view(DAWGCompact* compact, const uint8_t* image, const size_t size, const bool trusted);
+
+
+/* get statistics */
+static void
+DAWG_compact_get_stats(const DAWGCompact* compact, DAWGCompactStatistics* stats);
+
+
+/* returns edge of node starting with letter, or NULL */
+static const DAWGCompactEdge* PURE
+DAWG_compact_find_edge(const DAWGCompact* compact, const DAWGCompactNode* node, const DAWG_LETTER_TYPE letter);
+
+
+/* same as DAWG_exists */
+static bool PURE
+DAWG_compact_exists(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_longest_prefix */
+static size_t PURE
+DAWG_compact_longest_prefix(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+#ifdef DAWG_PERFECT_HASHING
+/* same as DAWG_mph_word2index */
+static size_t PURE
+DAWG_compact_word2index(const DAWGCompact* compact, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_mph_index2word */
+static int
+DAWG_compact_index2word(const DAWGCompact* compact, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen);
+#endif
+
+#endif
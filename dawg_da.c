@@ -0,0 +1,486 @@
+/*
+	This is part of pydawg Python module.
+
+	Double-array representation of a closed DAWG.
+	This file is included directly in dawg.c.
+
+	Double-array has been introduced in "An Efficient Digital Search
+	Algorithm by Using a Double-Array Structure", Jun-ichi Aoe, IEEE
+	Transactions on Software Engineering, 15(9), 1989.
+
+	Placement of states: free slots are kept on a list, and only
+	the last DA_OPEN_BLOCKS blocks of slots are searched for a free
+	base -- free slots in older blocks are abandoned. Thanks to this,
+	placement time is linear, at cost of slightly worse fill ratio.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "dawg_da.h"
+
+
+static void
+DAWG_da_init(DAWGDoubleArray* da) {
+	da->slots			= NULL;
+	da->size			= 0;
+	da->root			= 0;
+	da->states_count	= 0;
+	da->used_slots		= 0;
+	da->words_count		= 0;
+	da->longest_word	= 0;
+	DAWG_alphabet_init(&da->alphabet);
+}
+
+
+static void
+DAWG_da_free(DAWGDoubleArray* da) {
+	if (da->slots)
+		memfree(da->slots);
+
+	DAWG_alphabet_free(&da->alphabet);
+	DAWG_da_init(da);
+}
+
+
+#define DA_BLOCK_SIZE	256		///< slots are added in blocks
+#define DA_OPEN_BLOCKS	16		///< only free slots from last blocks are searched
+
+typedef struct DABuilder {
+	DAWGDASlot*	slots;
+	uint8_t*	used;			///< used[i] - i-th slot is used
+	uint8_t*	used_base;		///< used_base[i] - some state has base i
+	uint32_t*	next_free;		///< circular list of free slots
+	uint32_t*	prev_free;		///< from open blocks
+	uint32_t	free_head;		///< first free slot, DA_EMPTY if there is none
+	size_t		allocated;		///< size of arrays above
+	size_t		size;			///< number of slots in blocks
+	size_t		open;			///< the first slot of the oldest open block
+	size_t		last;			///< the last used slot
+} DABuilder;
+
+
+static void
+da_builder_init(DABuilder* builder) {
+	builder->slots		= NULL;
+	builder->used		= NULL;
+	builder->used_base	= NULL;
+	builder->next_free	= NULL;
+	builder->prev_free	= NULL;
+	builder->free_head	= DA_EMPTY;
+	builder->allocated	= 0;
+	builder->size		= 0;
+	builder->open		= 0;
+	builder->last		= 0;
+}
+
+
+static void
+da_builder_free(DABuilder* builder) {
+	if (builder->slots)
+		memfree(builder->slots);
+	if (builder->used)
+		memfree(builder->used);
+	if (builder->used_base)
+		memfree(builder->used_base);
+	if (builder->next_free)
+		memfree(builder->next_free);
+	if (builder->prev_free)
+		memfree(builder->prev_free);
+
+	da_builder_init(builder);
+}
+
+
+/* make sure that arrays have at least size elements */
+static int
+da_builder_reserve(DABuilder* builder, const size_t size) {
+	if (LIKELY(size <= builder->allocated))
+		return DAWG_OK;
+
+	size_t allocated = builder->allocated ? builder->allocated : 1024;
+	while (allocated < size)
+		allocated *= 2;
+
+#define realloc_array(name) { \
+		void* tmp = memrealloc(builder->name, allocated * sizeof(builder->name[0])); \
+		if (tmp == NULL) \
+			return DAWG_NO_MEM; \
+		else \
+			builder->name = tmp; \
+	}
+
+	realloc_array(slots);
+	realloc_array(used);
+	realloc_array(used_base);
+	realloc_array(next_free);
+	realloc_array(prev_free);
+#undef realloc_array
+
+	size_t i;
+	for (i=builder->allocated; i < allocated; i++)
+		builder->slots[i].check = DA_EMPTY;
+
+	memset(builder->used + builder->allocated, 0, allocated - builder->allocated);
+	memset(builder->used_base + builder->allocated, 0, allocated - builder->allocated);
+
+	builder->allocated = allocated;
+	return DAWG_OK;
+}
+
+
+static void
+da_builder_unlink(DABuilder* builder, const uint32_t slot) {
+	const uint32_t next = builder->next_free[slot];
+	const uint32_t prev = builder->prev_free[slot];
+
+	if (next == slot)
+		builder->free_head = DA_EMPTY;
+	else {
+		builder->next_free[prev] = next;
+		builder->prev_free[next] = prev;
+		if (builder->free_head == slot)
+			builder->free_head = next;
+	}
+}
+
+
+/* append a block of free slots, close the oldest one if needed */
+static int
+da_builder_extend(DABuilder* builder) {
+	const size_t first = builder->size;
+	const size_t last  = first + DA_BLOCK_SIZE;
+	size_t i;
+
+	if (UNLIKELY(last > DA_BASE_MASK))
+		return DAWG_TOO_BIG;
+
+	if (da_builder_reserve(builder, last) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	for (i=first; i < last; i++) {
+		if (builder->free_head == DA_EMPTY) {
+			builder->free_head = i;
+			builder->next_free[i] = i;
+			builder->prev_free[i] = i;
+		}
+		else {
+			const uint32_t head = builder->free_head;
+			const uint32_t tail = builder->prev_free[head];
+			builder->next_free[tail] = i;
+			builder->prev_free[i] = tail;
+			builder->next_free[i] = head;
+			builder->prev_free[head] = i;
+		}
+	}
+
+	builder->size = last;
+
+	if (builder->size - builder->open > DA_OPEN_BLOCKS * DA_BLOCK_SIZE) {
+		// free slots left in closed block are wasted
+		for (i=builder->open; i < builder->open + DA_BLOCK_SIZE; i++)
+			if (not builder->used[i])
+				da_builder_unlink(builder, i);
+
+		builder->open += DA_BLOCK_SIZE;
+	}
+
+	return DAWG_OK;
+}
+
+
+static int
+da_builder_use(DABuilder* builder, const size_t slot) {
+	while (slot >= builder->size) {
+		const int result = da_builder_extend(builder);
+		if (result != DAWG_OK)
+			return result;
+	}
+
+	ASSERT(not builder->used[slot]);
+	builder->used[slot] = 1;
+	if (slot >= builder->open)
+		da_builder_unlink(builder, slot);
+
+	if (slot > builder->last)
+		builder->last = slot;
+
+	return DAWG_OK;
+}
+
+
+#define da_builder_is_free(builder, slot) \
+	((slot) >= (builder)->size or not (builder)->used[slot])
+
+/* find base such that slots base + codes[i] are free */
+static int
+da_builder_find_base(DABuilder* builder, const uint32_t* codes, const size_t n, uint32_t* result) {
+	size_t base;
+	size_t i;
+
+	ASSERT(n > 0);
+
+	if (builder->free_head != DA_EMPTY) {
+		uint32_t slot = builder->free_head;
+		do {
+			if (slot > codes[0]) {
+				base = slot - codes[0];
+				if (not builder->used_base[base]) {
+					for (i=1; i < n; i++)
+						if (not da_builder_is_free(builder, base + codes[i]))
+							break;
+
+					if (i == n)
+						goto found;
+				}
+			}
+
+			slot = builder->next_free[slot];
+		} while (slot != builder->free_head);
+	}
+
+	// place edges after all blocks
+	if (builder->size > codes[0] and not builder->used_base[builder->size - codes[0]])
+		base = builder->size - codes[0];
+	else
+		base = builder->size;
+
+found:
+	if (UNLIKELY(base > DA_BASE_MASK))
+		return DAWG_TOO_BIG;
+
+	*result = (uint32_t)base;
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_da_compile(DAWG* dawg, DAWGDoubleArray* da) {
+	ASSERT(dawg);
+	ASSERT(da);
+
+	if (dawg->state != CLOSED)
+		return DAWG_NOT_CLOSED;
+
+	DAWGStatistics stats;
+	if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	if (stats.nodes_count > DA_BASE_MASK or dawg->count > UINT32_MAX)
+		return DAWG_TOO_BIG;
+
+	int result;
+	size_t i, j;
+	const size_t N = stats.nodes_count;
+
+	DAWGNode**	nodes	= NULL;		// BFS order => node
+	uint32_t*	bases	= NULL;		// BFS order => base
+	uint32_t*	codes	= NULL;		// codes of a single node
+	addr_HashTable ids;				// node => BFS order
+
+	DABuilder builder;
+	da_builder_init(&builder);
+
+	DAWG_da_free(da);
+	if (addr_hashtable_init(&ids, N * 10/7 + 1) < 0)
+		return DAWG_NO_MEM;
+
+#ifdef DAWG_PERFECT_HASHING
+	result = DAWG_mph_numerate_nodes(dawg);
+	if (result != DAWG_OK)
+		goto error;
+#endif
+
+	result = DAWG_get_alphabet(dawg, &da->alphabet);
+	if (result != DAWG_OK)
+		goto error;
+
+	const size_t K = da->alphabet.size;
+
+	result = DAWG_NO_MEM;
+	nodes	= memalloc(N * sizeof(DAWGNode*));
+	bases	= memalloc(N * sizeof(uint32_t));
+	codes	= memalloc((K + 1) * sizeof(uint32_t));
+	if (nodes == NULL or bases == NULL or codes == NULL)
+		goto error;
+
+	result = da_builder_extend(&builder);
+	if (result != DAWG_OK)
+		goto error;
+
+	// 1. number states in BFS order
+	size_t head = 0;
+	size_t tail = 0;
+
+	nodes[tail] = dawg->q0;
+	if (addr_hashtable_add(&ids, dawg->q0, tail) < 0)
+		goto error;
+
+	tail += 1;
+	while (head < tail) {
+		DAWGNode* node = nodes[head++];
+		for (i=0; i < node->n; i++) {
+			DAWGNode* child = node->next[i].child;
+			if (addr_hashtable_get(&ids, child) == NULL) {
+				ASSERT(tail < N);
+				nodes[tail] = child;
+				if (addr_hashtable_add(&ids, child, tail) < 0)
+					goto error;
+
+				tail += 1;
+			}
+		}
+	}
+
+	ASSERT(tail == N);
+
+	// 2. place states; destination states are saved temporarily
+	//    in slot.base and replaced by bases in the next step
+	for (i=0; i < N; i++) {
+		DAWGNode* node = nodes[i];
+		if (node->n == 0) {
+			// no slot is owned by base 0
+			bases[i] = 0;
+			continue;
+		}
+
+		for (j=0; j < node->n; j++) {
+			codes[j] = DAWG_alphabet_code(&da->alphabet, node->next[j].letter);
+			ASSERT(codes[j] > 0);
+		}
+
+		uint32_t base;
+		result = da_builder_find_base(&builder, codes, node->n, &base);
+		if (result != DAWG_OK)
+			goto error;
+
+		bases[i] = base;
+
+#ifdef DAWG_PERFECT_HASHING
+		uint32_t skip = 0;
+#endif
+		for (j=0; j < node->n; j++) {
+			const size_t t = base + codes[j];
+			addr_HashListItem* item = addr_hashtable_get(&ids, node->next[j].child);
+			ASSERT(item);
+
+			result = da_builder_use(&builder, t);
+			if (result != DAWG_OK)
+				goto error;
+
+			builder.slots[t].check	= base;
+			builder.slots[t].base	= (uint32_t)item->data;
+#ifdef DAWG_PERFECT_HASHING
+			builder.slots[t].skip	= skip;
+			skip += node->next[j].child->number;
+#endif
+		}
+
+		// slots past base are used, thus base fits in arrays
+		builder.used_base[base] = 1;
+	}
+
+	// 3. replace destination states with their bases
+	for (i=0; i <= builder.last; i++) {
+		if (builder.used[i]) {
+			const uint32_t id = builder.slots[i].base;
+			builder.slots[i].base = bases[id] | (nodes[id]->eow ? DA_EOW_FLAG : 0);
+		}
+	}
+
+	// any state's base + code must fall into array
+	da->size	= builder.last + K + 1;
+	if (da_builder_reserve(&builder, da->size) != DAWG_OK) {
+		result = DAWG_NO_MEM;
+		goto error;
+	}
+
+	da->slots	= memrealloc(builder.slots, da->size * sizeof(DAWGDASlot));
+	if (da->slots == NULL)
+		da->slots = builder.slots;
+
+	builder.slots		= NULL;
+	da->root			= bases[0] | (dawg->q0->eow ? DA_EOW_FLAG : 0);
+	da->states_count	= N;
+	da->used_slots		= stats.edges_count;
+	da->words_count		= dawg->count;
+	da->longest_word	= dawg->longest_word;
+	result = DAWG_OK;
+
+error:
+	da_builder_free(&builder);
+	if (nodes)
+		memfree(nodes);
+	if (bases)
+		memfree(bases);
+	if (codes)
+		memfree(codes);
+
+	addr_hashtable_destroy(&ids);
+	if (result != DAWG_OK)
+		DAWG_da_free(da);
+
+	return result;
+}
+
+
+static void
+DAWG_da_get_stats(const DAWGDoubleArray* da, DAWGDAStatistics* stats) {
+	stats->states_count	= da->states_count;
+	stats->slots_count	= da->size;
+	stats->used_slots	= da->used_slots;
+	stats->alphabet_size= da->alphabet.size;
+	stats->size			= da->size * sizeof(DAWGDASlot) +
+						  da->alphabet.size * DAWG_LETTER_SIZE +
+						  da->alphabet.lut_size * sizeof(uint32_t);
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+static int
+DAWG_da_index2word(const DAWGDoubleArray* da, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen) {
+	ASSERT(da->slots);
+	// the empty word has no index
+	if (index < 1 or index > da->words_count - ((da->root & DA_EOW_FLAG) != 0))
+		return DAWG_NOT_EXISTS;
+
+	*wordlen = 0;
+	*word = (DAWG_LETTER_TYPE*)memalloc((da->longest_word + 1) * DAWG_LETTER_SIZE);
+	if (*word == NULL)
+		return DAWG_NO_MEM;
+
+	uint32_t state = da->root;
+	size_t count = index;
+	size_t code;
+	do {
+		// the last edge having less than count words before
+		const uint32_t base = state & DA_BASE_MASK;
+		const DAWGDASlot* edge = NULL;
+		uint32_t edge_code = 0;
+		for (code=1; code <= da->alphabet.size; code++) {
+			const DAWGDASlot* slot = &da->slots[base + code];
+			if (slot->check == base) {
+				if (slot->skip < count) {
+					edge = slot;
+					edge_code = code;
+				}
+				else
+					break;
+			}
+		}
+
+		ASSERT(edge);
+		(*word)[*wordlen] = DAWG_alphabet_letter(&da->alphabet, edge_code);
+		*wordlen += 1;
+
+		count -= edge->skip;
+		state  = edge->base;
+		if (state & DA_EOW_FLAG)
+			count -= 1;
+	}
+	while (count > 0);
+
+	return DAWG_EXISTS;
+}
+#endif
@@ -0,0 +1,123 @@
+/*
+	This is part of pydawg Python module.
+
+	Double-array (BASE/CHECK) representation of a closed DAWG.
+
+	Each state with outgoing edges gets unique base; edge labelled
+	by letter with code c leads from state s to slot base(s) + c.
+	Slot stores base of its owner (check) and base of destination
+	state, thus single transition costs single array access. Since
+	slots keep bases of destinations, not destinations, states shared
+	by many parents are placed just once.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_da_h_included__
+#define dawg_da_h_included__
+
+#include "common.h"
+#include "dawg.h"
+#include "dawg_alphabet.h"
+
+#define DA_EOW_FLAG		(0x80000000u)
+#define DA_BASE_MASK	(0x7fffffffu)
+#define DA_EMPTY		(0xffffffffu)
+
+typedef struct DAWGDASlot {
+	uint32_t	check;		///< base of owner state, DA_EMPTY for unused slots
+	uint32_t	base;		///< base of destination state, DA_EOW_FLAG marks final states
+#ifdef DAWG_PERFECT_HASHING
+	uint32_t	skip;		///< number of words reachable through edges with lesser letters
+#endif
+} DAWGDASlot;
+
+
+typedef struct DAWGDoubleArray {
+	DAWGDASlot*		slots;			///< slots, NULL if array is not compiled
+	size_t			size;			///< number of slots
+	uint32_t		root;			///< base of start state, DA_EOW_FLAG marks final state
+	DAWGAlphabet	alphabet;		///< letter => code translation
+
+	size_t			states_count;	///< number of states
+	size_t			used_slots;		///< number of used slots (== edges count)
+	uint64_t		words_count;	///< copy of DAWG.count
+	uint64_t		longest_word;	///< copy of DAWG.longest_word
+} DAWGDoubleArray;
+
+
+typedef struct DAWGDAStatistics {
+	size_t	states_count;
+	size_t	slots_count;
+	size_t	used_slots;
+	size_t	alphabet_size;
+	size_t	size;
+} DAWGDAStatistics;
+
+
+/* init empty array */
+static void
+DAWG_da_init(DAWGDoubleArray* da);
+
+
+/* free memory */
+static void
+DAWG_da_free(DAWGDoubleArray* da);
+
+
+/**	Build double-array from closed DAWG.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+		DAWG_TOO_BIG
+*/
+static int
+DAWG_da_compile(DAWG* dawg, DAWGDoubleArray* da);
+
+
+/* get statistics */
+static void
+DAWG_da_get_stats(const DAWGDoubleArray* da, DAWGDAStatistics* stats);
+
+
+/*
+	Letters out of alphabet have code 0; slot base + 0 is never
+	owned by state having given base, thus no extra check is needed.
+*/
+#define DA_TRANSITION(da, state, letter) \
+	(&(da)->slots[((state) & DA_BASE_MASK) + DAWG_alphabet_code(&(da)->alphabet, (letter))])
+
+#define DA_OWNS(slot, state) ((slot)->check == ((state) & DA_BASE_MASK))
+
+
+/* same as DAWG_exists */
+static bool PURE
+DAWG_da_exists(const DAWGDoubleArray* da, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_longest_prefix */
+static size_t PURE
+DAWG_da_longest_prefix(const DAWGDoubleArray* da, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_exists_ints */
+static void
+DAWG_da_exists_ints(const DAWGDoubleArray* da, const DAWGIntArray* keys, uint8_t* result);
+
+
+#ifdef DAWG_PERFECT_HASHING
+/* same as DAWG_mph_word2index */
+static size_t PURE
+DAWG_da_word2index(const DAWGDoubleArray* da, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_mph_index2word */
+static int
+DAWG_da_index2word(const DAWGDoubleArray* da, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen);
+#endif
+
+#endif
@@ -0,0 +1,273 @@
+/*
+	This is part of pydawg Python module.
+
+	Sets of fixed width integers: a key is saved as a word made of
+	its bytes in big-endian order, thus lexicographic order of words
+	is numeric order of keys, and keys sharing high bytes share
+	a prefix. In unicode modes a byte is a letter U+0000..U+00FF.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+/*	saves i-th key as big-endian bytes, returns false if it doesn't fit in width bytes;
+	buffer might be not aligned to size of item, items are copied */
+static bool
+int_array_key(const DAWGIntArray* keys, const size_t i, uint8_t* key) {
+	const uint8_t* ptr = (const uint8_t*)keys->data + i * keys->itemsize;
+	uint64_t value;
+	size_t j;
+
+	switch (keys->itemsize) {
+		case 1:
+			memcpy(key, (const uint8_t*)keys->data + i * keys->width, keys->width);
+			return true;
+
+		case 2:
+			{
+			uint16_t item;
+			memcpy(&item, ptr, 2);
+			value = item;
+			}
+			break;
+
+		case 4:
+			{
+			uint32_t item;
+			memcpy(&item, ptr, 4);
+			value = item;
+			}
+			break;
+
+		default:
+			ASSERT(keys->itemsize == 8);
+			memcpy(&value, ptr, 8);
+			break;
+	}
+
+	if (keys->width < 8 and (value >> (8 * keys->width)) != 0)
+		return false;
+
+	for (j=keys->width; j > 0; j--) {
+		key[j - 1] = value & 0xff;
+		value >>= 8;
+	}
+
+	return true;
+}
+
+
+/* converts key to word, returns word length */
+static size_t
+int_key_word(const uint8_t* key, const size_t width, DAWG_LETTER_TYPE* word) {
+	size_t i;
+#ifdef DAWG_UTF8
+	size_t n = 0;
+	for (i=0; i < width; i++) {
+		if (key[i] < 0x80)
+			word[n++] = key[i];
+		else {
+			word[n++] = 0xc0 | (key[i] >> 6);
+			word[n++] = 0x80 | (key[i] & 0x3f);
+		}
+	}
+
+	return n;
+#else
+	for (i=0; i < width; i++)
+		word[i] = key[i];
+
+	return width;
+#endif
+}
+
+
+static int
+DAWG_add_ints(DAWG* dawg, const DAWGIntArray* keys, size_t* processed, size_t* added) {
+	uint8_t key[DAWG_INT_MAX_WIDTH];
+	DAWG_LETTER_TYPE chars[2 * DAWG_INT_MAX_WIDTH];
+	String word;
+	size_t i;
+	int ret;
+
+	ASSERT(keys->width >= 1 and keys->width <= DAWG_INT_MAX_WIDTH);
+
+	*added = 0;
+	word.chars = chars;
+	for (i=0; i < keys->count; i++) {
+		*processed = i;
+		if (not int_array_key(keys, i, key))
+			return DAWG_TOO_BIG;
+
+		word.length = int_key_word(key, keys->width, chars);
+		ret = DAWG_add_word(dawg, word);
+		if (ret < 0)
+			return ret;
+
+		*added += ret;
+	}
+
+	*processed = keys->count;
+	return DAWG_OK;
+}
+
+
+static void
+DAWG_exists_ints(DAWG* dawg, const DAWGIntArray* keys, uint8_t* result) {
+	uint8_t key[DAWG_INT_MAX_WIDTH];
+	DAWG_LETTER_TYPE word[2 * DAWG_INT_MAX_WIDTH];
+	size_t i;
+
+	for (i=0; i < keys->count; i++) {
+		if (int_array_key(keys, i, key))
+			result[i] = DAWG_exists(dawg, word, int_key_word(key, keys->width, word));
+		else
+			result[i] = 0;
+	}
+}
+
+
+static void
+DAWG_da_exists_ints(const DAWGDoubleArray* da, const DAWGIntArray* keys, uint8_t* result) {
+	uint8_t key[DAWG_INT_MAX_WIDTH];
+	DAWG_LETTER_TYPE word[2 * DAWG_INT_MAX_WIDTH];
+	size_t i;
+
+	for (i=0; i < keys->count; i++) {
+		if (int_array_key(keys, i, key))
+			result[i] = DAWG_da_exists(da, word, int_key_word(key, keys->width, word));
+		else
+			result[i] = 0;
+	}
+}
+
+
+typedef struct IntRangeAux {
+	uint8_t		lo[DAWG_INT_MAX_WIDTH];	///< the least key, big-endian
+	uint8_t		hi[DAWG_INT_MAX_WIDTH];	///< the greatest key, big-endian
+	size_t		width;
+
+	uint64_t*	keys;		///< keys found so far
+	size_t		count;
+	size_t		capacity;
+} IntRangeAux;
+
+
+static int
+int_range_visit(IntRangeAux* aux, const DAWGNode* node, const size_t depth, const uint64_t prefix, const bool at_lo, const bool at_hi);
+
+
+/* follow edge labelled with byte, if it doesn't leave the range */
+static int
+int_range_edge(IntRangeAux* aux, const DAWGNode* child, const size_t depth, const uint64_t prefix, const bool at_lo, const bool at_hi, const uint8_t byte) {
+	if (at_lo and byte < aux->lo[depth])
+		return DAWG_OK;
+
+	if (at_hi and byte > aux->hi[depth])
+		return DAWG_OK;
+
+	return int_range_visit(
+				aux,
+				child,
+				depth + 1,
+				(prefix << 8) | byte,
+				at_lo and byte == aux->lo[depth],
+				at_hi and byte == aux->hi[depth]
+			);
+}
+
+
+/*	at_lo/at_hi - path from root is equal to prefix of the least/greatest
+	key, then next byte can't be less/greater than byte of the key
+*/
+static int
+int_range_visit(IntRangeAux* aux, const DAWGNode* node, const size_t depth, const uint64_t prefix, const bool at_lo, const bool at_hi) {
+	size_t i;
+	int ret;
+
+	if (depth == aux->width) {
+		if (not node->eow)
+			return DAWG_OK;
+
+		if (aux->count == aux->capacity) {
+			const size_t capacity = aux->capacity ? 2 * aux->capacity : 1024;
+			uint64_t* tmp = (uint64_t*)PyMem_RawRealloc(aux->keys, capacity * sizeof(uint64_t));
+			if (tmp == NULL)
+				return DAWG_NO_MEM;
+
+			aux->keys		= tmp;
+			aux->capacity	= capacity;
+		}
+
+		aux->keys[aux->count++] = prefix;
+		return DAWG_OK;
+	}
+
+	// edges are sorted by letter, keys are found in increasing order
+	for (i=0; i < node->n; i++) {
+		const DAWG_LETTER_TYPE letter = node->next[i].letter;
+		const DAWGNode* child = node->next[i].child;
+#ifdef DAWG_UTF8
+		if (letter >= 0x80) {
+			// bytes 0x80..0xff are two letters: 0xc2 or 0xc3, and 0x80..0xbf
+			if (letter != 0xc2 and letter != 0xc3)
+				continue;
+
+			size_t j;
+			for (j=0; j < child->n; j++) {
+				const DAWG_LETTER_TYPE cont = child->next[j].letter;
+				if ((cont & 0xc0) != 0x80)
+					continue;
+
+				ret = int_range_edge(aux, child->next[j].child, depth, prefix, at_lo, at_hi, ((letter & 0x1f) << 6) | (cont & 0x3f));
+				if (ret != DAWG_OK)
+					return ret;
+			}
+
+			continue;
+		}
+#elif defined(DAWG_UNICODE)
+		if (letter > 0xff)
+			break;
+#endif
+
+		ret = int_range_edge(aux, child, depth, prefix, at_lo, at_hi, (uint8_t)letter);
+		if (ret != DAWG_OK)
+			return ret;
+	}
+
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_find_ints(DAWG* dawg, const uint64_t lo, const uint64_t hi, const size_t width, uint64_t** keys, size_t* count) {
+	IntRangeAux aux;
+	size_t i;
+
+	ASSERT(width >= 1 and width <= DAWG_INT_MAX_WIDTH);
+
+	aux.width		= width;
+	aux.keys		= NULL;
+	aux.count		= 0;
+	aux.capacity	= 0;
+	for (i=0; i < width; i++) {
+		aux.lo[i] = (lo >> (8 * (width - 1 - i))) & 0xff;
+		aux.hi[i] = (hi >> (8 * (width - 1 - i))) & 0xff;
+	}
+
+	if (dawg->q0 and lo <= hi) {
+		if (int_range_visit(&aux, dawg->q0, 0, 0, true, true) != DAWG_OK) {
+			if (aux.keys)
+				PyMem_RawFree(aux.keys);
+
+			return DAWG_NO_MEM;
+		}
+	}
+
+	*keys	= aux.keys;
+	*count	= aux.count;
+	return DAWG_OK;
+}
@@ -0,0 +1,84 @@
+/*
+	This is part of pydawg Python module.
+
+	Jump table of closed DAWG.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+static void
+DAWG_jump_init(DAWGJump* jump) {
+	jump->depth		= 0;
+	jump->stride	= 0;
+	jump->size		= 0;
+	jump->nodes		= NULL;
+}
+
+
+static void
+DAWG_jump_free(DAWGJump* jump) {
+	if (jump->nodes)
+		memfree(jump->nodes);
+
+	DAWG_jump_init(jump);
+}
+
+
+static int
+DAWG_jump_build(DAWG* dawg, int depth) {
+	ASSERT(dawg);
+	ASSERT(depth >= 0 and depth <= DAWG_JUMP_MAX_DEPTH);
+
+	DAWGJump* jump = &dawg->jump;
+	size_t size = 0;
+	size_t i, j;
+
+	DAWG_jump_free(jump);
+
+	// codes of letters are required
+	if (dawg->state != CLOSED or dawg->q0 == NULL or dawg->alphabet.letters == NULL)
+		return DAWG_OK;
+
+	const size_t stride = dawg->alphabet.size + 1;
+	while (depth > 0) {
+		size = (depth == 1) ? stride : stride * stride;
+		if (size <= DAWG_JUMP_MAX_SIZE)
+			break;
+
+		depth -= 1;
+	}
+
+	if (depth == 0)
+		return DAWG_OK;
+
+	jump->nodes = (DAWGNode**)memcalloc(size, sizeof(DAWGNode*));
+	if (jump->nodes == NULL)
+		return DAWG_NO_MEM;
+
+	DAWGNode* q0 = dawg->q0;
+	for (i=0; i < q0->n; i++) {
+		DAWGNode* child = q0->next[i].child;
+		const size_t c1 = DAWG_alphabet_code(&dawg->alphabet, q0->next[i].letter);
+		ASSERT(c1 > 0);
+
+		if (depth == 1) {
+			jump->nodes[c1] = child;
+			continue;
+		}
+
+		for (j=0; j < child->n; j++) {
+			const size_t c2 = DAWG_alphabet_code(&dawg->alphabet, child->next[j].letter);
+			ASSERT(c2 > 0);
+
+			jump->nodes[c1 * stride + c2] = child->next[j].child;
+		}
+	}
+
+	jump->depth		= depth;
+	jump->stride	= stride;
+	jump->size		= size;
+	return DAWG_OK;
+}
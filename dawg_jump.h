@@ -0,0 +1,40 @@
+/*
+	This is part of pydawg Python module.
+
+	Jump table of closed DAWG -- nodes reached by the first one or
+	two letters, indexed by alphabet codes. Lookups start already
+	depth levels below the root, the widest nodes of graph are
+	not searched.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_jump_h_included__
+#define dawg_jump_h_included__
+
+#include "common.h"
+#include "dawgnode.h"
+
+#define DAWG_JUMP_MAX_DEPTH	2
+#define DAWG_JUMP_MAX_SIZE	(0x10000)	///< max number of entries
+
+typedef struct DAWGJump {
+	int		depth;			///< number of letters resolved by table, 0 if there is no table
+	size_t	stride;			///< alphabet size + 1
+	size_t	size;			///< number of entries, stride ** depth
+	DAWGNode**	nodes;		///< node reached by letters of codes c1 (,c2), entry c1 (* stride + c2); NULL if path doesn't exist
+} DAWGJump;
+
+
+/* init empty table */
+static void
+DAWG_jump_init(DAWGJump* jump);
+
+
+/* free memory */
+static void
+DAWG_jump_free(DAWGJump* jump);
+
+#endif
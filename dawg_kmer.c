@@ -0,0 +1,392 @@
+/*
+	This is part of pydawg Python module.
+
+	DAWG of fixed length DNA words.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "dawg_kmer.h"
+
+
+static void
+DAWG_kmer_init(DAWGKmer* kmer) {
+	kmer->k				= 0;
+	kmer->canonical		= false;
+	kmer->words_count	= 0;
+	kmer->nodes_count	= 0;
+	kmer->nodes			= NULL;
+}
+
+
+static void
+DAWG_kmer_free(DAWGKmer* kmer) {
+	if (kmer->nodes)
+		PyMem_RawFree(kmer->nodes);
+
+	DAWG_kmer_init(kmer);
+}
+
+
+static int
+DAWG_kmer_base(const uint32_t letter) {
+	switch (letter) {
+		case 'A': case 'a':
+			return 0;
+
+		case 'C': case 'c':
+			return 1;
+
+		case 'G': case 'g':
+			return 2;
+
+		case 'T': case 't':
+			return 3;
+
+		default:
+			return -1;
+	}
+}
+
+
+static uint64_t
+DAWG_kmer_mask(const int k) {
+	ASSERT(k >= 1 and k <= KMER_MAX_K);
+	if (k == KMER_MAX_K)
+		return UINT64_MAX;
+	else
+		return (UINT64_C(1) << (2*k)) - 1;
+}
+
+
+static uint64_t
+DAWG_kmer_revcomp(uint64_t word, const int k) {
+	// complement of base b is 3 - b, i.e. negation of its bits
+	word = ~word;
+
+	// reverse order of 2-bit fields
+	word = ((word >> 2)  & UINT64_C(0x3333333333333333)) | ((word & UINT64_C(0x3333333333333333)) << 2);
+	word = ((word >> 4)  & UINT64_C(0x0f0f0f0f0f0f0f0f)) | ((word & UINT64_C(0x0f0f0f0f0f0f0f0f)) << 4);
+	word = ((word >> 8)  & UINT64_C(0x00ff00ff00ff00ff)) | ((word & UINT64_C(0x00ff00ff00ff00ff)) << 8);
+	word = ((word >> 16) & UINT64_C(0x0000ffff0000ffff)) | ((word & UINT64_C(0x0000ffff0000ffff)) << 16);
+	word = (word >> 32) | (word << 32);
+
+	return word >> (2*(KMER_MAX_K - k));
+}
+
+
+static uint64_t
+DAWG_kmer_canonical(const uint64_t word, const int k) {
+	const uint64_t rc = DAWG_kmer_revcomp(word, k);
+	return (rc < word) ? rc : word;
+}
+
+
+static int
+kmer_compare(const void* a, const void* b) {
+	const uint64_t x = *(const uint64_t*)a;
+	const uint64_t y = *(const uint64_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+
+typedef struct KmerAux {
+	DAWGKmerNode*	nodes;
+	size_t		count;
+	size_t		capacity;
+
+	uint32_t*	table;	///< hash table of node ids of current level, 0 is empty slot
+	size_t		mask;
+} KmerAux;
+
+
+static size_t
+kmer_hash(const DAWGKmerNode* node) {
+	const uint64_t a = node->child[0] | ((uint64_t)node->child[1] << 32);
+	const uint64_t b = node->child[2] | ((uint64_t)node->child[3] << 32);
+
+	uint64_t h = (a * UINT64_C(0x9e3779b97f4a7c15)) ^ b;
+	h *= UINT64_C(0xff51afd7ed558ccd);
+	return (size_t)(h ^ (h >> 32));
+}
+
+
+/* find node equal to given one on current level, or add a new one */
+static int
+kmer_register(KmerAux* aux, const DAWGKmerNode* node, uint32_t* id) {
+	size_t i = kmer_hash(node) & aux->mask;
+	while (aux->table[i]) {
+		if (memcmp(&aux->nodes[aux->table[i]], node, sizeof(DAWGKmerNode)) == 0) {
+			*id = aux->table[i];
+			return DAWG_OK;
+		}
+
+		i = (i + 1) & aux->mask;
+	}
+
+	if (aux->count == aux->capacity) {
+		if (aux->count >= UINT32_MAX)
+			return DAWG_TOO_BIG;
+
+		const size_t capacity = 2 * aux->capacity;
+		DAWGKmerNode* tmp = (DAWGKmerNode*)PyMem_RawRealloc(aux->nodes, capacity * sizeof(DAWGKmerNode));
+		if (tmp == NULL)
+			return DAWG_NO_MEM;
+
+		aux->nodes		= tmp;
+		aux->capacity	= capacity;
+	}
+
+	aux->nodes[aux->count] = *node;
+	aux->table[i] = *id = (uint32_t)aux->count++;
+
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_kmer_build(DAWGKmer* kmer, uint64_t* words, size_t n, const int k, const bool canonical) {
+	ASSERT(kmer);
+	ASSERT(k >= 1 and k <= KMER_MAX_K);
+
+	KmerAux aux;
+	uint32_t* ids = NULL;
+	size_t table_size;
+	size_t i, j, m;
+	int level;
+	int ret;
+
+	DAWG_kmer_free(kmer);
+
+	if (canonical)
+		for (i=0; i < n; i++)
+			words[i] = DAWG_kmer_canonical(words[i], k);
+
+	qsort(words, n, sizeof(uint64_t), kmer_compare);
+
+	// remove duplicates
+	for (i=0, j=0; i < n; i++)
+		if (j == 0 or words[j - 1] != words[i])
+			words[j++] = words[i];
+
+	n = j;
+
+	aux.count		= 2;	// dead node and the final node
+	aux.capacity	= 1024;
+	aux.nodes		= (DAWGKmerNode*)PyMem_RawMalloc(aux.capacity * sizeof(DAWGKmerNode));
+	aux.table		= NULL;
+	aux.mask		= 0;
+
+	if (aux.nodes == NULL)
+		goto no_mem;
+
+	memset(aux.nodes, 0, 2 * sizeof(DAWGKmerNode));
+	if (n == 0) {
+		// the root without children
+		kmer->nodes_count = 2;
+		goto done;
+	}
+
+	table_size = 1;
+	while (table_size < 2*n)
+		table_size *= 2;
+
+	aux.table = (uint32_t*)PyMem_RawMalloc(table_size * sizeof(uint32_t));
+	ids = (uint32_t*)PyMem_RawMalloc(n * sizeof(uint32_t));
+	if (aux.table == NULL or ids == NULL)
+		goto no_mem;
+
+	// words[0..m) are distinct prefixes of the current level,
+	// ids[i] is the node reached by words[i]; nodes are built
+	// bottom-up, all words end in the final node
+	for (i=0; i < n; i++)
+		ids[i] = 1;
+
+	m = n;
+	for (level = k - 1; level >= 0; level--) {
+		size_t size = 1;
+		while (size < 2*m)
+			size *= 2;
+
+		aux.mask = size - 1;
+		memset(aux.table, 0, size * sizeof(uint32_t));
+
+		i = 0;
+		j = 0;
+		while (i < m) {
+			const uint64_t prefix = words[i] >> 2;
+			DAWGKmerNode node = {{0, 0, 0, 0}};
+
+			do {
+				node.child[words[i] & 3] = ids[i];
+				i += 1;
+			} while (i < m and (words[i] >> 2) == prefix);
+
+			ret = kmer_register(&aux, &node, &ids[j]);
+			if (ret != DAWG_OK)
+				goto error;
+
+			words[j] = prefix;
+			j += 1;
+		}
+
+		m = j;
+	}
+
+	ASSERT(m == 1);
+	ASSERT(ids[0] == aux.count - 1);
+
+	// renumber nodes top-down: id => count - id, then the root is 1
+	for (i=1; i < aux.count; i++)
+		for (j=0; j < 4; j++)
+			if (aux.nodes[i].child[j])
+				aux.nodes[i].child[j] = (uint32_t)(aux.count - aux.nodes[i].child[j]);
+
+	for (i=1, j=aux.count - 1; i < j; i++, j--) {
+		const DAWGKmerNode tmp = aux.nodes[i];
+		aux.nodes[i] = aux.nodes[j];
+		aux.nodes[j] = tmp;
+	}
+
+	kmer->nodes_count = aux.count;
+
+done:
+	kmer->nodes = (DAWGKmerNode*)PyMem_RawRealloc(aux.nodes, kmer->nodes_count * sizeof(DAWGKmerNode));
+	if (kmer->nodes == NULL)
+		kmer->nodes = aux.nodes;
+
+	kmer->k				= k;
+	kmer->canonical		= canonical;
+	kmer->words_count	= n;
+
+	if (aux.table)
+		PyMem_RawFree(aux.table);
+
+	if (ids)
+		PyMem_RawFree(ids);
+
+	return DAWG_OK;
+
+no_mem:
+	ret = DAWG_NO_MEM;
+
+error:
+	if (aux.nodes)
+		PyMem_RawFree(aux.nodes);
+
+	if (aux.table)
+		PyMem_RawFree(aux.table);
+
+	if (ids)
+		PyMem_RawFree(ids);
+
+	DAWG_kmer_init(kmer);
+	return ret;
+}
+
+
+static void
+DAWG_kmer_get_stats(const DAWGKmer* kmer, DAWGKmerStatistics* stats) {
+	stats->k			= kmer->k;
+	stats->words_count	= kmer->words_count;
+	stats->nodes_count	= kmer->nodes_count;
+	stats->size			= kmer->nodes_count * sizeof(DAWGKmerNode);
+}
+
+
+static bool PURE
+DAWG_kmer_exists(const DAWGKmer* kmer, uint64_t word) {
+	if (UNLIKELY(kmer->nodes == NULL or (word & ~DAWG_kmer_mask(kmer->k))))
+		return false;
+
+	if (kmer->canonical)
+		word = DAWG_kmer_canonical(word, kmer->k);
+
+	const DAWGKmerNode* nodes = kmer->nodes;
+	uint32_t state = 1;
+	int shift;
+	for (shift = 2*(kmer->k - 1); shift >= 0; shift -= 2)
+		state = nodes[state].child[(word >> shift) & 3];
+
+	return state != 0;
+}
+
+
+#define KMER_BATCH 8
+
+static void
+DAWG_kmer_exists_many(const DAWGKmer* kmer, const uint64_t* words, const size_t n, uint8_t* result) {
+	if (UNLIKELY(kmer->nodes == NULL)) {
+		memset(result, 0, n);
+		return;
+	}
+
+	const DAWGKmerNode* nodes = kmer->nodes;
+	const uint64_t mask = DAWG_kmer_mask(kmer->k);
+	uint64_t batch[KMER_BATCH];
+	uint32_t state[KMER_BATCH];
+	size_t i, j;
+	int shift;
+
+	// all words have the same length, thus a batch of words walks
+	// the levels in lockstep and independent loads overlap
+	for (i=0; i + KMER_BATCH <= n; i += KMER_BATCH) {
+		for (j=0; j < KMER_BATCH; j++) {
+			batch[j] = words[i + j];
+			if (kmer->canonical)
+				batch[j] = DAWG_kmer_canonical(batch[j], kmer->k);
+
+			state[j] = (batch[j] & ~mask) ? 0 : 1;
+		}
+
+		for (shift = 2*(kmer->k - 1); shift >= 0; shift -= 2)
+			for (j=0; j < KMER_BATCH; j++)
+				state[j] = nodes[state[j]].child[(batch[j] >> shift) & 3];
+
+		for (j=0; j < KMER_BATCH; j++)
+			result[i + j] = (state[j] != 0);
+	}
+
+	for (/**/; i < n; i++)
+		result[i] = DAWG_kmer_exists(kmer, words[i]);
+}
+
+#undef KMER_BATCH
+
+
+static void
+DAWG_kmer_words(const DAWGKmer* kmer, uint64_t* words) {
+	if (kmer->words_count == 0)
+		return;
+
+	uint32_t node[KMER_MAX_K + 1];
+	int base[KMER_MAX_K + 1];
+	uint64_t prefix = 0;
+	int depth = 0;
+
+	node[0] = 1;
+	base[0] = 0;
+	while (depth >= 0) {
+		if (depth == kmer->k or base[depth] == 4) {
+			if (depth == kmer->k)
+				*words++ = prefix;
+
+			prefix >>= 2;
+			depth -= 1;
+			continue;
+		}
+
+		const int b = base[depth]++;
+		const uint32_t child = kmer->nodes[node[depth]].child[b];
+		if (child) {
+			prefix = (prefix << 2) | b;
+			depth += 1;
+			node[depth] = child;
+			base[depth] = 0;
+		}
+	}
+}
@@ -0,0 +1,114 @@
+/*
+	This is part of pydawg Python module.
+
+	Read-only DAWG of fixed length DNA words (k-mers).
+
+	Bases A, C, G, T are coded on 2 bits (0, 1, 2, 3), a k-mer is
+	packed into an integer, the first base occupies the most
+	significant bits -- thus numeric order of packed k-mers is
+	lexicographic order of words.
+
+	Every node has four child slots, one per base. Node 0 is the dead
+	node: all its slots point to itself, so lookup always makes exactly
+	k transitions without any branch and the word exists iff final
+	state is not 0. Node 1 is the root, nodes are laid out level by level.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_kmer_h_included__
+#define dawg_kmer_h_included__
+
+#include "common.h"
+
+#define KMER_MAX_K	32
+
+
+typedef struct DAWGKmerNode {
+	uint32_t	child[4];	///< child for each base, 0 is the dead node
+} DAWGKmerNode;
+
+
+typedef struct DAWGKmer {
+	int		k;				///< length of words
+	bool	canonical;		///< words are stored as canonical k-mers
+	size_t	words_count;
+	size_t	nodes_count;	///< including the dead node
+	DAWGKmerNode*	nodes;
+} DAWGKmer;
+
+
+typedef struct DAWGKmerStatistics {
+	size_t	k;
+	size_t	words_count;
+	size_t	nodes_count;
+	size_t	size;
+} DAWGKmerStatistics;
+
+
+/* init empty structure */
+static void
+DAWG_kmer_init(DAWGKmer* kmer);
+
+
+/* free memory */
+static void
+DAWG_kmer_free(DAWGKmer* kmer);
+
+
+/* returns code of base (0..3) or -1 */
+static int
+DAWG_kmer_base(const uint32_t letter);
+
+
+/* mask of valid bits of k-mer */
+static uint64_t
+DAWG_kmer_mask(const int k);
+
+
+/* returns reverse complement of k-mer */
+static uint64_t
+DAWG_kmer_revcomp(uint64_t word, const int k);
+
+
+/* returns lesser of k-mer and its reverse complement */
+static uint64_t
+DAWG_kmer_canonical(const uint64_t word, const int k);
+
+
+/**	Build DAWG from array of packed k-mers; values have to
+	be valid k-mers, array is modified (sorted, canonized).
+	Function is called without GIL, nodes are allocated with
+	raw allocator.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_TOO_BIG
+*/
+static int
+DAWG_kmer_build(DAWGKmer* kmer, uint64_t* words, size_t n, const int k, const bool canonical);
+
+
+/* get statistics */
+static void
+DAWG_kmer_get_stats(const DAWGKmer* kmer, DAWGKmerStatistics* stats);
+
+
+/* check if k-mer exists (reverse complement is checked in canonical mode) */
+static bool PURE
+DAWG_kmer_exists(const DAWGKmer* kmer, uint64_t word);
+
+
+/* result[i] = DAWG_kmer_exists(kmer, words[i]) */
+static void
+DAWG_kmer_exists_many(const DAWGKmer* kmer, const uint64_t* words, const size_t n, uint8_t* result);
+
+
+/* save all k-mers in array of words_count items, in increasing order */
+static void
+DAWG_kmer_words(const DAWGKmer* kmer, uint64_t* words);
+
+#endif
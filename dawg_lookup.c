@@ -0,0 +1,247 @@
+/*
+	This is part of pydawg Python module.
+
+	Lookup procedures template.
+	This file is included directly in dawg.c.
+
+	Words are arrays of LOOKUP_CHAR_TYPE; letters are widened to
+	DAWG_LETTER_TYPE while the graph is walked. Besides the instance
+	for DAWG_LETTER_TYPE, in unicode mode functions are instantiated
+	for narrow PEP 393 kinds (Py_UCS1, Py_UCS2), so str objects are
+	queried in place, without converting them to UCS-4.
+
+	Parameters:
+	- LOOKUP_CHAR_TYPE	--- type of letters of a word
+	- LOOKUP_NAME(name)	--- name of function instance
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#define L LOOKUP_NAME
+
+static size_t PURE
+L(DAWG_alphabet_prefix)(const DAWGAlphabet* alphabet, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	size_t i;
+
+	if (alphabet->letters == NULL)
+		return wordlen;
+
+	for (i=0; i < wordlen; i++)
+		if (DAWG_alphabet_code(alphabet, word[i]) == 0)
+			break;
+
+	return i;
+}
+
+
+/*	node reached by the first letters, taken from jump table; returns
+	number of letters consumed, 0 if table can't be used. Letters have
+	to be in alphabet.
+*/
+static size_t
+L(DAWG_jump)(const DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen, DAWGNode** node) {
+	const DAWGJump* jump = &dawg->jump;
+
+	if (jump->depth == 0 or wordlen < (size_t)jump->depth)
+		return 0;
+
+	size_t index = DAWG_alphabet_code(&dawg->alphabet, word[0]);
+	if (jump->depth == 2)
+		index = index * jump->stride + DAWG_alphabet_code(&dawg->alphabet, word[1]);
+
+	*node = jump->nodes[index];
+	return jump->depth;
+}
+
+
+static bool PURE
+L(DAWG_exists)(DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(dawg);
+
+	size_t i=0;
+	DAWGNode* node = dawg->q0;
+
+	if (L(DAWG_alphabet_prefix)(&dawg->alphabet, word, wordlen) < wordlen)
+		return false;
+
+	i = L(DAWG_jump)(dawg, word, wordlen, &node);
+	if (node == NULL)
+		return false;
+
+	for (/**/; i < wordlen; i++) {
+		node = dawgnode_get_child(node, word[i]);
+		if (node == NULL) {
+			return false;
+		}
+	}
+
+	return node->eow;
+}
+
+
+static size_t PURE
+L(DAWG_longest_prefix)(DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(dawg);
+
+	DAWGNode* node = dawg->q0;
+	const size_t n = L(DAWG_alphabet_prefix)(&dawg->alphabet, word, wordlen);
+	size_t i = L(DAWG_jump)(dawg, word, n, &node);
+	if (node == NULL) {
+		// path ends within the first letters
+		node = dawg->q0;
+		i = 0;
+	}
+
+	for (/**/; i < n; i++) {
+		node = dawgnode_get_child(node, word[i]);
+		if (node == NULL) {
+			break;
+		}
+	}
+
+	return i;
+}
+
+
+static bool
+L(DAWG_profile_exists)(DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(dawg->profile);
+
+	size_t i=0;
+	DAWGNode* node = dawg->q0;
+
+	if (L(DAWG_alphabet_prefix)(&dawg->alphabet, word, wordlen) < wordlen)
+		return false;
+
+	DAWG_profile_visit(dawg, node);
+	for (/**/; i < wordlen; i++) {
+		node = dawgnode_get_child(node, word[i]);
+		if (node == NULL) {
+			return false;
+		}
+
+		DAWG_profile_visit(dawg, node);
+	}
+
+	return node->eow;
+}
+
+
+static size_t
+L(DAWG_profile_longest_prefix)(DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(dawg->profile);
+
+	DAWGNode* node = dawg->q0;
+	const size_t n = L(DAWG_alphabet_prefix)(&dawg->alphabet, word, wordlen);
+	size_t i=0;
+
+	DAWG_profile_visit(dawg, node);
+	for (/**/; i < n; i++) {
+		node = dawgnode_get_child(node, word[i]);
+		if (node == NULL) {
+			break;
+		}
+
+		DAWG_profile_visit(dawg, node);
+	}
+
+	return i;
+}
+
+
+static bool PURE
+L(DAWG_da_exists)(const DAWGDoubleArray* da, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(da->slots);
+
+	uint32_t state = da->root;
+	size_t i;
+	for (i=0; i < wordlen; i++) {
+		const DAWGDASlot* slot = DA_TRANSITION(da, state, word[i]);
+		if (not DA_OWNS(slot, state))
+			return false;
+
+		state = slot->base;
+	}
+
+	return (state & DA_EOW_FLAG) != 0;
+}
+
+
+static size_t PURE
+L(DAWG_da_longest_prefix)(const DAWGDoubleArray* da, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(da->slots);
+
+	uint32_t state = da->root;
+	size_t i;
+	for (i=0; i < wordlen; i++) {
+		const DAWGDASlot* slot = DA_TRANSITION(da, state, word[i]);
+		if (not DA_OWNS(slot, state))
+			break;
+
+		state = slot->base;
+	}
+
+	return i;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+static size_t
+L(DAWG_mph_word2index)(DAWG* dawg, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	size_t index = 0;
+
+	size_t i, j;
+	DAWGNode* state;
+	DAWGNode* next;
+
+	if (L(DAWG_alphabet_prefix)(&dawg->alphabet, word, wordlen) < wordlen)
+		return DAWG_NOT_EXISTS;
+
+	state = dawg->q0;
+	for (i = 0; i < wordlen; i++) {
+		const DAWG_LETTER_TYPE c = word[i];
+		next = dawgnode_get_child(state, c);
+		if (next) {
+			for (j=0; j < state->n; j++)
+				if (state->next[j].letter < c)
+					index += state->next[j].child->number;
+
+			state = next;
+			if (state->eow)
+				index += 1;
+		}
+		else
+			return DAWG_NOT_EXISTS;
+	}
+
+	return state->eow ? index : DAWG_NOT_EXISTS;
+}
+
+
+static size_t PURE
+L(DAWG_da_word2index)(const DAWGDoubleArray* da, const LOOKUP_CHAR_TYPE* word, const size_t wordlen) {
+	ASSERT(da->slots);
+
+	size_t index = 0;
+	uint32_t state = da->root;
+	size_t i;
+	for (i=0; i < wordlen; i++) {
+		const DAWGDASlot* slot = DA_TRANSITION(da, state, word[i]);
+		if (not DA_OWNS(slot, state))
+			return DAWG_NOT_EXISTS;
+
+		index += slot->skip;
+		state  = slot->base;
+		if (state & DA_EOW_FLAG)
+			index += 1;
+	}
+
+	return (state & DA_EOW_FLAG) ? index : DAWG_NOT_EXISTS;
+}
+#endif
+
+#undef L
+#undef LOOKUP_CHAR_TYPE
+#undef LOOKUP_NAME
@@ -26,46 +26,38 @@ DAWG_mph_numerate_nodes_aux(DAWGNode* node, UNUSED const size_t depth, UNUSED vo
 	return 1;
 }
 
-static void
+static int
 DAWG_mph_numerate_nodes(DAWG* dawg) {
 	ASSERT(dawg);
-	DAWG_traverse_DFS_once(dawg, DAWG_mph_numerate_nodes_aux, NULL);
+	if (DAWG_traverse_DFS_once(dawg, DAWG_mph_numerate_nodes_aux, NULL) < 0)
+		return DAWG_NO_MEM;
+	else
+		return DAWG_OK;
 }
 
 
-static size_t
-DAWG_mph_word2index(DAWG* dawg, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
-	size_t index = 0;
-
+static bool PURE
+DAWG_mph_check_numbers(const DAWGNode* nodes, const size_t nodes_count) {
 	size_t i, j;
-	DAWGNode* state;
-	DAWGNode* next;
-
-	state = dawg->q0;
-	for (i = 0; i < wordlen; i++) {
-		const DAWG_LETTER_TYPE c = word[i];
-		next = dawgnode_get_child(state, c);
-		if (next) {
-			for (j=0; j < state->n; j++)
-				if (state->next[j].letter < c)
-					index += state->next[j].child->number;
-
-			state = next;
-			if (state->eow)
-				index += 1;
-		}
-		else
-			return DAWG_NOT_EXISTS;
+	for (i=0; i < nodes_count; i++) {
+		const DAWGNode* node = &nodes[i];
+		uint64_t number = (node->eow != 0);
+		for (j=0; j < node->n; j++)
+			number += (uint64_t)node->next[j].child->number;
+
+		if (number != (uint64_t)node->number)
+			return false;
 	}
 
-	return state->eow ? index : DAWG_NOT_EXISTS;
+	return true;
 }
 
 
 static int
 DAWG_mph_index2word(DAWG* dawg, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen) {
 	ASSERT(dawg);
-	if (index < 1 or index > dawg->count)
+	// the empty word has no index
+	if (index < 1 or index > dawg->count - (dawg->q0 and dawg->q0->eow))
 		return DAWG_NOT_EXISTS;
 
 	*wordlen = 0;
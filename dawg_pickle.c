@@ -24,434 +24,1237 @@
 
 #define HASH_GET_LIST_UNUSED
 #define HASH_DEL_UNUSED
+#define HASH_RESIZE_UNUSED
 
 #include "hash/hashtable.c"
 // hashtable type
 
 
-typedef struct SaveAux {
-	bool error;
-	addr_HashTable LUT;
-
-	int 	id;
-	size_t	size;
-	size_t	top;
-	uint8_t* 	array;
-} SaveAux;
+/*
+	Ids of nodes saved in image: position in BFS order. If block of
+	nodes is already in BFS order, id is position of node and nothing
+	is allocated. Otherwise, if nodes are placed in a block, ids are
+	kept in a dense array indexed by position of node; else in open
+	addressing table sized for all nodes.
+*/
+typedef struct NodeIds {
+	DAWGNode*	base;		///< nodes block or NULL
+	nodeid_t*	ids;		///< id of node base[i] (NULL if it's i), or id of keys[i]
+	DAWGNode**	keys;		///< hash table of nodes
+	int			shift;		///< hash(node) >> shift is a slot index
+} NodeIds;
+
+
+static size_t PURE
+node_ids_slot(const NodeIds* map, const DAWGNode* node) {
+	// Fibonacci hashing
+	return (size_t)(((uint64_t)(uintptr_t)node * UINT64_C(0x9e3779b97f4a7c15)) >> map->shift);
+}
 
 
 static int
-save_fill_address_table(DAWGNode* node, UNUSED const size_t depth, UNUSED void* extra) {
-#define self ((SaveAux*)extra)
-#define hashtable (self->LUT)
-	if (hashtable.count > hashtable.count_threshold) {
-		if (addr_hashtable_resize(&hashtable, hashtable.size * 2) < 0) {
-			self->error = true;
-			return 0;
+node_ids_init(NodeIds* map, DAWG* dawg, DAWGNode** order, const size_t count) {
+	size_t size;
+	size_t i;
+
+	map->base	= dawg->nodes;
+	map->keys	= NULL;
+	map->shift	= 64;
+
+	if (map->base) {
+		map->ids = (nodeid_t*)memalloc(dawg->nodes_count * sizeof(nodeid_t));
+		if (map->ids == NULL)
+			return DAWG_NO_MEM;
+
+		for (i=0; i < count; i++)
+			map->ids[order[i] - map->base] = i;
+	}
+	else {
+		// load factor at most 1/2
+		for (size = 2; size < 2 * count; size *= 2)
+			map->shift -= 1;
+
+		map->shift -= 1;
+		map->ids	= (nodeid_t*)memalloc(size * sizeof(nodeid_t));
+		map->keys	= (DAWGNode**)memcalloc(size, sizeof(DAWGNode*));
+		if (map->ids == NULL or map->keys == NULL)
+			return DAWG_NO_MEM;
+
+		for (i=0; i < count; i++) {
+			size_t j = node_ids_slot(map, order[i]);
+			while (map->keys[j])
+				j = (j + 1) & (size - 1);
+
+			map->keys[j]	= order[i];
+			map->ids[j]		= i;
 		}
 	}
 
-	addr_hashtable_add(&hashtable, node, self->id++);
-	return 1;
-#undef hashtable
-#undef self
+	return DAWG_OK;
 }
 
 
-/*
-	Format of data:
+static void
+node_ids_free(NodeIds* map) {
+	if (map->ids)
+		memfree(map->ids);
+
+	if (map->keys)
+		memfree(map->keys);
+}
+
+
+static nodeid_t PURE
+node_ids_get(const NodeIds* map, const DAWGNode* node) {
+	if (map->base)
+		return map->ids ? map->ids[node - map->base] : (nodeid_t)(node - map->base);
+	else {
+		const size_t mask = ((size_t)1 << (64 - map->shift)) - 1;
+		size_t j = node_ids_slot(map, node);
+		while (map->keys[j] != node) {
+			ASSERT(map->keys[j]);
+			j = (j + 1) & mask;
+		}
+
+		return map->ids[j];
+	}
+}
+
 
-	- magick		: 4 bytes
+/*
+	Format of data; all numbers are little-endian, thus image doesn't
+	depend on architecture nor on build (see dump_letters_compatible):
+
+	- magick		: 4 bytes, "DAWG"
+	- version		: 1 byte
+	- flags			: 1 byte, DUMP_FLAG_*
+	- letter kind	: 1 byte, DUMP_LETTERS_*
+	- letter size	: 1 byte, 1, 2 or 4 --- the least that fits the largest letter
+	- id size		: 1 byte, 4 or 8 --- 4 unless nodes count exceeds 2^32
 	- state			: 1 byte
+	- code size		: 1 byte
+	- jump depth	: 1 byte (table itself is built when image is loaded)
 	- nodes count	: 8 bytes
+	- edges count	: 8 bytes
 	- words count	: 8 bytes
 	- longest word	: 8 bytes
-	- id of root node	: 4 or 8 bytes
+	- id of root node	: 8 bytes
+	- alphabet size	: 4 bytes
+	- alphabet		: letter size bytes per letter, sorted
 
 	Format of node:
 
-	- id			: 4 or 8 bytes
+	- id			: id size bytes
 	- eow			: 1 byte
 	- n				: 4 bytes
+	- number		: 4 bytes, only if flags has DUMP_FLAG_NUMBERS
+	- array[n]
+		- letter	: index in alphabet, code size (1, 2 or 4) bytes
+		- node id	: id size bytes
+
+	Dictionaries usually use a few hundred distinct letters,
+	thus letters are saved as 1 or 2 bytes codes even if
+	DAWG_LETTER_SIZE is 4.
+
+	Nodes are saved in BFS order (edges followed in order of letters)
+	and id of node is its position, root has id 0. Order doesn't
+	depend on placement of nodes in memory, thus equal sets of words
+	give equal images.
+
+	Numbers of words reachable from nodes, used by perfect hashing,
+	are saved for closed DAWG (DUMP_FLAG_NUMBERS); then word2index and
+	index2word don't have to number nodes after load. Builds without
+	perfect hashing skip them.
+
+	In compressed format (DUMP_FLAG_VARINT) ids of nodes are not saved,
+	they are implied by order. Numbers are written as LEB128 varints
+	(7 bits per byte, lowest first):
+
+	- n << 1 | eow	: varint
+	- number		: varint, only if flags has DUMP_FLAG_NUMBERS
 	- array[n]
-		- letter	: 1, 2 or 4 byte(s)
-		- node id	: 4 or 8 bytes
+		- letter	: index in alphabet, code size (1, 2 or 4) bytes
+		- child		: varint, 0 if child is discovered by this edge,
+					  i.e. it is the next node not referred so far;
+					  otherwise zigzag(child id - node id) + 1
+
+	In BFS order most children are discovered by the edge, and
+	the rest usually lies close to the node, thus most edges take
+	code size + 1 bytes.
 */
 
-#ifdef MACHINE32BIT
-#	define DUMP_ID_SIZE 4
+#define DUMP_MAGICK		0x47574144	// "DAWG"
+#define DUMP_VERSION	3
+
+#define DUMP_FLAG_VARINT	0x01
+#define DUMP_FLAG_NUMBERS	0x02
+
+#define DUMP_HEADER_SIZE (4 + 8*1 + 5*8 + 4)
+#define DUMP_NODE_SIZE(id_size, number_size) ((id_size) + 1 + 4 + (number_size))
+#define DUMP_EDGE_SIZE(code_size, id_size) ((code_size) + (id_size))
+
+#define DUMP_VARINT_MAX_SIZE	10	///< bytes of 64-bit number
+#define DUMP_VARINT_NODE_SIZE(n, code_size) \
+	(2 * DUMP_VARINT_MAX_SIZE + (n) * ((code_size) + DUMP_VARINT_MAX_SIZE))
+
+#ifdef DAWG_PERFECT_HASHING
+#	define DUMP_NODE_NUMBER(node) ((uint32_t)(node)->number)
 #else
-#	define DUMP_ID_SIZE 8
+#	define DUMP_NODE_NUMBER(node) 0
 #endif
 
-#define DUMP_HEADER_SIZE (1 + 4 + 3*8 + DUMP_ID_SIZE)
-#define DUMP_NODE_SIZE (DUMP_ID_SIZE + 1 + 4)
-#define DUMP_EDGE_SIZE (DAWG_LETTER_SIZE + DUMP_ID_SIZE)
+// meaning of letters
+#define DUMP_LETTERS_BYTES		0
+#define DUMP_LETTERS_UTF8		1	///< bytes of UTF-8 sequences
+#define DUMP_LETTERS_UNICODE	2	///< code points
+
+#if defined(DAWG_UTF8)
+#	define DUMP_LETTERS		DUMP_LETTERS_UTF8
+#	define DUMP_LETTER_MAX	0xff
+#elif defined(DAWG_UNICODE)
+#	define DUMP_LETTERS		DUMP_LETTERS_UNICODE
+#	define DUMP_LETTER_MAX	0xffffffff	// SequenceDAWG uses any 32-bit value
+#else
+#	define DUMP_LETTERS		DUMP_LETTERS_BYTES
+#	define DUMP_LETTER_MAX	0xff
+#endif
+
+
+/*	little-endian numbers; on little-endian machines these are plain
+	(unaligned) loads and stores */
+static uint64_t PURE
+dump_get(const uint8_t* array, const int size) {
+#ifdef DAWG_BIG_ENDIAN
+	uint64_t value = 0;
+	int i;
+	for (i=size - 1; i >= 0; i--)
+		value = (value << 8) | array[i];
 
-#ifdef MACHINE32BIT
-#	define DUMP_MAGICK_LO 0x32
+	return value;
 #else
-#	define DUMP_MAGICK_LO 0x64
+	switch (size) {
+		case 1:
+			return *array;
+		case 2: {
+			uint16_t value;
+			memcpy(&value, array, 2);
+			return value;
+		}
+		case 4: {
+			uint32_t value;
+			memcpy(&value, array, 4);
+			return value;
+		}
+		default: {
+			uint64_t value;
+			memcpy(&value, array, 8);
+			return value;
+		}
+	}
 #endif
+}
 
-#ifdef DAWG_UNICODE
-#	define 	DUMP_MAGICK_HI	0xda00
+
+static void
+dump_put(uint8_t* array, uint64_t value, const int size) {
+#ifdef DAWG_BIG_ENDIAN
+	int i;
+	for (i=0; i < size; i++) {
+		array[i] = value & 0xff;
+		value >>= 8;
+	}
 #else
-#	define 	DUMP_MAGICK_HI	0xdb00
+	switch (size) {
+		case 1:
+			*array = value;
+			break;
+		case 2: {
+			const uint16_t tmp = value;
+			memcpy(array, &tmp, 2);
+			break;
+		}
+		case 4: {
+			const uint32_t tmp = value;
+			memcpy(array, &tmp, 4);
+			break;
+		}
+		default:
+			memcpy(array, &value, 8);
+			break;
+	}
 #endif
+}
+
+
+/* number of bytes needed to save index in alphabet of given size */
+static int PURE
+dump_code_size(const size_t alphabet_size) {
+	if (alphabet_size <= 0x100)
+		return 1;
+	else if (alphabet_size <= 0x10000)
+		return 2;
+	else
+		return 4;
+}
+
+
+/* number of bytes needed to save the largest letter */
+static int PURE
+dump_letter_size(const uint32_t max_letter) {
+	if (max_letter <= 0xff)
+		return 1;
+	else if (max_letter <= 0xffff)
+		return 2;
+	else
+		return 4;
+}
 
-#define DUMP_MAGICK (DUMP_MAGICK_LO | DUMP_MAGICK_HI)
+
+/* number of bytes of node ids */
+static int PURE
+dump_id_size(const uint64_t nodes_count) {
+	return (nodes_count <= UINT32_MAX) ? 4 : 8;
+}
+
+
+/*	Letters of image mean the same in this build: ASCII letters are
+	the same in all kinds, bytes are latin-1 code points, and bytes
+	build takes UTF-8 sequences as they are; otherwise UTF-8 bytes and
+	code points above ASCII differ. Letters have to fit in
+	DAWG_LETTER_TYPE as well.
+*/
+static bool PURE
+dump_letters_compatible(const int kind, const uint32_t max_letter) {
+	if (max_letter > DUMP_LETTER_MAX)
+		return false;
+
+	if (kind == DUMP_LETTERS or max_letter < 0x80 or DUMP_LETTERS == DUMP_LETTERS_BYTES)
+		return true;
+
+	return kind != DUMP_LETTERS_UTF8 and DUMP_LETTERS != DUMP_LETTERS_UTF8;
+}
+
+
+/* returns number of bytes written */
+static size_t
+dump_put_varint(uint8_t* array, uint64_t value) {
+	size_t n = 0;
+	while (value >= 0x80) {
+		array[n++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+
+	array[n++] = value;
+	return n;
+}
 
 
 static int
-save_node(DAWGNode* node, const nodeid_t node_id, uint8_t* array, addr_HashTable* addr) {
-	int saved = 0;
-	addr_HashListItem* item;
-	DAWGNode* child;
-
-#define save_1byte(x) *(uint8_t*)(array + saved) = (x); saved += 1;
-#define save_2bytes(x) *(uint16_t*)(array + saved) = (x); saved += 2;
-#define save_4bytes(x) *(uint32_t*)(array + saved) = (x); saved += 4;
-#ifdef MACHINE64BIT
-#define save_8bytes(x) *(uint64_t*)(array + saved) = (x); saved += 8;
-#endif
+dump_get_varint(const uint8_t* array, const size_t size, size_t* top, uint64_t* value) {
+	uint64_t result = 0;
+	int shift;
+	size_t i = *top;
+
+	for (shift=0; shift < 64; shift += 7) {
+		if (UNLIKELY(i == size))
+			return DAWG_DUMP_TRUNCATED;
+
+		const uint8_t byte = array[i++];
+		result |= (uint64_t)(byte & 0x7f) << shift;
+		if (byte < 0x80) {
+			*top	= i;
+			*value	= result;
+			return DAWG_OK;
+		}
+	}
+
+	return DAWG_DUMP_CORRUPTED_2;
+}
+
+
+static size_t
+save_node(DAWGNode* node, const nodeid_t node_id, uint8_t* array, const NodeIds* ids, const DAWGAlphabet* alphabet, const int code_size, const int id_size, const int number_size) {
+	size_t saved = 0;
 
 	// save node
-#ifdef MACHINE32BIT
-	save_4bytes(node_id);
-#else
-	save_8bytes(node_id);
-#endif
-	save_1byte(node->eow);
-	save_4bytes(node->n);
+	dump_put(array, node_id, id_size);
+	array[id_size] = node->eow;
+	dump_put(array + id_size + 1, node->n, 4);
+	if (number_size)
+		dump_put(array + id_size + 1 + 4, DUMP_NODE_NUMBER(node), number_size);
+
+	saved += DUMP_NODE_SIZE(id_size, number_size);
 
 	// save links
 	size_t i;
 	for (i=0; i < node->n; i++) {
 
-		child = node->next[i].child;
-		item = addr_hashtable_get(addr, child);
-		ASSERT(item);
+		const nodeid_t child = node_ids_get(ids, node->next[i].child);
+		const uint32_t code = DAWG_alphabet_code(alphabet, node->next[i].letter) - 1;
+		dump_put(array + saved, code, code_size);
+		dump_put(array + saved + code_size, child, id_size);
+		saved += DUMP_EDGE_SIZE(code_size, id_size);
+	}
 
-#if DAWG_LETTER_SIZE == 1
-		save_1byte(node->next[i].letter);
-#elif DAWG_LETTER_SIZE == 2
-		save_2bytes(node->next[i].letter);
-#else
-		save_4bytes(node->next[i].letter);
-#endif
+	return saved;
+}
 
-#ifdef MACHINE32BIT
-		save_4bytes(item->data);
-#else
-		save_8bytes(item->data);
-#endif
+
+/*	save node in compressed format; next_new is id of the next
+	node to be discovered, updated */
+static size_t
+save_node_varint(DAWGNode* node, const nodeid_t node_id, uint8_t* array, const NodeIds* ids, const DAWGAlphabet* alphabet, const int code_size, const bool numbers, nodeid_t* next_new) {
+	size_t saved = 0;
+	size_t i;
+
+	saved += dump_put_varint(array, ((uint64_t)node->n << 1) | (node->eow ? 1 : 0));
+	if (numbers)
+		saved += dump_put_varint(array + saved, DUMP_NODE_NUMBER(node));
+	for (i=0; i < node->n; i++) {
+		const nodeid_t child = node_ids_get(ids, node->next[i].child);
+		const uint32_t code = DAWG_alphabet_code(alphabet, node->next[i].letter) - 1;
+		dump_put(array + saved, code, code_size);
+		saved += code_size;
+
+		if (child == *next_new) {
+			array[saved++] = 0;
+			*next_new += 1;
+		}
+		else {
+			ASSERT(child < *next_new);
+			const int64_t delta = (int64_t)child - (int64_t)node_id;
+			const uint64_t zigzag = ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63);
+			saved += dump_put_varint(array + saved, zigzag + 1);
+		}
 	}
 
 	return saved;
-#ifdef MACHINE64BIT
-#undef save_8bytes
-#endif
-#undef save_4bytes
-#undef save_2bytes
-#undef save_1byte
 }
 
 
+/* chunk of image, passed to DAWGWriteFun when full */
+typedef struct SaveStream {
+	uint8_t*	buffer;
+	size_t		capacity;
+	size_t		top;
+
+	DAWGWriteFun	write;
+	void*			extra;
+} SaveStream;
+
+
+static int
+save_stream_flush(SaveStream* stream) {
+	if (stream->top > 0) {
+		if (stream->write(stream->buffer, stream->top, stream->extra) != 0)
+			return DAWG_WRITE_FAILED;
+
+		stream->top = 0;
+	}
+
+	return DAWG_OK;
+}
+
+
+/* make room for n bytes; buffer is enlarged only if n doesn't fit in an empty one */
 static int
-DAWG_save(DAWG* dawg, DAWGStatistics* stats, uint8_t** array, size_t* size) {
+save_stream_reserve(SaveStream* stream, const size_t n) {
+	if (stream->top + n <= stream->capacity)
+		return DAWG_OK;
+
+	const int result = save_stream_flush(stream);
+	if (result != DAWG_OK)
+		return result;
+
+	if (n > stream->capacity) {
+		uint8_t* tmp = (uint8_t*)memrealloc(stream->buffer, n);
+		if (tmp == NULL)
+			return DAWG_NO_MEM;
+
+		stream->buffer		= tmp;
+		stream->capacity	= n;
+	}
+
+	return DAWG_OK;
+}
+
+
+static int
+DAWG_save_stream(DAWG* dawg, DAWGStatistics* stats, const DAWGCompression compression, const bool numbers, DAWGWriteFun write, void* extra) {
 	ASSERT(dawg);
 	ASSERT(stats);
+	ASSERT(write);
+
+	const size_t nodes_count = (dawg->q0 != NULL) ? stats->nodes_count : 0;
+	const size_t edges_count = (dawg->q0 != NULL) ? stats->edges_count : 0;
+	DAWGNode** order = NULL;
+	NodeIds ids;
+	SaveStream stream;
+	DAWGAlphabet alphabet;
+	size_t i;
+	int result;
 
-	SaveAux rec;
-	
-	rec.error	= false;
-	rec.id		= 0;
-	addr_hashtable_init(&rec.LUT, 1021);
-	
-	rec.size	= stats->nodes_count * DUMP_NODE_SIZE +
-				  stats->edges_count * DUMP_EDGE_SIZE;
-	rec.size	= rec.size + DUMP_HEADER_SIZE;
-	rec.top		= 0;
-	rec.array	= memalloc(rec.size);
-	if (rec.array == NULL) {
-		addr_hashtable_destroy(&rec.LUT);
+	if (DAWG_get_alphabet(dawg, &alphabet) != DAWG_OK)
 		return DAWG_NO_MEM;
+
+	const int code_size = dump_code_size(alphabet.size);
+	const int id_size = dump_id_size(nodes_count);
+	const int letter_size = (alphabet.size > 0) ? dump_letter_size(alphabet.letters[alphabet.size - 1]) : 1;
+	const int number_size = numbers ? 4 : 0;
+
+	ids.base	= NULL;
+	ids.ids		= NULL;
+	ids.keys	= NULL;
+	ids.shift	= 64;
+
+	stream.capacity	= DAWG_SAVE_CHUNK_SIZE;
+	stream.top		= 0;
+	stream.write	= write;
+	stream.extra	= extra;
+	stream.buffer	= (uint8_t*)memalloc(stream.capacity);
+	if (stream.buffer == NULL) {
+		result = DAWG_NO_MEM;
+		goto finish;
 	}
 
-	// make lookup table: node address => sequential number
-	DAWG_traverse_DFS_once(dawg, save_fill_address_table, &rec);
-	if (rec.error) {
-		memfree(rec.array);
-		addr_hashtable_destroy(&rec.LUT);
-		return DAWG_NO_MEM;
+	// number nodes: node address => position in BFS order;
+	// block placed in BFS order is saved as it is
+	if (nodes_count > 0 and DAWG_is_BFS_placed(dawg))
+		ids.base = dawg->nodes;
+	else if (nodes_count > 0) {
+		order = (DAWGNode**)memalloc(nodes_count * sizeof(DAWGNode*));
+		if (order == NULL) {
+			result = DAWG_NO_MEM;
+			goto finish;
+		}
+
+		result = DAWG_get_nodes_BFS(dawg, order);
+		if (result != DAWG_OK)
+			goto finish;
+
+		result = node_ids_init(&ids, dawg, order, nodes_count);
+		if (result != DAWG_OK)
+			goto finish;
 	}
 
 	// save header
-#define save_8bytes(x) *(uint64_t*)(rec.array + rec.top) = (x); rec.top += 8;
-#define save_4bytes(x) *(uint32_t*)(rec.array + rec.top) = (x); rec.top += 4;
-#define save_1byte(x) *(uint8_t*)(rec.array + rec.top) = (x); rec.top += 1;
-	save_4bytes(DUMP_MAGICK);
-	save_1byte(dawg->state);
-	save_8bytes(rec.LUT.count);	// nodes count
-	save_8bytes(dawg->count);
-	save_8bytes(dawg->longest_word);
-	if (dawg->state != EMPTY) {
-		addr_HashListItem* item;
-		item = addr_hashtable_get(&rec.LUT, dawg->q0);
-		ASSERT(item);
-#ifdef MACHINE32BIT
-		save_4bytes(item->data);
-#else
-		save_8bytes(item->data);
-#endif
-	}
-	else {
-#ifdef MACHINE32BIT
-		save_4bytes(0);
-#else
-		save_8bytes(0);
-#endif
+	result = save_stream_reserve(&stream, DUMP_HEADER_SIZE + alphabet.size * letter_size);
+	if (result != DAWG_OK)
+		goto finish;
+
+	uint8_t* header = stream.buffer;
+	dump_put(header +  0, DUMP_MAGICK, 4);
+	header[4]	= DUMP_VERSION;
+	header[5]	= ((compression == COMPRESSION_VARINT) ? DUMP_FLAG_VARINT : 0) |
+				  (numbers ? DUMP_FLAG_NUMBERS : 0);
+	header[6]	= DUMP_LETTERS;
+	header[7]	= letter_size;
+	header[8]	= id_size;
+	header[9]	= dawg->state;
+	header[10]	= code_size;
+	header[11]	= dawg->jump.depth;
+	dump_put(header + 12, nodes_count, 8);
+	dump_put(header + 20, edges_count, 8);
+	dump_put(header + 28, dawg->count, 8);
+	dump_put(header + 36, dawg->longest_word, 8);
+	dump_put(header + 44, 0, 8);	// root is the first node
+	dump_put(header + 52, alphabet.size, 4);
+	stream.top = DUMP_HEADER_SIZE;
+
+	for (i=0; i < alphabet.size; i++) {
+		dump_put(stream.buffer + stream.top, alphabet.letters[i], letter_size);
+		stream.top += letter_size;
 	}
-#undef save_8bytes
-#undef save_4bytes
-#undef save_1byte
 
 	// save nodes
-	size_t i;
-	for (i=0; i < rec.LUT.size; i++) {
-		addr_HashListItem* item = rec.LUT.table[i];
-		while (item) {
-			const int saved =
-				save_node(item->key, item->data, rec.array + rec.top, &rec.LUT);
-
-			ASSERT(saved > 0);
-			rec.top += saved;
+	nodeid_t next_new = 1;	// root is already known
+	for (i=0; i < nodes_count; i++) {
+		DAWGNode* node = order ? order[i] : &dawg->nodes[i];
+		if (compression == COMPRESSION_VARINT) {
+			result = save_stream_reserve(&stream, DUMP_VARINT_NODE_SIZE(node->n, code_size));
+			if (result != DAWG_OK)
+				goto finish;
+
+			stream.top +=
+				save_node_varint(node, i, stream.buffer + stream.top, &ids, &alphabet, code_size, numbers, &next_new);
+		}
+		else {
+			result = save_stream_reserve(&stream, DUMP_NODE_SIZE(id_size, number_size) + node->n * DUMP_EDGE_SIZE(code_size, id_size));
+			if (result != DAWG_OK)
+				goto finish;
 
-			ASSERT(rec.top <= rec.size);
-			item = item->next;
+			stream.top +=
+				save_node(node, i, stream.buffer + stream.top, &ids, &alphabet, code_size, id_size, number_size);
 		}
 	}
 
-	ASSERT(rec.top == rec.size);
+	ASSERT(compression != COMPRESSION_VARINT or nodes_count == 0 or next_new == nodes_count);
 
-	addr_hashtable_destroy(&rec.LUT);
+	result = save_stream_flush(&stream);
 
-	*size	= rec.size;
-	*array	= rec.array;
+finish:
+	if (stream.buffer)
+		memfree(stream.buffer);
+
+	if (order)
+		memfree(order);
+
+	node_ids_free(&ids);
+	DAWG_alphabet_free(&alphabet);
 
+	return result;
+}
+
+
+typedef struct SaveArray {
+	uint8_t*	array;
+	size_t		size;
+	size_t		top;
+} SaveArray;
+
+
+/* size of compressed image isn't known up front, array grows then */
+static int
+save_array_write(const uint8_t* data, const size_t size, void* extra) {
+#define self ((SaveArray*)extra)
+	if (self->top + size > self->size) {
+		const size_t new_size = 2 * self->size + size;
+		uint8_t* tmp = (uint8_t*)memrealloc(self->array, new_size);
+		if (tmp == NULL)
+			return -1;
+
+		self->array	= tmp;
+		self->size	= new_size;
+	}
+
+	memcpy(self->array + self->top, data, size);
+	self->top += size;
 	return 0;
+#undef self
 }
 
 
 static int
-load_node(uint8_t* array, DAWGNode** _node, DAWGNode** id2node) {
-	int loaded = 0;
-	DAWGNode* node = memalloc(sizeof(DAWGNode));
-	if (node == NULL) {
+DAWG_save(DAWG* dawg, DAWGStatistics* stats, const DAWGCompression compression, const bool numbers, uint8_t** array, size_t* size) {
+	ASSERT(dawg);
+	ASSERT(stats);
+
+	DAWGAlphabet alphabet;
+	SaveArray rec;
+
+	if (DAWG_get_alphabet(dawg, &alphabet) != DAWG_OK)
 		return DAWG_NO_MEM;
+
+	const int code_size = dump_code_size(alphabet.size);
+	const int id_size = dump_id_size(stats->nodes_count);
+	const int letter_size = (alphabet.size > 0) ? dump_letter_size(alphabet.letters[alphabet.size - 1]) : 1;
+	if (compression == COMPRESSION_VARINT)
+		// estimation, most edges take code size + 1 bytes
+		rec.size	= stats->nodes_count * (numbers ? 4 : 2) +
+					  stats->edges_count * (code_size + 2);
+	else
+		// exact
+		rec.size	= stats->nodes_count * DUMP_NODE_SIZE(id_size, numbers ? 4 : 0) +
+					  stats->edges_count * DUMP_EDGE_SIZE(code_size, id_size);
+
+	rec.size	= rec.size + DUMP_HEADER_SIZE + alphabet.size * letter_size;
+	rec.top		= 0;
+	DAWG_alphabet_free(&alphabet);
+
+	rec.array	= memalloc(rec.size);
+	if (rec.array == NULL)
+		return DAWG_NO_MEM;
+
+	int result = DAWG_save_stream(dawg, stats, compression, numbers, save_array_write, &rec);
+	if (result == DAWG_WRITE_FAILED)
+		result = DAWG_NO_MEM;	// array couldn't grow
+
+	if (result != DAWG_OK) {
+		memfree(rec.array);
+		return result;
 	}
 
-	// load id and save it in the lookup table
-#ifdef MACHINE32BIT
-	const uint32_t id = *(uint32_t*)(array + loaded);
-	loaded += 4;
-#else
-	const uint64_t id = *(uint64_t*)(array + loaded);
-	loaded += 8;
-#endif
+	ASSERT(compression == COMPRESSION_VARINT or rec.top == rec.size);
 
-	id2node[id] = node;
-
-#define get_1byte (loaded += 1, (*(uint8_t*)(array + loaded - 1)))
-#define get_2bytes (loaded += 2, (*(uint16_t*)(array + loaded - 2)))
-#define get_4bytes (loaded += 4, (*(uint32_t*)(array + loaded - 4)))
-#define get_8bytes (loaded += 8, (*(uint64_t*)(array + loaded - 8)))
-
-	// load node data
-	node->eow		= get_1byte;
-	node->n			= get_4bytes;
-	node->visited	= 0;
-	
-	if (node->n) {
-		node->next	= memalloc(node->n * sizeof(DAWGEdge));
-		if (node->next == NULL) {
-			memfree(node);
-			return DAWG_NO_MEM;
+	*size	= rec.top;
+	*array	= rec.array;
+
+	return DAWG_OK;
+}
+
+
+/* nodes of active DAWG are sorted by address, index is found by binary search */
+static int
+load_node_compare(const void* a, const void* b) {
+	const uintptr_t x = (uintptr_t)*(DAWGNode* const*)a;
+	const uintptr_t y = (uintptr_t)*(DAWGNode* const*)b;
+
+	return (x > y) - (x < y);
+}
+
+
+static size_t PURE
+load_node_index(const DAWGNode* nodes, DAWGNode* const* id2node, const size_t nodes_count, const DAWGNode* node) {
+	if (nodes != NULL)
+		return node - nodes;
+
+	size_t a = 0;
+	size_t b = nodes_count;
+	while (a + 1 < b) {
+		const size_t c = (a + b)/2;
+		if ((uintptr_t)id2node[c] <= (uintptr_t)node)
+			a = c;
+		else
+			b = c;
+	}
+
+	return a;
+}
+
+
+/*
+	Check if graph is acyclic, then check if number of words and length
+	of the longest word saved in header agree with the graph; traversals
+	use buffers of size longest_word. Nodes are visited in topological
+	order (Kahn's algorithm).
+*/
+static int
+load_check_graph(
+	const DAWGNode* nodes, DAWGNode* const* id2node, const size_t nodes_count,
+	const size_t root_id, const uint64_t words_count, const uint64_t longest_word
+) {
+	size_t*		indegree = memcalloc(nodes_count, sizeof(size_t));
+	size_t*		order	 = memalloc(nodes_count * sizeof(size_t));
+	uint64_t*	count	 = memalloc(nodes_count * sizeof(uint64_t));
+	size_t head, tail;
+	size_t i, j;
+	int result = DAWG_DUMP_INVALID_GRAPH;
+
+#define node_of(id) ((nodes != NULL) ? &nodes[id] : id2node[id])
+#define index_of(node) load_node_index(nodes, id2node, nodes_count, node)
+	if (indegree == NULL or order == NULL or count == NULL) {
+		result = DAWG_NO_MEM;
+		goto end;
+	}
+
+	for (i=0; i < nodes_count; i++) {
+		const DAWGNode* node = node_of(i);
+		for (j=0; j < node->n; j++)
+			indegree[index_of(node->next[j].child)] += 1;
+	}
+
+	tail = 0;
+	for (i=0; i < nodes_count; i++)
+		if (indegree[i] == 0)
+			order[tail++] = i;
+
+	for (head=0; head < tail; head++) {
+		const DAWGNode* node = node_of(order[head]);
+		for (j=0; j < node->n; j++) {
+			const size_t child = index_of(node->next[j].child);
+			if (--indegree[child] == 0)
+				order[tail++] = child;
+		}
+	}
+
+	if (tail != nodes_count)	// cycle
+		goto end;
+
+	// all indegrees are zero, array holds lengths of the longest paths now
+	size_t* height = indegree;
+	for (i=nodes_count; i > 0; i--) {
+		const size_t id = order[i - 1];
+		const DAWGNode* node = node_of(id);
+
+		count[id] = node->eow;
+		for (j=0; j < node->n; j++) {
+			const size_t child = index_of(node->next[j].child);
+			if (height[id] < height[child] + 1)
+				height[id] = height[child] + 1;
+
+			// saturated, corrupted graph may have more paths than 2^64
+			if (count[child] > UINT64_MAX - count[id])
+				count[id] = UINT64_MAX;
+			else
+				count[id] += count[child];
 		}
+	}
 
-		size_t i;
-		for (i=0; i < node->n; i++) {
-#if DAWG_LETTER_SIZE == 1
-			node->next[i].letter = get_1byte;
-#elif DAWG_LETTER_SIZE == 2
-			node->next[i].letter = get_2bytes;
-#else
-			node->next[i].letter = get_4bytes;
-#endif
+	if (count[root_id] == words_count and height[root_id] == longest_word)
+		result = DAWG_OK;
+#undef index_of
+#undef node_of
 
-#ifdef MACHINE32BIT
-			node->next[i].child = (DAWGNode*)(get_4bytes);
-#else
-			node->next[i].child = (DAWGNode*)(get_8bytes);
+end:
+	if (indegree)	memfree(indegree);
+	if (order)		memfree(order);
+	if (count)		memfree(count);
+
+	return result;
+}
+
+
+/*	fill nodes from COMPRESSION_VARINT image; nodes are given either
+	as blocks (closed DAWG) or as id2node array. Children are checked
+	even if image is trusted, they are not implied by ids of nodes.
+	References to known nodes may still make cycles, untrusted image
+	is checked by load_check_graph then.
+*/
+static int
+load_nodes_varint(
+	const uint8_t* array, const size_t size, size_t top,
+	const size_t nodes_count, const size_t edges_count,
+	const int code_size, const DAWG_LETTER_TYPE* letters, const uint32_t alphabet_size,
+	const bool trusted, const bool numbers,
+	DAWGNode* nodes, DAWGEdge* edges, DAWGNode** id2node
+) {
+	nodeid_t next_new = 1;	// root is already known
+	size_t edges_left = edges_count;
+	uint64_t value;
+	uint32_t prev_code = 0;
+	size_t i, j;
+	int result;
+
+// most numbers fit in one byte
+#define get_varint(var) \
+	if (LIKELY(top < size and array[top] < 0x80)) \
+		var = array[top++]; \
+	else { \
+		result = dump_get_varint(array, size, &top, &var); \
+		if (UNLIKELY(result != DAWG_OK)) \
+			return result; \
+	}
+
+	for (i=0; i < nodes_count; i++) {
+		get_varint(value);
+		const uint64_t n = value >> 1;
+		if (UNLIKELY(n > alphabet_size or n > UINT16_MAX))
+			return DAWG_DUMP_CORRUPTED_2;
+
+		// node not referred by any of previous ones
+		if (UNLIKELY(i >= next_new))
+			return DAWG_DUMP_CORRUPTED_1;
+
+		// count saved in header
+		if (UNLIKELY(n > edges_left))
+			return DAWG_DUMP_CORRUPTED_2;
+
+		DAWGNode* node = (nodes != NULL) ? &nodes[i] : id2node[i];
+		node->eow	= value & 1;
+		node->n		= 0;
+		if (numbers) {
+			get_varint(value);
+#ifdef DAWG_PERFECT_HASHING
+			if (UNLIKELY(value > INT_MAX))
+				return DAWG_DUMP_INVALID_NUMBERS;
+
+			node->number = (int)value;
 #endif
 		}
+		if (n == 0)
+			node->next = NULL;
+		else if (nodes)
+			node->next = edges + (edges_count - edges_left);
+		else {
+			node->next = memalloc(n * sizeof(DAWGEdge));
+			if (node->next == NULL)
+				return DAWG_NO_MEM;
+		}
+
+		node->n = n;
+		edges_left -= n;
+		for (j=0; j < n; j++) {
+			if (UNLIKELY(size - top < (size_t)code_size))
+				return DAWG_DUMP_TRUNCATED;
+
+			const uint32_t code = dump_get(array + top, code_size);
+			top += code_size;
+
+			if (not trusted and UNLIKELY(code >= alphabet_size))
+				return DAWG_DUMP_CORRUPTED_2;
+
+			// edges are sorted by letters
+			if (not trusted and UNLIKELY(j > 0 and code <= prev_code))
+				return DAWG_DUMP_INVALID_GRAPH;
+
+			prev_code = code;
+
+			get_varint(value);
+			nodeid_t child;
+			if (value == 0) {
+				if (UNLIKELY(next_new >= nodes_count))
+					return DAWG_DUMP_CORRUPTED_2;
+
+				child = next_new++;
+			}
+			else {
+				const uint64_t zigzag = value - 1;
+				const int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+				child = (nodeid_t)((int64_t)i + delta);
+				// only nodes already discovered are referred
+				if (UNLIKELY(child >= next_new))
+					return DAWG_DUMP_CORRUPTED_2;
+			}
+
+			node->next[j].letter	= letters[code];
+			node->next[j].child		= (nodes != NULL) ? &nodes[child] : id2node[child];
+		}
 	}
-	else
-		node->next = NULL;
+#undef get_varint
 
-	*_node = node;
-	return loaded;
+	if ((nodes_count > 0 and next_new != nodes_count) or edges_left != 0)
+		return DAWG_DUMP_CORRUPTED_1;
 
-#undef get_1byte
-#undef get_2bytes
-#undef get_4bytes
-#undef get_8bytes
+	return DAWG_OK;
 }
 
 
-int
-DAWG_load(DAWG* dawg, uint8_t* array, size_t size) {
+static int
+DAWG_load(DAWG* dawg, const uint8_t* array, const size_t size, const bool trusted, bool* numbered) {
 	int result;
 	size_t top = 0;
-	size_t i;
-
-	uint32_t	magick;
-	DAWGState	state;
-	uint64_t	nodes_count;
-	uint64_t	words_count;
-	uint64_t	longest_word;
-	nodeid_t	root_id;
+	size_t i, j;
 
 	if (size < DUMP_HEADER_SIZE)
 		return DAWG_DUMP_TRUNCATED;
 
-#define get_1byte (top += 1, (*(uint8_t*)(array + top - 1)))
-#define get_4bytes (top += 4, (*(uint32_t*)(array + top - 4)))
-#define get_8bytes (top += 8, (*(uint64_t*)(array + top - 8)))
-
 	// parse header
-	magick = get_4bytes;
-	if (magick != DUMP_MAGICK)
+	if (dump_get(array, 4) != DUMP_MAGICK or array[4] != DUMP_VERSION)
 		return DAWG_DUMP_INVALID_MAGICK;
 
-	state	= get_1byte;
+	const int flags			= array[5];
+	const int letter_kind	= array[6];
+	const int letter_size	= array[7];
+	const int id_size		= array[8];
+	const DAWGState state	= array[9];
+	const int code_size		= array[10];
+	const int jump_depth	= array[11];
+
+	const uint64_t nodes_header		= dump_get(array + 12, 8);
+	const uint64_t edges_header		= dump_get(array + 20, 8);
+	const uint64_t words_count		= dump_get(array + 28, 8);
+	const uint64_t longest_word		= dump_get(array + 36, 8);
+	const uint64_t root_id			= dump_get(array + 44, 8);
+	const uint32_t alphabet_size	= dump_get(array + 52, 4);
+	top = DUMP_HEADER_SIZE;
+
+	if ((flags & ~(DUMP_FLAG_VARINT | DUMP_FLAG_NUMBERS)) != 0)
+		return DAWG_DUMP_INVALID_MAGICK;
+
+	const bool varint	= (flags & DUMP_FLAG_VARINT) != 0;
+	const bool numbers	= (flags & DUMP_FLAG_NUMBERS) != 0;
+	const int number_size = numbers ? 4 : 0;
+
 	if (state != EMPTY and state != ACTIVE and state != CLOSED)
 		return DAWG_DUMP_INVALID_STATE;
 
-	nodes_count		= get_8bytes;
-	words_count		= get_8bytes;
-	longest_word	= get_8bytes;
-#ifdef MACHINE32BIT
-	root_id			= get_4bytes;
-#else
-	root_id			= get_8bytes;
-#endif
+	// numbers are valid only in closed DAWG
+	if (numbers and state != CLOSED)
+		return DAWG_DUMP_INVALID_STATE;
 
-	// lookup table: id => node address
-	DAWGNode**	id2node = NULL;
+	if (id_size != 4 and id_size != 8)
+		return DAWG_DUMP_INVALID_STATE;
 
-	if (state != EMPTY) {
-		if (root_id >= nodes_count)
-			return DAWG_DUMP_INVALID_ROOT_ID;
+	if (jump_depth > DAWG_JUMP_MAX_DEPTH)
+		return DAWG_DUMP_INVALID_STATE;
 
-		// 0. allocate lookup table
-		id2node = memalloc(nodes_count * sizeof(DAWGNode*));
-		if (id2node == NULL)
-			return DAWG_NO_MEM;
-		else
-			memset(id2node, 0, nodes_count * sizeof(DAWGNode*));
+	if (code_size != dump_code_size(alphabet_size))
+		return DAWG_DUMP_INVALID_ALPHABET;
+
+	if (letter_kind > DUMP_LETTERS_UNICODE or (letter_size != 1 and letter_size != 2 and letter_size != 4))
+		return DAWG_DUMP_INVALID_ALPHABET;
+
+	if ((size - top) / letter_size < alphabet_size)
+		return DAWG_DUMP_TRUNCATED;
+
+	// each node takes at least one byte, counts fit in size_t then
+	if (nodes_header > size - top)
+		return DAWG_DUMP_TRUNCATED;
+
+	const size_t nodes_count = (state == EMPTY) ? 0 : nodes_header;
+	size_t edges_count = 0;
+	if (state != EMPTY and root_id >= nodes_count)
+		return DAWG_DUMP_INVALID_ROOT_ID;
+
+	const size_t node_size = DUMP_NODE_SIZE(id_size, number_size);
+	const size_t edge_size = DUMP_EDGE_SIZE(code_size, id_size);
+
+	// alphabet: code => letter
+	uint32_t prev = 0;
+	for (i=0; i < alphabet_size; i++) {
+		const uint32_t letter = dump_get(array + top + i * letter_size, letter_size);
+		if (i > 0 and prev >= letter)
+			return DAWG_DUMP_INVALID_ALPHABET;
 
-		// 1. load nodes and fill id2node LUT
+		prev = letter;
+	}
+
+	// the largest letter is the last one
+	if (not dump_letters_compatible(letter_kind, prev))
+		return DAWG_DUMP_INCOMPATIBLE;
+
+	DAWG_LETTER_TYPE* letters = memalloc((alphabet_size + 1) * DAWG_LETTER_SIZE);
+	if (letters == NULL)
+		return DAWG_NO_MEM;
+
+	for (i=0; i < alphabet_size; i++) {
+		letters[i] = dump_get(array + top, letter_size);
+		top += letter_size;
+	}
+
+	// 1. sizes of nodes -- image is complete and number of edges is known;
+	//    compressed image has to be decoded for that, counts are saved
+	//    in header, and are checked against the least size of items
+	const size_t nodes_start = top;
+	if (varint) {
+		if (nodes_count > (size - top) / (numbers ? 2 : 1) or edges_header > (size - top) / (code_size + 1)) {
+			memfree(letters);
+			return DAWG_DUMP_TRUNCATED;
+		}
+
+		edges_count = (state == EMPTY) ? 0 : edges_header;
+	}
+	else {
 		for (i=0; i < nodes_count; i++) {
-			DAWGNode* node;
-			const int tmp = load_node(array + top, &node, id2node);
+			if (UNLIKELY(size - top < node_size)) {
+				memfree(letters);
+				return DAWG_DUMP_TRUNCATED;
+			}
 
-			if (LIKELY(tmp > 0)) {
-				top += tmp;
+			const uint32_t n = dump_get(array + top + id_size + 1, 4);
+			// node has at most one edge per letter, field n of node is 16-bit
+			if (UNLIKELY(n > alphabet_size or n > UINT16_MAX)) {
+				memfree(letters);
+				return DAWG_DUMP_CORRUPTED_2;
+			}
 
-				if (UNLIKELY(top > size)) {
-					result = DAWG_DUMP_TRUNCATED;
-					goto error;
-				}
+			if (UNLIKELY((size - top - node_size) / edge_size < n)) {
+				memfree(letters);
+				return DAWG_DUMP_TRUNCATED;
 			}
-			else {
+
+			top += node_size + n * edge_size;
+			edges_count += n;
+		}
+
+		if (edges_count != edges_header and state != EMPTY) {
+			memfree(letters);
+			return DAWG_DUMP_CORRUPTED_2;
+		}
+	}
+
+	// 2. allocate all nodes, then addresses of children are known up front;
+	//    closed DAWG is placed in two blocks in order of image, nodes of
+	//    active DAWG are allocated separately (they are modified later)
+	DAWGNode*	nodes = NULL;
+	DAWGEdge*	edges = NULL;
+	DAWGNode**	id2node = NULL;
+	uint64_t*	seen = NULL;
+
+	if (state == CLOSED) {
+		nodes = memalloc(nodes_count * sizeof(DAWGNode));
+		if (edges_count > 0)
+			edges = memalloc(edges_count * sizeof(DAWGEdge));
+
+		if (nodes == NULL or (edges_count > 0 and edges == NULL)) {
+			result = DAWG_NO_MEM;
+			goto error;
+		}
+	}
+	else if (state == ACTIVE) {
+		id2node = memcalloc(nodes_count, sizeof(DAWGNode*));
+		if (id2node == NULL) {
+			result = DAWG_NO_MEM;
+			goto error;
+		}
+
+		for (i=0; i < nodes_count; i++) {
+			id2node[i] = dawgnode_new();
+			if (id2node[i] == NULL) {
 				result = DAWG_NO_MEM;
 				goto error;
 			}
 		}
 
-		// 2. check if root node is ok
-		if (id2node[root_id] == NULL) {
-			result = DAWG_DUMP_CORRUPTED_1;
+		// any node may get any id, see load_node_index
+		if (not trusted)
+			qsort(id2node, nodes_count, sizeof(DAWGNode*), load_node_compare);
+	}
+
+	if (not trusted and not varint) {
+		// each id appears once, then all nodes are present
+		seen = memcalloc(nodes_count/64 + 1, sizeof(uint64_t));
+		if (seen == NULL) {
+			result = DAWG_NO_MEM;
 			goto error;
 		}
+	}
 
-		// 3. update node addresses in an edges array
+#define node_of(id) ((nodes != NULL) ? &nodes[id] : id2node[id])
+
+	// 3. fill nodes
+	top = nodes_start;
+	DAWGEdge* edge = edges;
+	if (varint) {
+		result = load_nodes_varint(array, size, top, nodes_count, edges_count, code_size, letters, alphabet_size, trusted, numbers, nodes, edges, id2node);
+		if (result != DAWG_OK)
+			goto error;
+	}
+	else {
 		for (i=0; i < nodes_count; i++) {
-			// get i-th node
-			DAWGNode* node;
-			DAWGNode* child;
-			node = id2node[i];
-			if (UNLIKELY(node == NULL)) {
-				result = DAWG_DUMP_CORRUPTED_1;
+			const uint64_t id = dump_get(array + top, id_size);
+			if (not trusted) {
+				if (UNLIKELY(id >= nodes_count)) {
+					result = DAWG_DUMP_CORRUPTED_2;
+					goto error;
+				}
+
+				if (UNLIKELY(seen[id / 64] & (UINT64_C(1) << (id % 64)))) {
+					result = DAWG_DUMP_CORRUPTED_1;
+					goto error;
+				}
+
+				seen[id / 64] |= UINT64_C(1) << (id % 64);
+			}
+
+			// bool is a char, other values would break comparisons
+			if (not trusted and UNLIKELY(array[top + id_size] > 1)) {
+				result = DAWG_DUMP_INVALID_GRAPH;
 				goto error;
 			}
 
-			// update edges
-			size_t j;
-			for (j=0; j < node->n; j++) {
-#ifdef MACHINE32BIT
-				const uint32_t id = (uint32_t)(node->next[j].child);
-#else
-				const uint64_t id = (uint64_t)(node->next[j].child);
+			DAWGNode* node = node_of(id);
+			node->eow	= array[top + id_size];
+			node->n		= dump_get(array + top + id_size + 1, 4);
+#ifdef DAWG_PERFECT_HASHING
+			if (numbers) {
+				const uint32_t number = dump_get(array + top + id_size + 1 + 4, 4);
+				if (UNLIKELY(number > INT_MAX)) {
+					result = DAWG_DUMP_INVALID_NUMBERS;
+					goto error;
+				}
+
+				node->number = (int)number;
+			}
 #endif
-				if (UNLIKELY(id >= nodes_count)) {
+			top += node_size;
+			if (node->n == 0)
+				node->next = NULL;
+			else if (nodes) {
+				node->next = edge;
+				edge += node->n;
+			}
+			else {
+				node->next = memalloc(node->n * sizeof(DAWGEdge));
+				if (node->next == NULL) {
+					node->n = 0;
+					result = DAWG_NO_MEM;
+					goto error;
+				}
+			}
+
+			for (j=0; j < node->n; j++) {
+				const uint32_t code		= dump_get(array + top, code_size);
+				const uint64_t child	= dump_get(array + top + code_size, id_size);
+				top += edge_size;
+				if (not trusted and UNLIKELY(code >= alphabet_size or child >= nodes_count)) {
 					result = DAWG_DUMP_CORRUPTED_2;
 					goto error;
 				}
-				else {
-					child = id2node[id];
-					if (UNLIKELY(child == NULL)) {
-						result = DAWG_DUMP_CORRUPTED_1;
-						goto error;
-					}
+
+				// edges are sorted by letters
+				if (not trusted and UNLIKELY(j > 0 and letters[code] <= node->next[j - 1].letter)) {
+					result = DAWG_DUMP_INVALID_GRAPH;
+					goto error;
 				}
 
-				node->next[j].child = child;
+				node->next[j].letter	= letters[code];
+				node->next[j].child		= node_of(child);
 			}
-		} // for
-	} // node
+		}
+	}
+
+	if (not trusted and state != EMPTY) {
+		result = load_check_graph(nodes, id2node, nodes_count, root_id, words_count, longest_word);
+		if (result != DAWG_OK)
+			goto error;
+	}
+	else if (not trusted and (words_count != 0 or longest_word != 0)) {
+		result = DAWG_DUMP_INVALID_GRAPH;
+		goto error;
+	}
+
+#ifdef DAWG_PERFECT_HASHING
+	// all nodes are in the block, numbers are checked in one pass
+	if (numbers and not trusted and not DAWG_mph_check_numbers(nodes, nodes_count)) {
+		result = DAWG_DUMP_INVALID_NUMBERS;
+		goto error;
+	}
+#endif
 
 	result = DAWG_clear(dawg);
-	if(result==DAWG_NO_MEM)
+	if (result == DAWG_NO_MEM)
 		goto error;
-	dawg->q0 = (state == EMPTY) ? NULL : id2node[root_id];
+
+	dawg->q0 = (state == EMPTY) ? NULL : node_of(root_id);
+#undef node_of
 	dawg->count	= words_count;
 	dawg->longest_word = longest_word;
 	dawg->state = state;
 
+	if (state == CLOSED) {
+		dawg->nodes = nodes;
+		dawg->edges = edges;
+		dawg->nodes_count = nodes_count;
+
+		// unused letters would only weaken filtering, error is not fatal
+		DAWG_alphabet_set(&dawg->alphabet, letters, alphabet_size);
+		// jump table is an optional speedup as well
+		DAWG_jump_build(dawg, jump_depth);
+	}
+
 	if (state == ACTIVE) {
-		// recreate registry lookup table
-		for (i=0; i < nodes_count; i++) {
-			DAWGNode* node = id2node[i];
-			hashtable_add(&dawg->reg, node);
-			resize_hash(&dawg->reg);
-		}
+		// recreate registry lookup table, resized at most once
+		if (dawg->reg.count_threshold < nodes_count)
+			hashtable_resize(&dawg->reg, nodes_count * 10/7 + 1);
+
+		for (i=0; i < nodes_count; i++)
+			hashtable_add(&dawg->reg, id2node[i]);
 	}
-	
+
 	if (id2node)
 		memfree(id2node);
 
+	if (seen)
+		memfree(seen);
+
+	memfree(letters);
+
+#ifdef DAWG_PERFECT_HASHING
+	*numbered = numbers;
+#else
+	*numbered = false;
+#endif
 	return DAWG_OK;
 
 error:
-	for (i=0; i < nodes_count; i++)
-		if (id2node[i] != NULL)
+	if (nodes)
+		memfree(nodes);
+
+	if (edges)
+		memfree(edges);
+
+	if (id2node) {
+		for (i=0; i < nodes_count; i++)
 			dawgnode_free(id2node[i]);
-	
-	if (id2node)
+
 		memfree(id2node);
+	}
+
+	if (seen)
+		memfree(seen);
+
+	memfree(letters);
 
 	return result;
 }
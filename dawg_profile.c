@@ -0,0 +1,174 @@
+/*
+	This is part of pydawg Python module.
+
+	Profile-guided layout: while profiling is on, lookups count
+	visits of nodes. Nodes visited most often are then placed
+	together at the beginning of nodes block, and rarely used
+	part of graph doesn't pollute cache (nor resident memory).
+
+	Saved profile refers to nodes in BFS order, which doesn't
+	depend on current layout; minimal DAWG of a set of words is
+	unique, thus profile can be applied to a graph built again
+	from the same words.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+static int
+DAWG_profile_start(DAWG* dawg) {
+	ASSERT(dawg);
+
+	if (dawg->state != CLOSED or dawg->nodes == NULL)
+		return DAWG_NOT_CLOSED;
+
+	DAWG_profile_stop(dawg);
+	dawg->profile = (uint64_t*)memcalloc(dawg->nodes_count, sizeof(uint64_t));
+	if (dawg->profile == NULL)
+		return DAWG_NO_MEM;
+
+	return DAWG_OK;
+}
+
+
+static void
+DAWG_profile_stop(DAWG* dawg) {
+	if (dawg->profile) {
+		memfree(dawg->profile);
+		dawg->profile = NULL;
+	}
+}
+
+
+static void
+DAWG_profile_visit(DAWG* dawg, const DAWGNode* node) {
+	if (dawg->profile) {
+		ASSERT(node >= dawg->nodes and node < dawg->nodes + dawg->nodes_count);
+		dawg->profile[node - dawg->nodes] += 1;
+	}
+}
+
+
+static int
+DAWG_profile_save(DAWG* dawg, uint8_t** array, size_t* size) {
+	ASSERT(dawg->profile);
+
+	const size_t n = dawg->nodes_count;
+	DAWGNode** order;
+	uint8_t* data;
+	size_t i;
+	int j;
+
+	order = (DAWGNode**)memalloc(n * sizeof(DAWGNode*));
+	data  = (uint8_t*)memalloc(8 * n);
+	if (order == NULL or data == NULL)
+		goto no_mem;
+
+	if (DAWG_get_nodes_BFS(dawg, order) != DAWG_OK)
+		goto no_mem;
+
+	for (i=0; i < n; i++) {
+		uint64_t count = dawg->profile[order[i] - dawg->nodes];
+		for (j=0; j < 8; j++) {
+			data[8*i + j] = count & 0xff;
+			count >>= 8;
+		}
+	}
+
+	memfree(order);
+	*array	= data;
+	*size	= 8 * n;
+	return DAWG_OK;
+
+no_mem:
+	if (order)
+		memfree(order);
+
+	if (data)
+		memfree(data);
+
+	return DAWG_NO_MEM;
+}
+
+
+typedef struct ProfileItem {
+	uint64_t	count;
+	size_t		index;	///< BFS index
+} ProfileItem;
+
+
+static int
+profile_item_compare(const void* a, const void* b) {
+	const ProfileItem* x = (const ProfileItem*)a;
+	const ProfileItem* y = (const ProfileItem*)b;
+
+	// decreasing counts, then BFS order
+	if (x->count != y->count)
+		return (x->count < y->count) ? +1 : -1;
+
+	return (x->index > y->index) - (x->index < y->index);
+}
+
+
+static int
+DAWG_profile_relayout(DAWG* dawg, const uint8_t* array, const size_t size) {
+	ASSERT(dawg);
+
+	DAWGStatistics stats;
+	DAWGNode** bfs = NULL;
+	DAWGNode** order = NULL;
+	ProfileItem* items = NULL;
+	size_t i;
+	int j;
+	int result;
+
+	if (dawg->state != CLOSED)
+		return DAWG_NOT_CLOSED;
+
+	if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	if (size != 8 * stats.nodes_count)
+		return DAWG_PROFILE_MISMATCH;
+
+	bfs   = (DAWGNode**)memalloc(stats.nodes_count * sizeof(DAWGNode*));
+	order = (DAWGNode**)memalloc(stats.nodes_count * sizeof(DAWGNode*));
+	items = (ProfileItem*)memalloc(stats.nodes_count * sizeof(ProfileItem));
+	if (bfs == NULL or order == NULL or items == NULL) {
+		result = DAWG_NO_MEM;
+		goto finish;
+	}
+
+	result = DAWG_get_nodes_BFS(dawg, bfs);
+	if (result != DAWG_OK)
+		goto finish;
+
+	for (i=0; i < stats.nodes_count; i++) {
+		uint64_t count = 0;
+		for (j=7; j >= 0; j--)
+			count = (count << 8) | array[8*i + j];
+
+		items[i].count = count;
+		items[i].index = i;
+	}
+
+	qsort(items, stats.nodes_count, sizeof(ProfileItem), profile_item_compare);
+	for (i=0; i < stats.nodes_count; i++)
+		order[i] = bfs[items[i].index];
+
+	result = DAWG_relayout(dawg, order, stats.nodes_count);
+
+finish:
+	if (bfs)
+		memfree(bfs);
+
+	if (order)
+		memfree(order);
+
+	if (items)
+		memfree(items);
+
+	return result;
+}
@@ -0,0 +1,149 @@
+/*
+	This is part of pydawg Python module.
+
+	Registry of images shared by interpreters.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "dawg_shared.h"
+
+// interpreters may have own GILs, GIL doesn't protect registry;
+// locks are statically initialized, there's no race on setup
+#ifdef DAWG_POSIX
+#	include <pthread.h>
+
+static pthread_mutex_t shared_lock = PTHREAD_MUTEX_INITIALIZER;
+
+#	define shared_acquire()	pthread_mutex_lock(&shared_lock)
+#	define shared_release()	pthread_mutex_unlock(&shared_lock)
+#else
+#	include <windows.h>
+
+static SRWLOCK shared_lock = SRWLOCK_INIT;
+
+#	define shared_acquire()	AcquireSRWLockExclusive(&shared_lock)
+#	define shared_release()	ReleaseSRWLockExclusive(&shared_lock)
+#endif
+
+static DAWGShared* shared_images = NULL;
+
+
+static DAWGShared*
+shared_find(const char* name) {
+	DAWGShared* shared;
+	for (shared = shared_images; shared != NULL; shared = shared->next)
+		if (strcmp(shared->name, name) == 0)
+			return shared;
+
+	return NULL;
+}
+
+
+static void
+shared_free(DAWGShared* shared) {
+	if (shared->name)
+		PyMem_RawFree(shared->name);
+
+	PyMem_RawFree(shared->image);
+	PyMem_RawFree(shared);
+}
+
+
+static int
+DAWG_shared_publish(const char* name, const uint8_t* image, const size_t size) {
+	DAWGShared* shared;
+	const size_t length = strlen(name);
+
+	// copy is made before lock is taken
+	shared = (DAWGShared*)PyMem_RawMalloc(sizeof(DAWGShared));
+	if (shared == NULL)
+		return DAWG_NO_MEM;
+
+	shared->name	= (char*)PyMem_RawMalloc(length + 1);
+	shared->image	= (uint8_t*)PyMem_RawMalloc(size);
+	shared->size	= size;
+	shared->users	= 0;
+	if (shared->name == NULL or shared->image == NULL) {
+		shared_free(shared);
+		return DAWG_NO_MEM;
+	}
+
+	memcpy(shared->name, name, length + 1);
+	memcpy(shared->image, image, size);
+
+	shared_acquire();
+	const bool exists = (shared_find(name) != NULL);
+	if (not exists) {
+		shared->next	= shared_images;
+		shared_images	= shared;
+	}
+	shared_release();
+
+	if (exists) {
+		shared_free(shared);
+		return DAWG_EXISTS;
+	}
+
+	return DAWG_OK;
+}
+
+
+static bool
+DAWG_shared_unpublish(const char* name) {
+	DAWGShared** prev;
+	DAWGShared* shared = NULL;
+	bool unused = false;
+
+	shared_acquire();
+	for (prev = &shared_images; *prev != NULL; prev = &(*prev)->next)
+		if (strcmp((*prev)->name, name) == 0) {
+			shared	= *prev;
+			*prev	= shared->next;
+			PyMem_RawFree(shared->name);
+			shared->name = NULL;
+			unused = (shared->users == 0);
+			break;
+		}
+	shared_release();
+
+	if (shared == NULL)
+		return false;
+
+	if (unused)
+		shared_free(shared);
+
+	return true;
+}
+
+
+static DAWGShared*
+DAWG_shared_attach(const char* name) {
+	DAWGShared* shared;
+
+	shared_acquire();
+	shared = shared_find(name);
+	if (shared)
+		shared->users += 1;
+	shared_release();
+
+	return shared;
+}
+
+
+static void
+DAWG_shared_detach(DAWGShared* shared) {
+	bool unused;
+
+	shared_acquire();
+	ASSERT(shared->users > 0);
+	shared->users -= 1;
+	unused = (shared->users == 0 and shared->name == NULL);
+	shared_release();
+
+	if (unused)
+		shared_free(shared);
+}
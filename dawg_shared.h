@@ -0,0 +1,57 @@
+/*
+	This is part of pydawg Python module.
+
+	Registry of read-only images shared by all interpreters of
+	process. Image is published under a name, any interpreter can
+	attach to it and query the same memory; nothing is copied
+	and nothing is written. Images and registry are allocated with
+	raw allocator, they don't belong to any interpreter, registry
+	is guarded by a process-wide lock.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_shared_h_included__
+#define dawg_shared_h_included__
+
+#include "common.h"
+
+typedef struct DAWGShared {
+	struct DAWGShared*	next;	///< next published image
+	char*		name;			///< NULL once image is unpublished
+	uint8_t*	image;			///< 8-byte aligned
+	size_t		size;
+	size_t		users;			///< number of attached objects
+} DAWGShared;
+
+
+/**	Publish copy of image under given name.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_EXISTS			--- name is already used
+*/
+static int
+DAWG_shared_publish(const char* name, const uint8_t* image, const size_t size);
+
+
+/*	Remove name from registry; image is freed when the last
+	user detaches. Returns false if name wasn't published.
+*/
+static bool
+DAWG_shared_unpublish(const char* name);
+
+
+/* returns image published under name, NULL if there's no such name */
+static DAWGShared*
+DAWG_shared_attach(const char* name);
+
+
+/* release image returned by DAWG_shared_attach */
+static void
+DAWG_shared_detach(DAWGShared* shared);
+
+#endif
@@ -0,0 +1,786 @@
+/*
+	This is part of pydawg Python module.
+
+	Succinct representation of a closed DAWG.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#include "dawg_succinct.h"
+
+#define SUCCINCT_NONE	((size_t)-1)
+
+
+/* number of 64-bit words needed to store given number of bits (plus padding) */
+#define bits_words(bits) (((bits) + 63)/64 + 1)
+
+
+static uint64_t PURE
+bits_get(const uint64_t* array, const size_t pos, const unsigned width) {
+	const size_t	 index	= pos / 64;
+	const unsigned	 offset	= pos % 64;
+
+	uint64_t value = array[index] >> offset;
+	if (offset + width > 64)
+		value |= array[index + 1] << (64 - offset);
+
+	if (width < 64)
+		return value & ((UINT64_C(1) << width) - 1);
+	else
+		return value;
+}
+
+
+static void
+bits_set(uint64_t* array, const size_t pos, const unsigned width, const uint64_t value) {
+	// array is zeroed, it is enough to OR bits
+	const size_t	 index	= pos / 64;
+	const unsigned	 offset	= pos % 64;
+
+	array[index] |= value << offset;
+	if (offset + width > 64)
+		array[index + 1] |= value >> (64 - offset);
+}
+
+
+/* number of bits needed to save value (at least 1) */
+static unsigned
+bits_for(const uint64_t value) {
+	unsigned bits = 1;
+	while (bits < 64 and (value >> bits) != 0)
+		bits += 1;
+
+	return bits;
+}
+
+
+static void
+DAWG_succinct_init(DAWGSuccinct* succinct) {
+	succinct->nodes_count	= 0;
+	succinct->edges_count	= 0;
+	succinct->words_count	= 0;
+	succinct->longest_word	= 0;
+	succinct->letter_bits	= 0;
+	succinct->child_bits	= 0;
+	succinct->count_bits	= 0;
+	succinct->shape			= NULL;
+	succinct->eow			= NULL;
+	succinct->letters		= NULL;
+	succinct->children		= NULL;
+#ifdef DAWG_PERFECT_HASHING
+	succinct->counts		= NULL;
+#endif
+	succinct->select		= NULL;
+
+	DAWG_alphabet_init(&succinct->alphabet);
+}
+
+
+static void
+DAWG_succinct_free(DAWGSuccinct* succinct) {
+#define free_array(name) if (succinct->name) memfree(succinct->name);
+	free_array(shape);
+	free_array(eow);
+	free_array(letters);
+	free_array(children);
+#ifdef DAWG_PERFECT_HASHING
+	free_array(counts);
+#endif
+	free_array(select);
+#undef free_array
+
+	DAWG_alphabet_free(&succinct->alphabet);
+	DAWG_succinct_init(succinct);
+}
+
+
+/* sizes of bit arrays (in words) */
+#define shape_words(s)		bits_words((s)->nodes_count + (s)->edges_count + 1)
+#define eow_words(s)		bits_words((s)->nodes_count)
+#define letters_words(s)	bits_words((s)->edges_count * (s)->letter_bits)
+#define children_words(s)	bits_words((s)->edges_count * (s)->child_bits)
+#define counts_words(s)		bits_words((s)->nodes_count * (s)->count_bits)
+#define select_words(s)		(((s)->nodes_count + 1 + SUCCINCT_SELECT_SAMPLE - 1)/SUCCINCT_SELECT_SAMPLE)
+
+
+static int
+succinct_alloc(DAWGSuccinct* succinct) {
+#define alloc_array(name) \
+	succinct->name = memcalloc(name##_words(succinct), sizeof(uint64_t)); \
+	if (succinct->name == NULL) \
+		return DAWG_NO_MEM;
+
+	alloc_array(shape);
+	alloc_array(eow);
+	alloc_array(letters);
+	alloc_array(children);
+#ifdef DAWG_PERFECT_HASHING
+	alloc_array(counts);
+#endif
+	alloc_array(select);
+#undef alloc_array
+
+	return DAWG_OK;
+}
+
+
+static void
+succinct_build_select(DAWGSuccinct* succinct) {
+	const size_t words = shape_words(succinct);
+	size_t rank = 0;
+	size_t i;
+
+	for (i=0; i < words; i++) {
+		uint64_t word = succinct->shape[i];
+		while (word) {
+			if (rank % SUCCINCT_SELECT_SAMPLE == 0)
+				succinct->select[rank / SUCCINCT_SELECT_SAMPLE] = i*64 + CTZ64(word);
+
+			word &= word - 1;
+			rank += 1;
+		}
+	}
+
+	ASSERT(rank == succinct->nodes_count + 1);
+}
+
+
+/* position of i-th bit 1 in shape (counting from 0) */
+static size_t PURE
+succinct_select(const DAWGSuccinct* succinct, const size_t i) {
+	const size_t sample = i / SUCCINCT_SELECT_SAMPLE;
+	const size_t pos	= succinct->select[sample];
+
+	size_t	 k		= i - sample * SUCCINCT_SELECT_SAMPLE;
+	size_t	 index	= pos / 64;
+	uint64_t word	= succinct->shape[index] & (~UINT64_C(0) << (pos % 64));
+
+	while (true) {
+		const size_t count = POPCOUNT64(word);
+		if (k < count)
+			break;
+
+		k	-= count;
+		word = succinct->shape[++index];
+	}
+
+	while (k--)
+		word &= word - 1;
+
+	return index*64 + CTZ64(word);
+}
+
+
+/* position of the first bit 1 in shape past pos */
+static size_t PURE
+succinct_next_one(const DAWGSuccinct* succinct, const size_t pos) {
+	size_t	 index	= (pos + 1) / 64;
+	uint64_t word	= succinct->shape[index] & (~UINT64_C(0) << ((pos + 1) % 64));
+
+	// shape is terminated by bit 1
+	while (word == 0)
+		word = succinct->shape[++index];
+
+	return index*64 + CTZ64(word);
+}
+
+
+static DAWGSuccinctRange PURE
+DAWG_succinct_edges(const DAWGSuccinct* succinct, const size_t node) {
+	DAWGSuccinctRange range;
+	const size_t p = succinct_select(succinct, node);
+	const size_t q = succinct_next_one(succinct, p);
+
+	range.first	= p - node;
+	range.end	= q - node - 1;
+
+	return range;
+}
+
+
+#define letter_code(s, edge)	((uint32_t)bits_get((s)->letters, (edge) * (s)->letter_bits, (s)->letter_bits) + 1)
+#define child_node(s, edge)		((size_t)bits_get((s)->children, (edge) * (s)->child_bits, (s)->child_bits))
+#define node_count(s, node)		((size_t)bits_get((s)->counts, (node) * (s)->count_bits, (s)->count_bits))
+
+
+static DAWG_LETTER_TYPE PURE
+DAWG_succinct_letter(const DAWGSuccinct* succinct, const size_t edge) {
+	return DAWG_alphabet_letter(&succinct->alphabet, letter_code(succinct, edge));
+}
+
+
+static size_t PURE
+DAWG_succinct_child(const DAWGSuccinct* succinct, const size_t edge) {
+	return child_node(succinct, edge);
+}
+
+
+static bool PURE
+DAWG_succinct_eow(const DAWGSuccinct* succinct, const size_t node) {
+	return (succinct->eow[node / 64] >> (node % 64)) & 1;
+}
+
+
+/* returns edge labelled with letter of given code, or SUCCINCT_NONE */
+static size_t PURE
+succinct_find_edge(const DAWGSuccinct* succinct, const size_t node, const uint32_t code) {
+	const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, node);
+
+	// binary search, edges are sorted by letter
+	size_t a = range.first;
+	size_t b = range.end;
+	while (a < b) {
+		const size_t c = (a + b)/2;
+		const uint32_t x = letter_code(succinct, c);
+		if (x == code)
+			return c;
+		else if (x > code)
+			b = c;
+		else
+			a = c + 1;
+	}
+
+	return SUCCINCT_NONE;
+}
+
+
+static int
+DAWG_succinct_compile(DAWG* dawg, DAWGSuccinct* succinct) {
+	ASSERT(dawg);
+	ASSERT(succinct);
+
+	if (dawg->state != CLOSED)
+		return DAWG_NOT_CLOSED;
+
+	DAWGStatistics stats;
+	DAWGNode** nodes = NULL;
+	addr_HashTable ids;
+	size_t i, j;
+	int result;
+
+	DAWG_succinct_free(succinct);
+	if (DAWG_get_stats(dawg, &stats) != DAWG_OK)
+		return DAWG_NO_MEM;
+
+	if (addr_hashtable_init(&ids, stats.nodes_count * 10/7 + 1) < 0)
+		return DAWG_NO_MEM;
+
+#ifdef DAWG_PERFECT_HASHING
+	result = DAWG_mph_numerate_nodes(dawg);
+	if (result != DAWG_OK)
+		goto error;
+#endif
+
+	result = DAWG_get_alphabet(dawg, &succinct->alphabet);
+	if (result != DAWG_OK)
+		goto error;
+
+	succinct->nodes_count	= stats.nodes_count;
+	succinct->edges_count	= stats.edges_count;
+	succinct->words_count	= dawg->count;
+	succinct->longest_word	= dawg->longest_word;
+	succinct->letter_bits	= bits_for(succinct->alphabet.size > 0 ? succinct->alphabet.size - 1 : 0);
+	succinct->child_bits	= bits_for(stats.nodes_count - 1);
+	succinct->count_bits	= bits_for(dawg->count);
+
+	result = DAWG_NO_MEM;
+	if (succinct_alloc(succinct) != DAWG_OK)
+		goto error;
+
+	// 1. number nodes in BFS order
+	nodes = memalloc(stats.nodes_count * sizeof(DAWGNode*));
+	if (nodes == NULL)
+		goto error;
+
+	if (DAWG_get_nodes_BFS(dawg, nodes) != DAWG_OK)
+		goto error;
+	for (i=0; i < stats.nodes_count; i++)
+		if (addr_hashtable_add(&ids, nodes[i], i) < 0)
+			goto error;
+
+	// 2. fill bit arrays
+	size_t pos	= 0;
+	size_t edge	= 0;
+	for (i=0; i < stats.nodes_count; i++) {
+		DAWGNode* node = nodes[i];
+
+		bits_set(succinct->shape, pos++, 1, 1);
+		bits_set(succinct->eow, i, 1, node->eow);
+#ifdef DAWG_PERFECT_HASHING
+		bits_set(succinct->counts, i * succinct->count_bits, succinct->count_bits, node->number);
+#endif
+
+		for (j=0; j < node->n; j++, edge++, pos++) {
+			const uint32_t code = DAWG_alphabet_code(&succinct->alphabet, node->next[j].letter);
+			addr_HashListItem* item = addr_hashtable_get(&ids, node->next[j].child);
+			ASSERT(code > 0);
+			ASSERT(item);
+
+			bits_set(succinct->letters, edge * succinct->letter_bits, succinct->letter_bits, code - 1);
+			bits_set(succinct->children, edge * succinct->child_bits, succinct->child_bits, item->data);
+		}
+	}
+
+	bits_set(succinct->shape, pos, 1, 1);	// terminator
+	ASSERT(edge == stats.edges_count);
+
+	succinct_build_select(succinct);
+	result = DAWG_OK;
+
+error:
+	if (nodes)
+		memfree(nodes);
+
+	addr_hashtable_destroy(&ids);
+	if (result != DAWG_OK)
+		DAWG_succinct_free(succinct);
+
+	return result;
+}
+
+
+static void
+DAWG_succinct_get_stats(const DAWGSuccinct* succinct, DAWGSuccinctStatistics* stats) {
+	stats->nodes_count		= succinct->nodes_count;
+	stats->edges_count		= succinct->edges_count;
+	stats->words_count		= succinct->words_count;
+	stats->longest_word		= succinct->longest_word;
+	stats->alphabet_size	= succinct->alphabet.size;
+	stats->letter_bits		= succinct->letter_bits;
+	stats->child_bits		= succinct->child_bits;
+	stats->count_bits		= succinct->count_bits;
+
+	stats->size = (shape_words(succinct) +
+				   eow_words(succinct) +
+				   letters_words(succinct) +
+				   children_words(succinct) +
+#ifdef DAWG_PERFECT_HASHING
+				   counts_words(succinct) +
+#endif
+				   select_words(succinct)) * sizeof(uint64_t) +
+				   succinct->alphabet.size * DAWG_LETTER_SIZE +
+				   succinct->alphabet.lut_size * sizeof(uint32_t);
+}
+
+
+static bool PURE
+DAWG_succinct_exists(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(succinct->nodes_count == 0))
+		return false;
+
+	size_t node = 0;
+	size_t i;
+	for (i=0; i < wordlen; i++) {
+		const uint32_t code = DAWG_alphabet_code(&succinct->alphabet, word[i]);
+		if (code == 0)
+			return false;
+
+		const size_t edge = succinct_find_edge(succinct, node, code);
+		if (edge == SUCCINCT_NONE)
+			return false;
+
+		node = child_node(succinct, edge);
+	}
+
+	return DAWG_succinct_eow(succinct, node);
+}
+
+
+static size_t PURE
+DAWG_succinct_longest_prefix(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(succinct->nodes_count == 0))
+		return 0;
+
+	size_t node = 0;
+	size_t i;
+	for (i=0; i < wordlen; i++) {
+		const uint32_t code = DAWG_alphabet_code(&succinct->alphabet, word[i]);
+		if (code == 0)
+			break;
+
+		const size_t edge = succinct_find_edge(succinct, node, code);
+		if (edge == SUCCINCT_NONE)
+			break;
+
+		node = child_node(succinct, edge);
+	}
+
+	return i;
+}
+
+
+#ifdef DAWG_PERFECT_HASHING
+static size_t PURE
+DAWG_succinct_word2index(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+	if (UNLIKELY(succinct->nodes_count == 0))
+		return DAWG_NOT_EXISTS;
+
+	size_t index = 0;
+	size_t node = 0;
+	size_t i, j;
+	for (i=0; i < wordlen; i++) {
+		const uint32_t code = DAWG_alphabet_code(&succinct->alphabet, word[i]);
+		if (code == 0)
+			return DAWG_NOT_EXISTS;
+
+		const size_t edge = succinct_find_edge(succinct, node, code);
+		if (edge == SUCCINCT_NONE)
+			return DAWG_NOT_EXISTS;
+
+		const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, node);
+		for (j=range.first; j < edge; j++)
+			index += node_count(succinct, child_node(succinct, j));
+
+		node = child_node(succinct, edge);
+		if (DAWG_succinct_eow(succinct, node))
+			index += 1;
+	}
+
+	return DAWG_succinct_eow(succinct, node) ? index : DAWG_NOT_EXISTS;
+}
+
+
+static int
+DAWG_succinct_index2word(const DAWGSuccinct* succinct, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen) {
+	// the empty word has no index
+	if (index < 1 or index > succinct->words_count - DAWG_succinct_eow(succinct, 0))
+		return DAWG_NOT_EXISTS;
+
+	*wordlen = 0;
+	*word = (DAWG_LETTER_TYPE*)memalloc((succinct->longest_word + 1) * DAWG_LETTER_SIZE);
+	if (*word == NULL)
+		return DAWG_NO_MEM;
+
+	size_t node = 0;
+	size_t count = index;
+	size_t i;
+	do {
+		const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, node);
+		for (i=range.first; i < range.end; i++) {
+			const size_t child = child_node(succinct, i);
+			const size_t n = node_count(succinct, child);
+			if (n < count)
+				count -= n;
+			else {
+				(*word)[*wordlen] = DAWG_succinct_letter(succinct, i);
+				*wordlen += 1;
+
+				node = child;
+				if (DAWG_succinct_eow(succinct, node))
+					count -= 1;
+
+				break;
+			}
+		}
+	}
+	while (count > 0);
+
+	return DAWG_EXISTS;
+}
+#endif
+
+
+/*
+	Format of data:
+
+	- magick				: 4 bytes
+	- padding				: 4 bytes
+	- nodes count			: 8 bytes
+	- edges count			: 8 bytes
+	- words count			: 8 bytes
+	- longest word			: 8 bytes
+	- alphabet size			: 8 bytes
+	- letter bits			: 8 bytes
+	- child bits			: 8 bytes
+	- count bits			: 8 bytes
+	- alphabet				: 1, 2 or 4 bytes per letter, padded to 8 bytes
+	- bit arrays shape, eow, letters, children [, counts]
+*/
+
+#define SUCCINCT_HEADER_SIZE (4 + 4 + 8*8)
+
+#ifdef DAWG_PERFECT_HASHING
+#	define SUCCINCT_MAGICK_MPH 0x01
+#else
+#	define SUCCINCT_MAGICK_MPH 0x00
+#endif
+
+#ifdef DAWG_UTF8
+#	define SUCCINCT_MAGICK_LETTER 0x81	// UTF-8 sequences
+#else
+#	define SUCCINCT_MAGICK_LETTER DAWG_LETTER_SIZE
+#endif
+
+#define SUCCINCT_MAGICK (0x53440000 | (SUCCINCT_MAGICK_LETTER << 8) | SUCCINCT_MAGICK_MPH)
+
+#define alphabet_bytes(s) ((((s)->alphabet.size * DAWG_LETTER_SIZE) + 7) & ~(size_t)7)
+
+static size_t
+succinct_save_size(const DAWGSuccinct* succinct) {
+	return SUCCINCT_HEADER_SIZE +
+		   alphabet_bytes(succinct) +
+		   (shape_words(succinct) +
+		    eow_words(succinct) +
+		    letters_words(succinct) +
+		    children_words(succinct)
+#ifdef DAWG_PERFECT_HASHING
+		    + counts_words(succinct)
+#endif
+		   ) * sizeof(uint64_t);
+}
+
+
+static int
+DAWG_succinct_save(const DAWGSuccinct* succinct, uint8_t** array, size_t* size) {
+	const size_t total = succinct_save_size(succinct);
+	uint8_t* data = memcalloc(total, 1);
+	if (data == NULL)
+		return DAWG_NO_MEM;
+
+	size_t top = 0;
+#define save_4bytes(x) *(uint32_t*)(data + top) = (x); top += 4;
+#define save_8bytes(x) *(uint64_t*)(data + top) = (x); top += 8;
+#define save_array(ptr, bytes) memcpy(data + top, (ptr), (bytes)); top += (bytes);
+	save_4bytes(SUCCINCT_MAGICK);
+	save_4bytes(0);
+	save_8bytes(succinct->nodes_count);
+	save_8bytes(succinct->edges_count);
+	save_8bytes(succinct->words_count);
+	save_8bytes(succinct->longest_word);
+	save_8bytes(succinct->alphabet.size);
+	save_8bytes(succinct->letter_bits);
+	save_8bytes(succinct->child_bits);
+	save_8bytes(succinct->count_bits);
+
+	memcpy(data + top, succinct->alphabet.letters, succinct->alphabet.size * DAWG_LETTER_SIZE);
+	top += alphabet_bytes(succinct);
+
+	save_array(succinct->shape,		shape_words(succinct) * sizeof(uint64_t));
+	save_array(succinct->eow,		eow_words(succinct) * sizeof(uint64_t));
+	save_array(succinct->letters,	letters_words(succinct) * sizeof(uint64_t));
+	save_array(succinct->children,	children_words(succinct) * sizeof(uint64_t));
+#ifdef DAWG_PERFECT_HASHING
+	save_array(succinct->counts,	counts_words(succinct) * sizeof(uint64_t));
+#endif
+#undef save_array
+#undef save_8bytes
+#undef save_4bytes
+
+	ASSERT(top == total);
+
+	*array	= data;
+	*size	= total;
+	return DAWG_OK;
+}
+
+
+/* check if shape has nodes_count + 1 bits set and ends with bit 1 */
+static bool
+succinct_validate_shape(const DAWGSuccinct* succinct) {
+	const size_t bits = succinct->nodes_count + succinct->edges_count + 1;
+	size_t ones = 0;
+	size_t i;
+
+	for (i=0; i < shape_words(succinct); i++)
+		ones += POPCOUNT64(succinct->shape[i]);
+
+	if (ones != succinct->nodes_count + 1)
+		return false;
+
+	return (succinct->shape[0] & 1) and ((succinct->shape[(bits - 1)/64] >> ((bits - 1) % 64)) & 1);
+}
+
+
+/*
+	Check if edges are valid and graph is acyclic, then check if
+	counts saved in header (and MPH counts) agree with the graph.
+	Nodes are visited in topological order (Kahn's algorithm).
+*/
+static bool
+succinct_validate_graph(const DAWGSuccinct* succinct) {
+	const size_t n = succinct->nodes_count;
+	size_t*		indegree = memcalloc(n, sizeof(size_t));
+	size_t*		order	 = memalloc(n * sizeof(size_t));
+	uint64_t*	depth	 = memcalloc(n, sizeof(uint64_t));
+	uint64_t*	count	 = memcalloc(n, sizeof(uint64_t));
+	uint64_t	longest	 = 0;
+	bool		valid	 = false;
+	size_t head, tail;
+	size_t i, j;
+
+	if (indegree == NULL or order == NULL or depth == NULL or count == NULL)
+		goto end;
+
+	for (i=0; i < n; i++) {
+		const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, i);
+		for (j=range.first; j < range.end; j++) {
+			if (letter_code(succinct, j) > succinct->alphabet.size)
+				goto end;
+
+			// edges are sorted by letters
+			if (j > range.first and letter_code(succinct, j - 1) >= letter_code(succinct, j))
+				goto end;
+
+			if (child_node(succinct, j) >= n)
+				goto end;
+
+			indegree[child_node(succinct, j)] += 1;
+		}
+	}
+
+	tail = 0;
+	for (i=0; i < n; i++)
+		if (indegree[i] == 0)
+			order[tail++] = i;
+
+	for (head=0; head < tail; head++) {
+		const size_t node = order[head];
+		const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, node);
+		for (j=range.first; j < range.end; j++) {
+			const size_t child = child_node(succinct, j);
+			if (depth[child] < depth[node] + 1)
+				depth[child] = depth[node] + 1;
+
+			if (--indegree[child] == 0)
+				order[tail++] = child;
+		}
+	}
+
+	if (tail != n)	// cycle
+		goto end;
+
+	for (i=n; i > 0; i--) {
+		const size_t node = order[i - 1];
+		const DAWGSuccinctRange range = DAWG_succinct_edges(succinct, node);
+
+		if (depth[node] > longest)
+			longest = depth[node];
+
+		count[node] = DAWG_succinct_eow(succinct, node);
+		for (j=range.first; j < range.end; j++)
+			count[node] += count[child_node(succinct, j)];
+
+#ifdef DAWG_PERFECT_HASHING
+		if (count[node] != node_count(succinct, node))
+			goto end;
+#endif
+	}
+
+	valid = (count[0] == succinct->words_count) and (longest == succinct->longest_word);
+
+end:
+	if (indegree)	memfree(indegree);
+	if (order)		memfree(order);
+	if (depth)		memfree(depth);
+	if (count)		memfree(count);
+
+	return valid;
+}
+
+
+static int
+DAWG_succinct_load(DAWGSuccinct* succinct, const uint8_t* array, const size_t size) {
+	DAWGSuccinct tmp;
+	size_t top = 0;
+	int result;
+
+	if (size < SUCCINCT_HEADER_SIZE)
+		return DAWG_DUMP_TRUNCATED;
+
+	DAWG_succinct_init(&tmp);
+
+#define get_4bytes (top += 4, (*(uint32_t*)(array + top - 4)))
+#define get_8bytes (top += 8, (*(uint64_t*)(array + top - 8)))
+	if (get_4bytes != SUCCINCT_MAGICK)
+		return DAWG_DUMP_INVALID_MAGICK;
+
+	top += 4;	// padding
+	tmp.nodes_count		= get_8bytes;
+	tmp.edges_count		= get_8bytes;
+	tmp.words_count		= get_8bytes;
+	tmp.longest_word	= get_8bytes;
+	const uint64_t alphabet_size = get_8bytes;
+	tmp.letter_bits		= get_8bytes;
+	tmp.child_bits		= get_8bytes;
+	tmp.count_bits		= get_8bytes;
+#undef get_8bytes
+#undef get_4bytes
+
+	if (tmp.nodes_count == 0 or
+		tmp.letter_bits == 0 or tmp.letter_bits > 32 or
+		tmp.child_bits == 0 or tmp.child_bits > 64 or
+		tmp.count_bits == 0 or tmp.count_bits > 64 or
+		alphabet_size > ((uint64_t)1 << tmp.letter_bits) or
+		alphabet_size > size or tmp.nodes_count > size * 8 or tmp.edges_count > size * 8)
+		return DAWG_DUMP_CORRUPTED_1;
+
+	tmp.alphabet.size = alphabet_size;
+	if (succinct_save_size(&tmp) != size) {
+		tmp.alphabet.size = 0;
+		return DAWG_DUMP_TRUNCATED;
+	}
+
+	const DAWG_LETTER_TYPE* letters = (const DAWG_LETTER_TYPE*)(array + top);
+	size_t i;
+	for (i=1; i < alphabet_size; i++)
+		if (letters[i - 1] >= letters[i]) {
+			tmp.alphabet.size = 0;
+			return DAWG_DUMP_CORRUPTED_1;
+		}
+
+	result = DAWG_alphabet_set(&tmp.alphabet, letters, alphabet_size);
+	if (result != DAWG_OK)
+		return result;
+
+	top += alphabet_bytes(&tmp);
+
+	result = DAWG_NO_MEM;
+	if (succinct_alloc(&tmp) != DAWG_OK)
+		goto error;
+
+#define load_array(name) \
+	memcpy(tmp.name, array + top, name##_words(&tmp) * sizeof(uint64_t)); \
+	top += name##_words(&tmp) * sizeof(uint64_t);
+
+	load_array(shape);
+	load_array(eow);
+	load_array(letters);
+	load_array(children);
+#ifdef DAWG_PERFECT_HASHING
+	load_array(counts);
+#endif
+#undef load_array
+
+	ASSERT(top == size);
+
+	result = DAWG_DUMP_CORRUPTED_1;
+	if (not succinct_validate_shape(&tmp))
+		goto error;
+
+	succinct_build_select(&tmp);
+	if (not succinct_validate_graph(&tmp))
+		goto error;
+
+	DAWG_succinct_free(succinct);
+	*succinct = tmp;
+	return DAWG_OK;
+
+error:
+	DAWG_succinct_free(&tmp);
+	return result;
+}
+
+#undef node_count
+#undef child_node
+#undef letter_code
+#undef alphabet_bytes
+#undef select_words
+#undef counts_words
+#undef children_words
+#undef letters_words
+#undef eow_words
+#undef shape_words
+#undef bits_words
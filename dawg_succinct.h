@@ -0,0 +1,173 @@
+/*
+	This is part of pydawg Python module.
+
+	Succinct, read-only representation of a closed DAWG.
+
+	Nodes are numbered in BFS order, the root has number 0.
+	Structure of graph is saved in bit arrays:
+
+	- shape		: for each node bit 1 followed by as many bits 0
+				  as the node has edges, terminated by extra bit 1;
+				  edges of node v are placed at positions
+				  select1(v) - v ... select1(v + 1) - v - 1
+	- eow		: end-of-word markers, one bit per node
+	- letters	: codes of letters (see DAWGAlphabet), letter_bits per edge
+	- children	: destinations of edges, child_bits = ceil(log2(nodes)) per edge
+	- counts	: number of words reachable from a node (used by MPH),
+				  count_bits per node
+
+	Every SUCCINCT_SELECT_SAMPLE-th bit 1 in shape has its position
+	saved, thus select1 scans just a few words.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_succinct_h_included__
+#define dawg_succinct_h_included__
+
+#include "common.h"
+#include "dawg.h"
+#include "dawg_alphabet.h"
+
+#define SUCCINCT_SELECT_SAMPLE	64
+
+typedef struct DAWGSuccinct {
+	size_t		nodes_count;
+	size_t		edges_count;
+	uint64_t	words_count;
+	uint64_t	longest_word;
+
+	DAWGAlphabet alphabet;		///< letter => code translation
+
+	unsigned	letter_bits;	///< width of letter code
+	unsigned	child_bits;		///< width of node number
+	unsigned	count_bits;		///< width of words count
+
+	uint64_t*	shape;			///< nodes_count + edges_count + 1 bits
+	uint64_t*	eow;			///< nodes_count bits
+	uint64_t*	letters;		///< edges_count * letter_bits bits
+	uint64_t*	children;		///< edges_count * child_bits bits
+#ifdef DAWG_PERFECT_HASHING
+	uint64_t*	counts;			///< nodes_count * count_bits bits
+#endif
+
+	uint64_t*	select;			///< positions of every SUCCINCT_SELECT_SAMPLE-th bit 1 in shape
+} DAWGSuccinct;
+
+
+typedef struct DAWGSuccinctStatistics {
+	size_t	nodes_count;
+	size_t	edges_count;
+	size_t	words_count;
+	size_t	longest_word;
+	size_t	alphabet_size;
+	size_t	letter_bits;
+	size_t	child_bits;
+	size_t	count_bits;
+	size_t	size;
+} DAWGSuccinctStatistics;
+
+
+/* range of edges of a node */
+typedef struct DAWGSuccinctRange {
+	size_t	first;		///< index of the first edge
+	size_t	end;		///< index past the last edge
+} DAWGSuccinctRange;
+
+
+/* init empty structure */
+static void
+DAWG_succinct_init(DAWGSuccinct* succinct);
+
+
+/* free memory */
+static void
+DAWG_succinct_free(DAWGSuccinct* succinct);
+
+
+/**	Build succinct representation of closed DAWG.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_NOT_CLOSED
+*/
+static int
+DAWG_succinct_compile(DAWG* dawg, DAWGSuccinct* succinct);
+
+
+/* get statistics */
+static void
+DAWG_succinct_get_stats(const DAWGSuccinct* succinct, DAWGSuccinctStatistics* stats);
+
+
+/* get edges of node */
+static DAWGSuccinctRange PURE
+DAWG_succinct_edges(const DAWGSuccinct* succinct, const size_t node);
+
+
+/* get letter of edge */
+static DAWG_LETTER_TYPE PURE
+DAWG_succinct_letter(const DAWGSuccinct* succinct, const size_t edge);
+
+
+/* get destination of edge */
+static size_t PURE
+DAWG_succinct_child(const DAWGSuccinct* succinct, const size_t edge);
+
+
+/* check if node is final */
+static bool PURE
+DAWG_succinct_eow(const DAWGSuccinct* succinct, const size_t node);
+
+
+/* same as DAWG_exists */
+static bool PURE
+DAWG_succinct_exists(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_longest_prefix */
+static size_t PURE
+DAWG_succinct_longest_prefix(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+#ifdef DAWG_PERFECT_HASHING
+/* same as DAWG_mph_word2index */
+static size_t PURE
+DAWG_succinct_word2index(const DAWGSuccinct* succinct, const DAWG_LETTER_TYPE* word, const size_t wordlen);
+
+
+/* same as DAWG_mph_index2word */
+static int
+DAWG_succinct_index2word(const DAWGSuccinct* succinct, size_t index, DAWG_LETTER_TYPE** word, size_t* wordlen);
+#endif
+
+
+/**	Save structure in byte array.
+
+	@param[out]	array		address of array, array have to be freed manually
+	@param[out]	size		size of array
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+*/
+static int
+DAWG_succinct_save(const DAWGSuccinct* succinct, uint8_t** array, size_t* size);
+
+
+/**	Load structure from data returned by DAWG_succinct_save.
+
+	@returns
+		DAWG_OK
+		DAWG_NO_MEM
+		DAWG_DUMP_TRUNCATED
+		DAWG_DUMP_INVALID_MAGICK
+		DAWG_DUMP_CORRUPTED_1
+*/
+static int
+DAWG_succinct_load(DAWGSuccinct* succinct, const uint8_t* array, const size_t size);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+	This is part of pydawg Python module.
+
+	Summaries of subgraphs of closed DAWG.
+	This file is included directly in dawg.c.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+static void
+DAWG_summary_free(DAWG* dawg) {
+	if (dawg->summary) {
+		memfree(dawg->summary);
+		dawg->summary = NULL;
+	}
+}
+
+
+static int
+summary_aux(DAWGNode* node, UNUSED const size_t depth, void* extra) {
+#define dawg ((DAWG*)extra)
+	// children are already summarized
+	DAWGSummary* summary = &dawg->summary[node - dawg->nodes];
+	uint32_t min_length = node->eow ? 0 : DAWG_SUMMARY_MAX_LENGTH;
+	uint32_t max_length = 0;
+	uint32_t letters = 0;
+	size_t i;
+
+	for (i=0; i < node->n; i++) {
+		const DAWGSummary* child = &dawg->summary[node->next[i].child - dawg->nodes];
+		const uint32_t code = DAWG_alphabet_code(&dawg->alphabet, node->next[i].letter);
+
+		if (child->min_length + 1u < min_length)
+			min_length = child->min_length + 1u;
+
+		if (child->max_length + 1u > max_length)
+			max_length = child->max_length + 1u;
+
+		letters |= DAWG_summary_bit(code) | child->letters;
+	}
+
+	summary->min_length	= (min_length < DAWG_SUMMARY_MAX_LENGTH) ? min_length : DAWG_SUMMARY_MAX_LENGTH;
+	summary->max_length	= (max_length < DAWG_SUMMARY_MAX_LENGTH) ? max_length : DAWG_SUMMARY_MAX_LENGTH;
+	summary->letters	= letters;
+	return 1;
+#undef dawg
+}
+
+
+static int
+DAWG_summary_build(DAWG* dawg) {
+	ASSERT(dawg);
+
+	DAWG_summary_free(dawg);
+	if (dawg->nodes == NULL or dawg->alphabet.letters == NULL)
+		return DAWG_OK;
+
+	dawg->summary = (DAWGSummary*)memalloc(dawg->nodes_count * sizeof(DAWGSummary));
+	if (dawg->summary == NULL)
+		return DAWG_NO_MEM;
+
+	if (DAWG_traverse_DFS_once(dawg, summary_aux, dawg) < 0) {
+		DAWG_summary_free(dawg);
+		return DAWG_NO_MEM;
+	}
+
+	return DAWG_OK;
+}
+
+
+static const DAWGSummary* PURE
+DAWG_summary_get(const DAWG* dawg, const DAWGNode* node) {
+	if (dawg->summary) {
+		ASSERT(node >= dawg->nodes and node < dawg->nodes + dawg->nodes_count);
+		return &dawg->summary[node - dawg->nodes];
+	}
+	else
+		return NULL;
+}
@@ -0,0 +1,32 @@
+/*
+	This is part of pydawg Python module.
+
+	Summaries of subgraphs of closed DAWG, kept in a side array
+	indexed like nodes block: lengths of the shortest and the longest
+	word below node and set of letters on edges below node. Searches
+	with constraints (patterns, lengths) skip subgraphs which can't
+	contain any matching word.
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef dawg_summary_h_included__
+#define dawg_summary_h_included__
+
+#include "common.h"
+
+#define DAWG_SUMMARY_MAX_LENGTH	0xffff	///< lengths are saturated
+
+typedef struct DAWGSummary {
+	uint16_t	min_length;		///< length of the shortest word below node (0 if node is end of word)
+	uint16_t	max_length;		///< length of the longest word below node
+	uint32_t	letters;		///< bit (code - 1) mod 32 is set if letter of given code is below node
+} DAWGSummary;
+
+
+/* bit of letter set of given alphabet code */
+#define DAWG_summary_bit(code) ((code) ? (UINT32_C(1) << (((code) - 1) & 31)) : 0)
+
+#endif
@@ -18,7 +18,6 @@ dawgnode_new() {
 		new->n		= 0;
 		new->next	= NULL;
 		new->eow	= false;
-		new->visited = 0;
 #ifdef DAWG_PERFECT_HASHING
 		new->number = 0;
 #endif
@@ -22,9 +22,8 @@ typedef struct DAWGEdge {
 
 
 typedef struct DAWGNode {
-	uint16_t			n;			///< number of outcoming edges
 	DAWGEdge*			next;		///< outcoming edges - always sorted by letter
-	uint16_t			visited;	///< visited (field used while traversing a graph)
+	uint16_t			n;			///< number of outcoming edges
 	bool				eow;		///< End-Of-Word marker
 #ifdef DAWG_PERFECT_HASHING
 	int					number;		///< number of words reachable from this state
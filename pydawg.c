@@ -12,10 +12,19 @@
 */
 
 #include "common.h"
+#include "pydawg.h"
 #include "dawgnode.h"
 #include "dawg.h"
+#include "dawg_da.h"
+#include "dawg_succinct.h"
+#include "dawg_compact.h"
+#include "dawg_kmer.h"
 #include "DAWG_class.h"
 #include "DAWGIterator_class.h"
+#include "SuccinctDAWG_class.h"
+#include "CompactDAWG_class.h"
+#include "KmerDAWG_class.h"
+#include "SequenceDAWG_class.h"
 
 // c libary inlined
 #include "dawgnode.c"
@@ -25,39 +34,135 @@
 #include "utils.c"
 #include "DAWG_class.c"
 #include "DAWGIterator_class.c"
+#include "SuccinctDAWG_class.c"
+#include "CompactDAWG_class.c"
+#include "KmerDAWG_class.c"
+#include "SequenceDAWG_class.c"
 
 // module
-static
-PyModuleDef pydawg_module = {
-	PyModuleDef_HEAD_INIT,
-	"pydawg",
-	"pydawg module",
-	-1,
-	NULL
-};
-
-
-PyMODINIT_FUNC
-PyInit_pydawg(void) {
+static PyDAWGState*
+pydawg_get_state(PyTypeObject* type) {
 	PyObject* module;
 
-	dawg_as_sequence.sq_length   = dawgmeth_len;
-	dawg_as_sequence.sq_contains = dawgmeth_contains;
-
-	dawg_type.tp_as_sequence = &dawg_as_sequence;
-	
-	module = PyModule_Create(&pydawg_module);
+#if PY_VERSION_HEX >= 0x030B0000
+	module = PyType_GetModuleByDef(type, &pydawg_module);
 	if (module == NULL)
 		return NULL;
+#else
+	// Python subclasses don't refer to module, their bases do
+	while (type != NULL and (not PyType_HasFeature(type, Py_TPFLAGS_HEAPTYPE) or ((PyHeapTypeObject*)type)->ht_module == NULL))
+		type = type->tp_base;
 
-	if (PyType_Ready(&dawg_type) < 0) {
-		Py_DECREF(module);
+	if (type == NULL) {
+		PyErr_SetString(PyExc_TypeError, "type is not defined by pydawg module");
 		return NULL;
 	}
-	else
-		PyModule_AddObject(module, "DAWG", (PyObject*)&dawg_type);
 
-#define constant(name) PyModule_AddIntConstant(module, #name, name)
+	module = ((PyHeapTypeObject*)type)->ht_module;
+#endif
+
+	return (PyDAWGState*)PyModule_GetState(module);
+}
+
+
+#define state_types(fun) \
+	fun(dawg_type); \
+	fun(dawg_iterator_type); \
+	fun(succinct_dawg_type); \
+	fun(succinct_dawg_iterator_type); \
+	fun(compact_dawg_type); \
+	fun(compact_dawg_iterator_type); \
+	fun(kmer_dawg_type); \
+	fun(sequence_dawg_type)
+
+
+static int
+pydawg_traverse(PyObject* module, visitproc visit, void* arg) {
+	PyDAWGState* state = (PyDAWGState*)PyModule_GetState(module);
+
+#define visit_type(name) Py_VISIT(state->name)
+	state_types(visit_type);
+#undef visit_type
+
+	return 0;
+}
+
+
+static int
+pydawg_clear(PyObject* module) {
+	PyDAWGState* state = (PyDAWGState*)PyModule_GetState(module);
+
+#define clear_type(name) Py_CLEAR(state->name)
+	state_types(clear_type);
+#undef clear_type
+
+	return 0;
+}
+
+
+static void
+pydawg_free(void* module) {
+	pydawg_clear((PyObject*)module);
+}
+
+#undef state_types
+
+
+static PyTypeObject*
+pydawg_new_type(PyObject* module, PyType_Spec* spec, PyTypeObject* base) {
+	PyObject* bases = NULL;
+	PyObject* type;
+
+	// Python 3.9 accepts only tuple
+	if (base) {
+		bases = PyTuple_Pack(1, (PyObject*)base);
+		if (bases == NULL)
+			return NULL;
+	}
+
+	type = PyType_FromModuleAndSpec(module, spec, bases);
+	Py_XDECREF(bases);
+	return (PyTypeObject*)type;
+}
+
+
+/* executed for each interpreter importing module */
+static int
+pydawg_exec(PyObject* module) {
+	PyDAWGState* state = (PyDAWGState*)PyModule_GetState(module);
+
+#define new_type(name, base) \
+	state->name = pydawg_new_type(module, &name##_spec, base); \
+	if (state->name == NULL) \
+		return -1;
+
+	new_type(dawg_type, NULL);
+	new_type(dawg_iterator_type, NULL);
+	new_type(succinct_dawg_type, NULL);
+	new_type(succinct_dawg_iterator_type, NULL);
+	new_type(compact_dawg_type, NULL);
+	new_type(compact_dawg_iterator_type, NULL);
+	new_type(kmer_dawg_type, NULL);
+	new_type(sequence_dawg_type, state->dawg_type);
+#undef new_type
+
+#ifndef Py_TPFLAGS_DISALLOW_INSTANTIATION
+	state->dawg_iterator_type->tp_new			= NULL;
+	state->succinct_dawg_iterator_type->tp_new	= NULL;
+	state->compact_dawg_iterator_type->tp_new	= NULL;
+#endif
+
+	if (PyModule_AddType(module, state->dawg_type) < 0 or
+		PyModule_AddType(module, state->succinct_dawg_type) < 0 or
+		PyModule_AddType(module, state->compact_dawg_type) < 0 or
+		PyModule_AddType(module, state->kmer_dawg_type) < 0 or
+		PyModule_AddType(module, state->sequence_dawg_type) < 0)
+		return -1;
+
+#define constant(name) \
+	if (PyModule_AddIntConstant(module, #name, name) < 0) \
+		return -1;
+
 	constant(EMPTY);
 	constant(ACTIVE);
 	constant(CLOSED);
@@ -65,6 +170,9 @@ PyInit_pydawg(void) {
 	constant(MATCH_EXACT_LENGTH);
 	constant(MATCH_AT_MOST_PREFIX);
 	constant(MATCH_AT_LEAST_PREFIX);
+
+	constant(LAYOUT_NONE);
+	constant(LAYOUT_BFS);
 #undef constant
 
 #ifdef DAWG_PERFECT_HASHING
@@ -79,5 +187,42 @@ PyInit_pydawg(void) {
 	PyModule_AddIntConstant(module, "unicode", 0);
 #endif
 
-	return module;
+#ifdef DAWG_UTF8
+	PyModule_AddIntConstant(module, "utf8", 1);
+#else
+	PyModule_AddIntConstant(module, "utf8", 0);
+#endif
+
+	return 0;
+}
+
+
+static
+PyModuleDef_Slot pydawg_slots[] = {
+	{Py_mod_exec, pydawg_exec},
+#ifdef Py_mod_multiple_interpreters
+	// there's no global state, images shared among interpreters are locked
+	{Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+	{0, NULL}
+};
+
+
+static
+PyModuleDef pydawg_module = {
+	PyModuleDef_HEAD_INIT,
+	"pydawg",
+	"pydawg module",
+	sizeof(PyDAWGState),
+	NULL,
+	pydawg_slots,
+	pydawg_traverse,
+	pydawg_clear,
+	pydawg_free
+};
+
+
+PyMODINIT_FUNC
+PyInit_pydawg(void) {
+	return PyModuleDef_Init(&pydawg_module);
 }
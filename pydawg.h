@@ -0,0 +1,41 @@
+/*
+	This is part of pydawg Python module.
+
+	State of Python module. Module uses multi-phase initialization,
+	classes are heap types created for each (sub)interpreter that
+	imports module, thus nothing is shared among interpreters but
+	images published with CompactDAWG.share (see dawg_shared.h).
+
+	Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+	WWW       : http://0x80.pl/proj/pydawg/
+	License   : 3-clauses BSD (see LICENSE)
+*/
+
+#ifndef pydawg_h_included__
+#define pydawg_h_included__
+
+#include "common.h"
+
+typedef struct PyDAWGState {
+	PyTypeObject*	dawg_type;
+	PyTypeObject*	dawg_iterator_type;
+	PyTypeObject*	succinct_dawg_type;
+	PyTypeObject*	succinct_dawg_iterator_type;
+	PyTypeObject*	compact_dawg_type;
+	PyTypeObject*	compact_dawg_iterator_type;
+	PyTypeObject*	kmer_dawg_type;
+	PyTypeObject*	sequence_dawg_type;
+} PyDAWGState;
+
+
+static
+PyModuleDef pydawg_module;
+
+
+/*	Returns state of module which defined type (or its base, if type
+	is a Python subclass); returns NULL and sets exception on error.
+*/
+static PyDAWGState*
+pydawg_get_state(PyTypeObject* type);
+
+#endif
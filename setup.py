@@ -23,13 +23,30 @@ module = Extension(
 		('DEBUG', 1),	# define debug mode
 		('DAWG_PERFECT_HASHING', ''),	# enable perfect hashing
 		('DAWG_UNICODE', ''),			# use unicode
+#		('DAWG_UTF8', ''),				# use unicode, save strings as UTF-8
 	],
 	depends = [
 		'DAWG_class.c', 'DAWG_class.h',
 		'DAWGIterator_class.c', 'DAWGIterator_class.h',
 		'dawg.c', 'dawg.h', 'dawg_pickle.c', 'dawg_mph.c',
+		'dawg_lookup.c',
+		'dawg_alphabet.c', 'dawg_alphabet.h',
+		'dawg_da.c', 'dawg_da.h',
+		'dawg_succinct.c', 'dawg_succinct.h',
+		'SuccinctDAWG_class.c', 'SuccinctDAWG_class.h',
+		'dawg_compact.c', 'dawg_compact.h',
+		'CompactDAWG_class.c', 'CompactDAWG_class.h',
+		'dawg_kmer.c', 'dawg_kmer.h',
+		'KmerDAWG_class.c', 'KmerDAWG_class.h',
+		'SequenceDAWG_class.c', 'SequenceDAWG_class.h',
+		'dawg_ints.c',
+		'dawg_profile.c',
+		'dawg_jump.c', 'dawg_jump.h',
+		'dawg_summary.c', 'dawg_summary.h',
 		'dawgnode.c', 'dawgcode.h',
 		'slist.h', 'slist.c',
+		'dawg_shared.c', 'dawg_shared.h',
+		'pydawg.h',
 		'utils.c',
 	]
 )
@@ -1,3 +1,4 @@
+import sys
 import unittest
 import pydawg
 
@@ -13,10 +14,14 @@ class TestDAWGBase(unittest.TestCase):
 		self.words = "cat rat attribute tribute war warbute zaaa".split()
 
 	def add_test_words(self):
+		return self.add_test_words_to(self.D)
+
+
+	def add_test_words_to(self, D):
 		for word in sorted(self.words):
-			self.assertTrue(self.D.add_word_unchecked(conv(word)))
+			self.assertTrue(D.add_word_unchecked(conv(word)))
 
-		return self.D
+		return D
 
 
 class TestDAWG(TestDAWGBase):
@@ -46,6 +51,43 @@ class TestDAWG(TestDAWGBase):
 		D = self.add_test_words()
 
 
+	def test_close_layout(self):
+		S = []
+		for layout in [pydawg.LAYOUT_NONE, pydawg.LAYOUT_BFS]:
+			D = pydawg.DAWG()
+			for word in sorted(self.words):
+				D.add_word(conv(word))
+
+			D.close(layout)
+			S.append(D.get_stats())
+			self.assertEqual(set(D.words()), set(map(conv, self.words)))
+			for word in self.words:
+				self.assertTrue(conv(word) in D)
+
+		self.assertEqual(S[0], S[1])
+		with self.assertRaises(ValueError):
+			D.close(-1)
+
+
+	def test_close_again(self):
+		import tracemalloc
+		D = self.add_test_words()
+		D.close()
+
+		# alphabet of closed DAWG is reused
+		tracemalloc.start()
+		try:
+			before = tracemalloc.get_traced_memory()[0]
+			for i in range(1000):
+				D.close()
+
+			self.assertLess(tracemalloc.get_traced_memory()[0] - before, 1000)
+		finally:
+			tracemalloc.stop()
+
+		self.assertEqual(set(D.words()), set(map(conv, self.words)))
+
+
 	def test_add_word_unchecked(self):
 		self.add_test_words()
 
@@ -117,6 +159,46 @@ class TestDAWG(TestDAWGBase):
 		self.assertEqual(D.longest_prefix(conv("")), 0)
 		self.assertEqual(D.longest_prefix(conv("y")), 0)
 
+
+	def test_lookup_many(self):
+		import array
+		D = self.add_test_words()
+		words = list(map(conv, self.words + "rating at y tributes".split())) + [conv("")]
+		exists = bytearray(D.exists(w) for w in words)
+		prefixes = array.array('I', [D.longest_prefix(w) for w in words])
+
+		# Arrow-style string array
+		encode = (lambda w: w.encode('utf-8')) if pydawg.unicode else (lambda w: w)
+		data = b''.join(map(encode, words))
+		offsets = array.array('i', [0])
+		for word in words:
+			offsets.append(offsets[-1] + len(encode(word)))
+
+		for closed in [False, True]:
+			if closed:
+				D.close()
+				D.compile_double_array()
+
+			self.assertEqual(D.exists_many(words), exists)
+			self.assertEqual(D.longest_prefix_many(words), prefixes)
+			self.assertEqual(D.exists_many(words, None), exists)
+			self.assertEqual(D.longest_prefix_many(words, None), prefixes)
+			self.assertEqual(D.exists_many(words * 300), exists * 300)	# several chunks
+			for O in [offsets, array.array('Q', offsets), offsets.tobytes()]:
+				self.assertEqual(D.exists_many(data, O), exists)
+				self.assertEqual(D.longest_prefix_many(data, O), prefixes)
+
+		self.assertEqual(D.exists_many([]), bytearray())
+		with self.assertRaises(ValueError):
+			D.exists_many(data, array.array('i', [0, len(data) + 1]))
+
+		with self.assertRaises(TypeError):
+			D.exists_many(data, array.array('d', [0, 1]))
+
+		if pydawg.unicode and not pydawg.utf8:
+			with self.assertRaises(ValueError):
+				D.exists_many(b'\xc3(', array.array('i', [0, 2]))
+
 	
 	def test_words(self):
 		D = self.add_test_words()
@@ -146,7 +228,10 @@ class TestDAWG(TestDAWGBase):
 
 
 	def findall_aux(self):
-		D = self.D
+		self.findall_aux_to(self.D)
+
+
+	def findall_aux_to(self, D):
 		words = "abcde aXcde aZcdef aYc Xbcdefgh".split()
 		for word in sorted(words):
 			D.add_word(conv(word))
@@ -179,6 +264,22 @@ class TestDAWG(TestDAWGBase):
 		self.assertEqual(set(I), set(L))
 
 
+	def test_findall_closed(self):
+		# closed DAWG skips subgraphs using their summaries
+		self.findall_aux()
+		patterns = ["a?c??", "a?c", "?", "?b???", "????e?", "X??d", "a???f", "", "aZ", "e?"]
+		how = [pydawg.MATCH_EXACT_LENGTH, pydawg.MATCH_AT_MOST_PREFIX, pydawg.MATCH_AT_LEAST_PREFIX]
+		expected = [set(self.D.find_all(conv(p), conv("?"), h)) for p in patterns for h in how]
+
+		for layout in [pydawg.LAYOUT_NONE, pydawg.LAYOUT_BFS]:
+			D = pydawg.DAWG()
+			self.findall_aux_to(D)
+			D.close(layout)
+
+			L = [set(D.find_all(conv(p), conv("?"), h)) for p in patterns for h in how]
+			self.assertEqual(L, expected)
+
+
 	def test_get_stats(self):
 		D = self.add_test_words()
 		print(self.D.get_stats())
@@ -212,6 +313,22 @@ class TestDumpLoad(TestDAWGBase):
 		D.add_word(conv("zzza"))
 	
 
+	def test_load_closed(self):
+		D = self.add_test_words()
+		D.close()
+		L = D.words()
+		dump = D.bindump()
+
+		for layout in [pydawg.LAYOUT_NONE, pydawg.LAYOUT_BFS]:
+			N = pydawg.DAWG()
+			N.binload(dump, layout)
+			self.assertEqual(N.words(), L)
+			self.assertEqual(N.get_stats(), D.get_stats())
+
+		N.close()	# closing twice is harmless
+		self.assertEqual(N.words(), L)
+
+
 	def test_load_empty(self):
 		D = self.D
 		L = D.words()
@@ -228,6 +345,380 @@ class TestDumpLoad(TestDAWGBase):
 		D.add_word(conv("zzza"))
 
 
+	def test_layouts(self):
+		# traversals of nodes placed in a block and of separately allocated ones
+		D = self.add_test_words()
+		D.close(pydawg.LAYOUT_NONE)
+		B = pydawg.DAWG()
+		self.add_test_words_to(B)
+		B.close(pydawg.LAYOUT_BFS)
+
+		self.assertEqual(D.get_stats()['nodes_count'], B.get_stats()['nodes_count'])
+		self.assertEqual(D.get_stats()['edges_count'], B.get_stats()['edges_count'])
+		self.assertEqual(pydawg.DAWG(D.bindump()).words(), pydawg.DAWG(B.bindump()).words())
+
+
+	def test_dump_deterministic(self):
+		A = self.add_test_words_to(pydawg.DAWG())
+		B = self.add_test_words_to(pydawg.DAWG())
+		self.assertEqual(A.bindump(), B.bindump())
+		self.assertEqual(pydawg.DAWG(A.bindump()).bindump(), A.bindump())
+
+		# image doesn't depend on placement of nodes
+		A.close(pydawg.LAYOUT_NONE)
+		B.close(pydawg.LAYOUT_BFS)
+		self.assertEqual(A.bindump(), B.bindump())
+		self.assertEqual(pydawg.DAWG(A.bindump()).bindump(), A.bindump())
+
+
+	def test_load_trusted(self):
+		D = self.add_test_words()
+		D.close()
+		dump = D.bindump()
+
+		for layout in [pydawg.LAYOUT_NONE, pydawg.LAYOUT_BFS]:
+			N = pydawg.DAWG()
+			N.binload(dump, layout, trusted=True)
+			self.assertEqual(N.words(), D.words())
+			self.assertEqual(N.bindump(), dump)
+
+
+	def test_dump_varint(self):
+		D = self.add_test_words()
+		for close in [False, True]:
+			if close:
+				D.close()
+
+			dump = D.bindump()
+			compressed = D.bindump("varint")
+			self.assertLess(len(compressed), len(dump))
+			self.assertEqual(D.bindump(compression=None), dump)
+
+			N = pydawg.DAWG(compressed)
+			self.assertEqual(N.words(), D.words())
+			self.assertEqual(N.bindump(), dump)
+			self.assertEqual(N.bindump("varint"), compressed)
+
+			with self.assertRaises(ValueError):
+				pydawg.DAWG(compressed[:-1])
+
+		with self.assertRaises(ValueError):
+			D.bindump("zlib")
+
+
+	def test_load_duplicated_node(self):
+		import struct
+		D = self.add_test_words()
+		D.close()
+		dump = bytearray(D.bindump())
+
+		header_size = 56
+		letter_size, id_size = dump[7], dump[8]
+		code_size = dump[10]
+		number_size = 4 if dump[5] & 0x02 else 0
+		alphabet_size = struct.unpack_from('<I', dump, header_size - 4)[0]
+
+		# the second node gets id of the first one
+		first = header_size + alphabet_size * letter_size
+		n = struct.unpack_from('<I', dump, first + id_size + 1)[0]
+		second = first + id_size + 1 + 4 + number_size + n * (code_size + id_size)
+		dump[second:second + id_size] = dump[first:first + id_size]
+
+		with self.assertRaises(ValueError):
+			pydawg.DAWG(dump)
+
+
+	def test_load_corrupted_graph(self):
+		import struct
+		D = self.add_test_words()
+		D.close()
+		dump = bytes(D.bindump())
+
+		header_size = 56
+		letter_size, id_size = dump[7], dump[8]
+		code_size = dump[10]
+		number_size = 4 if dump[5] & 0x02 else 0
+		alphabet_size = struct.unpack_from('<I', dump, header_size - 4)[0]
+		words_count, longest_word, root_id = struct.unpack_from('<QQQ', dump, 28)
+
+		nodes = {}
+		top = header_size + alphabet_size * letter_size
+		while top < len(dump):
+			nodes[int.from_bytes(dump[top:top + id_size], 'little')] = top
+			n = struct.unpack_from('<I', dump, top + id_size + 1)[0]
+			top += id_size + 1 + 4 + number_size + n * (code_size + id_size)
+
+		root = nodes[root_id]
+		first = root + id_size + 1 + 4 + number_size
+		second = first + code_size + id_size
+		self.assertGreater(struct.unpack_from('<I', dump, root + id_size + 1)[0], 1)
+
+		def corrupted(*changes):
+			image = bytearray(dump)
+			for offset, data in changes:
+				image[offset:offset + len(data)] = data
+
+			return image
+
+		images = [
+			# edge leads back to root
+			corrupted((first + code_size, dump[root:root + id_size])),
+			# eow is neither 0 nor 1
+			corrupted((root + id_size, b'\x23')),
+			# edges not sorted by letters
+			corrupted((first, dump[second:second + code_size]), (second, dump[first:first + code_size])),
+			# header doesn't match graph
+			corrupted((28, struct.pack('<Q', words_count + 1))),
+			corrupted((36, struct.pack('<Q', longest_word - 1))),
+			corrupted((36, struct.pack('<Q', longest_word + 1))),
+		]
+
+		for image in images:
+			with self.assertRaises(ValueError):
+				pydawg.DAWG(image)
+
+		# image itself is valid
+		self.assertEqual(list(pydawg.DAWG(dump).words()), list(D.words()))
+
+
+	def test_load_varint_cycle(self):
+		import struct
+		# image of active DAWG has no numbers, they would catch cycle as well
+		D = self.add_test_words()
+		dump = bytearray(D.bindump('varint'))
+
+		header_size = 56
+		letter_size, code_size = dump[7], dump[10]
+		numbers = dump[5] & 0x02
+		alphabet_size = struct.unpack_from('<I', dump, header_size - 4)[0]
+
+		def varint(top):
+			value = shift = 0
+			while dump[top] & 0x80:
+				value |= (dump[top] & 0x7f) << shift
+				shift += 7
+				top += 1
+
+			return value | (dump[top] << shift), top + 1
+
+		# the first reference to a known node becomes reference
+		# to the node itself (delta 0)
+		top = header_size + alphabet_size * letter_size
+		while True:
+			value, top = varint(top)
+			if numbers:
+				_, top = varint(top)
+
+			edge = None
+			for _ in range(value >> 1):
+				top += code_size
+				value, next_top = varint(top)
+				if value != 0 and next_top == top + 1:
+					edge = top
+					break
+
+				top = next_top
+
+			if edge is not None:
+				break
+
+		dump[edge] = 1
+		with self.assertRaises(ValueError):
+			pydawg.DAWG(dump)
+
+
+	def test_dump_portable(self):
+		import struct
+		D = self.add_test_words()
+		D.close()
+		dump = bytearray(D.bindump())
+
+		# little-endian header, the least sizes of ids and letters
+		magick, version, flags, kind, letter_size, id_size = struct.unpack_from('<4sBBBBB', dump)
+		self.assertEqual(magick, b"DAWG")
+		self.assertEqual((flags & 0x01, letter_size, id_size), (0, 1, 4))
+		nodes_count, edges_count = struct.unpack_from('<QQ', dump, 12)
+		self.assertEqual(nodes_count, D.get_stats()['nodes_count'])
+		self.assertEqual(edges_count, D.get_stats()['edges_count'])
+
+		# ASCII letters mean the same for all kinds of letters
+		for other in range(3):
+			dump[6] = other
+			self.assertEqual(pydawg.DAWG(dump).words(), D.words())
+
+		dump[6] = 3
+		with self.assertRaises(ValueError):
+			pydawg.DAWG(dump)
+
+
+	def test_dump_numbers(self):
+		import struct
+		D = self.add_test_words()
+		D.close()
+
+		for compression in [None, "varint"]:
+			dump = bytearray(D.bindump(compression=compression))
+			# numbers of words are saved only if perfect hashing is enabled
+			self.assertEqual(dump[5] & 0x02 != 0, pydawg.perfect_hasing)
+
+			# loaded graph is ready for perfect hashing
+			N = pydawg.DAWG(dump)
+			self.assertEqual(N.words(), D.words())
+			if pydawg.perfect_hasing:
+				self.assertEqual([N.word2index(conv(w)) for w in self.words], [D.word2index(conv(w)) for w in self.words])
+
+		if not pydawg.perfect_hasing:
+			return
+
+		# number of the root is the count of words
+		dump = bytearray(D.bindump())
+		letter_size, id_size = dump[7], dump[8]
+		alphabet_size = struct.unpack_from('<I', dump, 52)[0]
+		root = 56 + alphabet_size * letter_size
+		self.assertEqual(struct.unpack_from('<I', dump, root + id_size + 1 + 4)[0], len(D))
+
+		struct.pack_into('<I', dump, root + id_size + 1 + 4, len(D) + 1)
+		with self.assertRaises(ValueError):
+			pydawg.DAWG(dump)
+
+
+	def test_load_alphabet(self):
+		D = self.add_test_words()
+		D.close()
+		N = pydawg.DAWG(D.bindump())
+
+		for word in self.words:
+			self.assertTrue(N.exists(conv(word)))
+
+		# letters out of alphabet
+		self.assertFalse(N.exists(conv("catx")))
+		self.assertEqual(N.longest_prefix(conv("catX")), 3)
+		self.assertFalse(N.match(conv("Qcat")))
+
+
+	def test_load_buffers(self):
+		import mmap, os, tempfile
+		D = self.add_test_words()
+		D.close()
+		dump = D.bindump()
+
+		for buf in [bytearray(dump), memoryview(dump)]:
+			N = pydawg.DAWG()
+			N.binload(buf)
+			self.assertEqual(N.words(), D.words())
+			self.assertEqual(pydawg.DAWG(buf).words(), D.words())
+
+		with self.assertRaises(TypeError):
+			pydawg.DAWG().binload("not a buffer")
+
+		fd, path = tempfile.mkstemp()
+		try:
+			os.write(fd, dump)
+			with mmap.mmap(fd, 0, access=mmap.ACCESS_READ) as m:
+				self.assertEqual(pydawg.DAWG(m).words(), D.words())
+
+			N = pydawg.DAWG()
+			N.binload_file(path)
+			self.assertEqual(N.words(), D.words())
+
+			os.lseek(fd, 0, os.SEEK_SET)
+			N = pydawg.DAWG()
+			N.binload_file(fd, pydawg.LAYOUT_NONE)
+			self.assertEqual(N.words(), D.words())
+		finally:
+			os.close(fd)
+			os.remove(path)
+
+		with self.assertRaises(OSError):
+			pydawg.DAWG().binload_file(path)
+
+
+	def test_dump_to(self):
+		import io, os, tempfile
+		D = self.add_test_words()
+		for close in [False, True]:
+			if close:
+				D.close()
+
+			dump = D.bindump()
+
+			f = io.BytesIO()
+			D.bindump_to(f)
+			self.assertEqual(f.getvalue(), dump)
+
+			fd, path = tempfile.mkstemp()
+			try:
+				D.bindump_to(fd)
+				D.bindump_to(path)
+				with open(path, 'rb') as f:
+					self.assertEqual(f.read(), dump)
+
+				os.lseek(fd, 0, os.SEEK_SET)
+				self.assertEqual(os.read(fd, len(dump) + 1), dump)
+			finally:
+				os.close(fd)
+				os.remove(path)
+
+		with self.assertRaises(TypeError):
+			D.bindump_to(1.5)
+
+
+	def test_dump_to_stream_error(self):
+		class Stream:
+			def write(self, data):
+				raise IOError("disk full")
+
+		D = self.add_test_words()
+		with self.assertRaises(IOError):
+			D.bindump_to(Stream())
+
+		class Modifier:
+			def write(this, data):
+				D.add_word(conv("zzzz"))
+
+		with self.assertRaises(RuntimeError):
+			D.bindump_to(Modifier())
+
+
+	@unittest.skipUnless(pydawg.unicode and not pydawg.utf8, "wide letters only")
+	def test_load_large_alphabet(self):
+		words = sorted(chr(0x100 + i) + chr(0x100 + 2*i) for i in range(1000))
+		for word in words:
+			self.D.add_word(word)
+
+		for close in [False, True]:
+			if close:
+				self.D.close()
+
+			N = pydawg.DAWG(self.D.bindump())
+			self.assertEqual(sorted(N.words()), words)
+
+
+	@unittest.skipUnless(pydawg.unicode and not pydawg.utf8, "wide letters only")
+	def test_load_invalid_code_point(self):
+		import struct
+		self.D.add_word("ab")
+		self.D.close()
+		dump = bytearray(self.D.bindump())
+
+		# letters of image are 32-bit, the last one is beyond U+10FFFF
+		header_size = 56
+		alphabet_size = struct.unpack_from('<I', dump, header_size - 4)[0]
+		alphabet = dump[header_size:header_size + alphabet_size]
+		dump[7] = 4
+		dump[header_size:header_size + alphabet_size] = struct.pack('<%dI' % alphabet_size, *alphabet[:-1], 0x200000)
+
+		N = pydawg.DAWG(dump)
+		S = pydawg.SuccinctDAWG(N)
+		functions = [N.words, lambda: list(iter(N)), S.words]
+		if pydawg.perfect_hasing:
+			functions += [lambda: N.index2word(1), lambda: S.index2word(1)]
+
+		for fun in functions:
+			with self.assertRaises(ValueError):
+				fun()
+
+
 class TestPickle(TestDAWGBase):
 	def test_pickle_unpickle(self):
 		import pickle
@@ -239,6 +730,51 @@ class TestPickle(TestDAWGBase):
 		self.assertEqual(len(N), len(D))
 		self.assertEqual(N.words(), D.words())
 
+		for protocol in range(2, pickle.HIGHEST_PROTOCOL + 1):
+			self.assertEqual(pickle.loads(pickle.dumps(D, protocol)).words(), D.words())
+
+
+	def test_buffer(self):
+		D = self.add_test_words()
+		view = memoryview(D)
+		self.assertTrue(view.readonly)
+		self.assertEqual(view.tobytes(), D.bindump())
+		self.assertEqual(pydawg.DAWG(D).words(), D.words())
+
+		# view is a snapshot
+		D.add_word(conv("zzzz"))
+		self.assertNotEqual(memoryview(D).tobytes(), view.tobytes())
+		self.assertEqual(pydawg.DAWG(view).words(), D.words()[:-1])
+
+
+	def test_buffer_image_released(self):
+		D = self.add_test_words()
+		D.close()
+
+		# image is cached only while buffers are exported
+		with memoryview(D) as view:
+			image = D.bindump()
+			self.assertIs(D.bindump(), image)
+			self.assertEqual(view.tobytes(), image)
+
+		self.assertIsNot(D.bindump(), image)
+		self.assertEqual(D.bindump(), image)
+
+
+	@unittest.skipUnless(sys.version_info >= (3, 8), "pickle protocol 5")
+	def test_pickle_out_of_band(self):
+		import pickle
+		D = self.add_test_words()
+		D.close()
+
+		buffers = []
+		dump = pickle.dumps(D, protocol=5, buffer_callback=buffers.append)
+		self.assertEqual(len(buffers), 1)
+		self.assertLess(len(dump), len(D.bindump()))
+
+		N = pickle.loads(dump, buffers=buffers)
+		self.assertEqual(N.words(), D.words())
+
 
 class TestMPH(TestDAWGBase):
 	def test_word2index(self):
@@ -307,5 +843,766 @@ class TestMPH(TestDAWGBase):
 			test([word])
 
 
+	def test_index2word_empty_word(self):
+		if pydawg.perfect_hasing:
+			self.D.add_word(conv(""))
+			D = self.add_test_words()
+			self.assertEqual(len(D), len(self.words) + 1)
+
+			# the empty word has no index
+			D.close()
+			words = [D.index2word(i) for i in range(1, len(D) + 1)]
+			self.assertEqual(sorted(words[:-1]), sorted(map(conv, self.words)))
+			self.assertEqual(words[-1], None)
+
+			D.compile_double_array()
+			self.assertEqual([D.index2word(i) for i in range(1, len(D) + 1)], words)
+
+
+class TestDoubleArray(TestDAWGBase):
+	def test_not_closed(self):
+		D = self.add_test_words()
+		with self.assertRaises(ValueError):
+			D.compile_double_array()
+
+
+	def test_stats(self):
+		D = self.add_test_words()
+		D.close()
+		stats = D.compile_double_array()
+
+		self.assertEqual(stats['states_count'], D.get_stats()['nodes_count'])
+		self.assertEqual(stats['used_slots'], D.get_stats()['edges_count'])
+		self.assertTrue(0.0 < stats['fill_ratio'] <= 1.0)
+
+
+	def test_lookups(self):
+		D = self.add_test_words()
+		D.close()
+
+		words = self.words + "tree horse sky za at attrib warb rating".split()
+		expected = [(D.exists(conv(w)), D.longest_prefix(conv(w)), D.match(conv(w))) for w in words]
+		if pydawg.perfect_hasing:
+			indexes = [D.word2index(conv(w)) for w in words]
+			words_by_index = [D.index2word(i) for i in range(0, len(D) + 2)]
+
+		D.compile_double_array()
+		for word, (exists, prefix, match) in zip(words, expected):
+			self.assertEqual(D.exists(conv(word)), exists)
+			self.assertEqual(conv(word) in D, exists)
+			self.assertEqual(D.longest_prefix(conv(word)), prefix)
+			self.assertEqual(D.match(conv(word)), match)
+
+		if pydawg.perfect_hasing:
+			self.assertEqual([D.word2index(conv(w)) for w in words], indexes)
+			self.assertEqual([D.index2word(i) for i in range(0, len(D) + 2)], words_by_index)
+
+
+	def test_wide_letters(self):
+		if not pydawg.unicode:
+			return
+
+		D = self.D
+		words = sorted(["\u0105b", "\u0105\U0001f600", "x\U0001f600y", "xyz"])
+		for word in words:
+			D.add_word(word)
+
+		D.close()
+		D.compile_double_array()
+		for word in words:
+			self.assertTrue(word in D)
+
+		self.assertFalse("\U0001f601" in D)
+		self.assertEqual(D.longest_prefix("x\U0001f600z"), 2)
+		if pydawg.perfect_hasing:
+			self.assertEqual([D.index2word(D.word2index(w)) for w in words], words)
+
+
+	def test_clear(self):
+		D = self.add_test_words()
+		D.close()
+		D.compile_double_array()
+		D.clear()
+
+		self.assertFalse(conv("cat") in D)
+
+
+class TestJump(TestDAWGBase):
+	def test_lookups(self):
+		D = self.add_test_words()
+		D.close()
+
+		words = self.words + "tree horse sky za at attrib warb rating c r".split()
+		expected = [(D.exists(conv(w)), D.longest_prefix(conv(w)), D.match(conv(w))) for w in words]
+
+		for jump in [1, 2]:
+			E = self.add_test_words_to(pydawg.DAWG())
+			E.close(jump=jump)
+
+			stats = E.get_stats()
+			self.assertEqual(stats['jump_depth'], jump)
+			self.assertTrue(stats['jump_size'] > 0)
+			for word, (exists, prefix, match) in zip(words, expected):
+				self.assertEqual(E.exists(conv(word)), exists)
+				self.assertEqual(conv(word) in E, exists)
+				self.assertEqual(E.longest_prefix(conv(word)), prefix)
+				self.assertEqual(E.match(conv(word)), match)
+
+
+	def test_dump_load(self):
+		D = self.add_test_words()
+		D.close(pydawg.LAYOUT_NONE, jump=2)
+
+		E = pydawg.DAWG()
+		E.binload(D.bindump())
+		self.assertEqual(E.get_stats()['jump_depth'], 2)
+		for word in self.words:
+			self.assertTrue(conv(word) in E)
+
+
+	def test_invalid(self):
+		D = self.add_test_words()
+		with self.assertRaises(ValueError):
+			D.close(jump=3)
+
+
+	def test_clear(self):
+		D = self.add_test_words()
+		D.close(jump=2)
+		D.clear()
+
+		self.assertEqual(D.get_stats()['jump_depth'], 0)
+		self.assertFalse(conv("cat") in D)
+
+
+class TestProfile(TestDAWGBase):
+	def test_not_closed(self):
+		D = self.add_test_words()
+		with self.assertRaises(ValueError):
+			D.start_profile()
+
+		with self.assertRaises(ValueError):
+			D.get_profile()
+
+
+	def test_counts(self):
+		import struct
+
+		D = self.add_test_words()
+		D.close()
+		n = D.get_stats()['nodes_count']
+
+		D.start_profile()
+		for i in range(10):
+			self.assertTrue(D.exists(conv("cat")))
+
+		self.assertFalse(conv("cab") in D)
+		profile = D.stop_profile()
+		self.assertEqual(len(profile), 8*n)
+
+		counts = struct.unpack('<%dQ' % n, profile)
+		self.assertEqual(counts[0], 11)	# root is the first node in BFS order
+		self.assertEqual(sum(counts), 11 + 10*len("cat") + len("ca"))
+
+		with self.assertRaises(ValueError):
+			D.get_profile()
+
+
+	def test_relayout(self):
+		D = self.add_test_words()
+		D.close()
+		D.start_profile()
+		for word in ["rating", "rat", "warbling"]:
+			D.exists(conv(word))
+
+		list(D.find_all(conv("wa")))
+		profile = D.get_profile()
+		D.relayout(profile)
+
+		self.assertEqual(sorted(D.words()), sorted(map(conv, self.words)))
+		for word in self.words:
+			self.assertTrue(conv(word) in D)
+
+		if pydawg.perfect_hasing:
+			self.assertEqual([D.word2index(conv(w)) for w in sorted(self.words)], list(range(1, len(self.words) + 1)))
+
+		# profile refers to BFS order, it's valid for the same set of words
+		E = self.add_test_words_to(pydawg.DAWG())
+		E.close()
+		E.relayout(profile)
+		E.start_profile()
+		self.assertEqual(E.get_profile(), bytes(len(profile)))
+
+
+	def test_mismatch(self):
+		D = self.add_test_words()
+		D.close()
+		with self.assertRaises(ValueError):
+			D.relayout(b"\0" * 8)
+
+
+class TestSuccinct(TestDAWGBase):
+	def test_not_closed(self):
+		D = self.add_test_words()
+		with self.assertRaises(ValueError):
+			pydawg.SuccinctDAWG(D)
+
+		with self.assertRaises(TypeError):
+			pydawg.SuccinctDAWG(None)
+
+
+	def test_lookups(self):
+		D = self.add_test_words()
+		D.close()
+		S = pydawg.SuccinctDAWG(D)
+
+		self.assertEqual(len(S), len(D))
+		self.assertEqual(list(S), sorted(map(conv, self.words)))
+		self.assertEqual(S.words(), list(S))
+
+		words = self.words + "tree horse sky za at attrib warb rating".split()
+		for word in words:
+			self.assertEqual(S.exists(conv(word)), D.exists(conv(word)))
+			self.assertEqual(conv(word) in S, D.exists(conv(word)))
+			self.assertEqual(S.longest_prefix(conv(word)), D.longest_prefix(conv(word)))
+			self.assertEqual(S.match(conv(word)), D.match(conv(word)))
+
+		if pydawg.perfect_hasing:
+			self.assertEqual([S.word2index(conv(w)) for w in words], [D.word2index(conv(w)) for w in words])
+			self.assertEqual([S.index2word(i) for i in range(0, len(D) + 2)], [D.index2word(i) for i in range(0, len(D) + 2)])
+
+
+	def test_size(self):
+		D = self.add_test_words()
+		D.close()
+		S = pydawg.SuccinctDAWG(D)
+
+		stats = S.get_stats()
+		self.assertEqual(stats['nodes_count'], D.get_stats()['nodes_count'])
+		self.assertEqual(stats['edges_count'], D.get_stats()['edges_count'])
+		self.assertTrue(stats['size'] < D.get_stats()['graph_size'])
+
+
+	def test_bindump(self):
+		import pickle
+
+		D = self.add_test_words()
+		D.close()
+		S = pydawg.SuccinctDAWG(D)
+
+		dump = S.bindump()
+		S1 = pydawg.SuccinctDAWG(dump)
+		S2 = pickle.loads(pickle.dumps(S))
+		for X in [S1, S2]:
+			self.assertEqual(list(X), list(S))
+			self.assertEqual(X.get_stats(), S.get_stats())
+
+		with self.assertRaises(ValueError):
+			pydawg.SuccinctDAWG(dump[:-1])
+
+		with self.assertRaises(ValueError):
+			pydawg.SuccinctDAWG(D.bindump())
+
+
+class TestCompact(TestDAWGBase):
+	def test_not_closed(self):
+		D = self.add_test_words()
+		with self.assertRaises(ValueError):
+			pydawg.CompactDAWG(D)
+
+
+	def test_lookups(self):
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		self.assertEqual(len(C), len(D))
+		self.assertEqual(list(C), sorted(map(conv, self.words)))
+		self.assertEqual(C.words(), list(C))
+
+		words = self.words + "tree horse sky za at attrib warb rating tribut".split()
+		for word in words:
+			self.assertEqual(C.exists(conv(word)), D.exists(conv(word)))
+			self.assertEqual(conv(word) in C, D.exists(conv(word)))
+			self.assertEqual(C.longest_prefix(conv(word)), D.longest_prefix(conv(word)))
+			self.assertEqual(C.match(conv(word)), D.match(conv(word)))
+
+		if pydawg.perfect_hasing:
+			self.assertEqual([C.word2index(conv(w)) for w in words], [D.word2index(conv(w)) for w in words])
+			self.assertEqual([C.index2word(i) for i in range(0, len(D) + 2)], [D.index2word(i) for i in range(0, len(D) + 2)])
+
+
+	def test_stats(self):
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		stats = C.get_stats()
+		self.assertTrue(stats['nodes_count'] < D.get_stats()['nodes_count'])
+		self.assertTrue(stats['labels_size'] > 0)
+
+
+	def test_findall(self):
+		D = self.D
+		words = "abcde aXcde aZcdef aYc Xbcdefgh".split()
+		for word in sorted(words):
+			D.add_word(conv(word))
+
+		D.close()
+		C = pydawg.CompactDAWG(D)
+		for pattern in ["a?c??", "?", "a", "aXc", ""]:
+			for how in [pydawg.MATCH_EXACT_LENGTH, pydawg.MATCH_AT_MOST_PREFIX, pydawg.MATCH_AT_LEAST_PREFIX]:
+				L = C.find_all(conv(pattern), conv("?"), how)
+				I = D.find_all(conv(pattern), conv("?"), how)
+				self.assertEqual(set(L), set(I))
+
+			self.assertEqual(set(C.find_all(conv(pattern))), set(D.find_all(conv(pattern))))
+
+
+	def test_save_open(self):
+		import os, tempfile
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		fd, path = tempfile.mkstemp()
+		os.close(fd)
+		try:
+			C.save(path)
+			for M in [pydawg.CompactDAWG.open(path), pydawg.DAWG.open(path)]:
+				self.assertEqual(len(M), len(C))
+				self.assertEqual(M.words(), C.words())
+				self.assertEqual(M.get_stats(), C.get_stats())
+				for word in self.words + "at attrib warb tribut".split():
+					self.assertEqual(M.exists(conv(word)), C.exists(conv(word)))
+					self.assertEqual(M.longest_prefix(conv(word)), C.longest_prefix(conv(word)))
+					if pydawg.perfect_hasing:
+						self.assertEqual(M.word2index(conv(word)), C.word2index(conv(word)))
+
+				self.assertEqual(set(M.find_all(conv("?a?"), conv("?"))), set(C.find_all(conv("?a?"), conv("?"))))
+
+			with open(path, 'r+b') as f:
+				f.write(b'junk')
+
+			with self.assertRaises(ValueError):
+				pydawg.CompactDAWG.open(path)
+
+			with open(path, 'wb') as f:
+				f.write(b'short')
+
+			with self.assertRaises(ValueError):
+				pydawg.CompactDAWG.open(path)
+		finally:
+			os.remove(path)
+
+
+	def test_open_corrupted(self):
+		import os, struct, tempfile
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		fd, path = tempfile.mkstemp()
+		os.close(fd)
+		try:
+			C.save(path)
+			with open(path, 'rb') as f:
+				image = f.read()
+
+			M = pydawg.CompactDAWG.open(path, trusted=True)
+			self.assertEqual(M.words(), C.words())
+			M = pydawg.DAWG.open(path, trusted=False)
+			self.assertEqual(M.words(), C.words())
+
+			# header: 6 x uint32, then counts; edge ends with label, length, child
+			node_size, edge_size = struct.unpack_from('=II', image, 16)
+			nodes_count, edges_count = struct.unpack_from('=QQ', image, 24)
+			edges = (64 + nodes_count * node_size + 7) & ~7
+
+			def corrupt(offset, value):
+				data = bytearray(image)
+				struct.pack_into('=I', data, offset, value)
+				with open(path, 'wb') as f:
+					f.write(data)
+
+			last = edges + (edges_count - 1) * edge_size
+			for offset, value in [
+				(last + edge_size - 4, nodes_count),	# child out of range
+				(last + edge_size - 4, 0),				# cycle through root
+				(last + edge_size - 12, 0xffffffff),	# label past the pool
+			]:
+				corrupt(offset, value)
+				with self.assertRaises(ValueError):
+					pydawg.CompactDAWG.open(path)
+
+				with self.assertRaises(ValueError):
+					pydawg.DAWG.open(path)
+		finally:
+			os.remove(path)
+
+
+	def test_share(self):
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		C.share("test_share")
+		try:
+			with self.assertRaises(ValueError):
+				C.share("test_share")
+
+			S = pydawg.CompactDAWG.attach("test_share")
+			self.assertEqual(S.words(), C.words())
+			self.assertEqual(S.get_stats(), C.get_stats())
+		finally:
+			pydawg.CompactDAWG.unshare("test_share")
+
+		# image is alive until the last user is deleted
+		self.assertEqual(S.words(), C.words())
+		del S
+
+		with self.assertRaises(KeyError):
+			pydawg.CompactDAWG.attach("test_share")
+
+		with self.assertRaises(KeyError):
+			pydawg.CompactDAWG.unshare("test_share")
+
+
+class TestInterpreters(TestDAWGBase):
+	def test_subclass(self):
+		class MyDAWG(pydawg.DAWG):
+			pass
+
+		D = self.add_test_words_to(MyDAWG())
+		D.close()
+		self.assertEqual(sorted(D), sorted(map(conv, self.words)))
+		self.assertEqual(len(pydawg.CompactDAWG(D)), len(D))
+
+
+	def test_iterator_new(self):
+		D = self.add_test_words()
+		with self.assertRaises(TypeError):
+			type(iter(D))()
+
+
+	def test_subinterpreter(self):
+		try:
+			import _interpreters as interpreters
+		except ImportError:
+			try:
+				import _xxsubinterpreters as interpreters
+			except ImportError:
+				self.skipTest("no subinterpreters")
+
+		import os
+		D = self.add_test_words()
+		D.close()
+		pydawg.CompactDAWG(D).share("test_subinterpreter")
+
+		rfd, wfd = os.pipe()
+		code = "\n".join([
+			"import os, sys",
+			"sys.path[:] = %r" % sys.path,
+			"import pydawg",
+			"C = pydawg.CompactDAWG.attach('test_subinterpreter')",
+			"os.write(%d, ' '.join(map(str, C.words())).encode())" % wfd,
+			"os.close(%d)" % wfd,
+		])
+
+		interp = interpreters.create()
+		try:
+			interpreters.run_string(interp, code)
+		finally:
+			interpreters.destroy(interp)
+			pydawg.CompactDAWG.unshare("test_subinterpreter")
+
+		with os.fdopen(rfd, 'rb') as f:
+			words = f.read().decode().split()
+
+		self.assertEqual(words, list(map(str, D.words())))
+
+
+class TestInts(TestDAWGBase):
+	def setUp(self):
+		super().setUp()
+		self.keys = [5, 300, 301, 2**32 + 7, 2**63 + 1, 2**64 - 1]
+
+
+	def test_add_contains(self):
+		import array
+		D = self.D
+		self.assertEqual(D.add_ints(array.array('Q', self.keys)), len(self.keys))
+		self.assertEqual(len(D), len(self.keys))
+
+		query = self.keys + [0, 4, 6, 299, 2**64 - 2]
+		expected = [int(key in self.keys) for key in query]
+		self.assertEqual(list(D.contains_ints(array.array('Q', query))), expected)
+
+		raw = b"".join(key.to_bytes(8, 'big') for key in query)
+		self.assertEqual(list(D.contains_ints(raw)), expected)
+		self.assertTrue(D.exists(conv((300).to_bytes(8, 'big').decode('latin1'))))
+
+		D.close()
+		self.assertEqual(list(D.contains_ints(array.array('Q', query))), expected)
+
+
+	def test_unaligned(self):
+		import array
+		D = self.D
+
+		# views starting at odd byte offset
+		def unaligned(typecode, values):
+			data = bytearray(1) + array.array(typecode, values).tobytes()
+			return memoryview(data)[1:].cast(typecode)
+
+		self.assertEqual(D.add_ints(unaligned('Q', self.keys)), len(self.keys))
+		query = self.keys + [0, 4, 6]
+		expected = [int(key in self.keys) for key in query]
+		self.assertEqual(list(D.contains_ints(unaligned('Q', query))), expected)
+		for typecode in 'HI':
+			self.assertEqual(list(D.contains_ints(unaligned(typecode, [5, 6]), width=8)), [1, 0])
+
+
+	def test_errors(self):
+		import array
+		D = self.D
+		D.add_ints(array.array('H', [1, 2]), width=2)
+
+		with self.assertRaises(ValueError):
+			D.add_ints(array.array('H', [1]), width=2)	# not sorted
+
+		with self.assertRaises(ValueError):
+			D.add_ints(array.array('H', [256]), width=1)
+
+		with self.assertRaises(ValueError):
+			D.add_ints(b"abc", width=2)
+
+		with self.assertRaises(TypeError):
+			D.add_ints(array.array('d', [1.0]))
+
+
+	def test_find_ints(self):
+		import array
+		D = self.D
+		D.add_ints(array.array('Q', self.keys))
+
+		self.assertEqual(D.find_ints(), self.keys)
+		self.assertEqual(D.find_ints(300), self.keys[1:])
+		self.assertEqual(D.find_ints(6, 2**32 + 7), [300, 301])
+		self.assertEqual(D.find_ints(6, 2**32 + 8), [300, 301, 2**32 + 7])
+		self.assertEqual(D.find_ints(-10, 0), [])
+		self.assertEqual(D.find_ints(2**63, 2**100), self.keys[-2:])
+		self.assertEqual(D.find_ints(width=4), [])
+
+
+class TestSequence(unittest.TestCase):
+	def setUp(self):
+		self.D = pydawg.SequenceDAWG()
+		self.seqs = [(1, 2), (1, 2, 3), (1, 70000), (5,), (2**32 - 1, 0)]
+
+
+	def test_lookups(self):
+		import array
+		D = self.D
+		for i, seq in enumerate(self.seqs):
+			self.assertTrue(D.add_word(array.array('I', seq) if i % 2 else seq))
+
+		with self.assertRaises(ValueError):
+			D.add_word([1])
+
+		self.assertEqual(len(D), len(self.seqs))
+		self.assertEqual(D.words(), self.seqs)
+		self.assertEqual(list(D), self.seqs)
+
+		for seq in self.seqs:
+			self.assertTrue(D.exists(seq))
+			self.assertTrue(list(seq) in D)
+
+		self.assertFalse(D.exists((1,)))
+		self.assertFalse((1, 2, 3, 4) in D)
+		self.assertEqual(D.longest_prefix((1, 2, 3, 4)), 3)
+		self.assertEqual(D.longest_prefix((1, 7)), 1)
+		self.assertEqual(D.longest_prefix((7,)), 0)
+
+		query = [(1, 2), (1, 3), (5,), (), (2**32 - 1, 0)]
+		self.assertEqual(list(D.contains_many(query)), [1, 0, 1, 0, 1])
+
+		D.close()
+		rows = memoryview(array.array('I', [1, 2, 1, 3, 1, 70000])).cast('B').cast('I', [3, 2])
+		self.assertEqual(list(D.contains_many(rows)), [1, 0, 1])
+
+
+	def test_mph_pickle(self):
+		import pickle
+		D = self.D
+		for seq in self.seqs:
+			D.add_word(seq)
+
+		D.close()
+		if pydawg.perfect_hasing:
+			indexes = [D.word2index(seq) for seq in self.seqs]
+			self.assertEqual(indexes, list(range(1, len(self.seqs) + 1)))
+			self.assertEqual([D.index2word(i) for i in indexes], self.seqs)
+			self.assertEqual(D.word2index((1,)), None)
+
+		E = pickle.loads(pickle.dumps(D))
+		self.assertTrue(isinstance(E, pydawg.SequenceDAWG))
+		self.assertEqual(E.words(), self.seqs)
+
+
+	def test_invalid_tokens(self):
+		D = self.D
+		with self.assertRaises(OverflowError):
+			D.add_word([2**32])
+
+		with self.assertRaises(OverflowError):
+			D.add_word([-1])
+
+		with self.assertRaises(TypeError):
+			D.add_word(["a"])
+
+
+class TestKmer(unittest.TestCase):
+	def setUp(self):
+		self.words = "ACGTA ACGTT CCGTA GGGGG TTACG acgta".split()
+
+
+	def pack(self, word):
+		value = 0
+		for c in word:
+			value = 4*value + "ACGT".index(c.upper())
+
+		return value
+
+
+	def test_lookups(self):
+		K = pydawg.KmerDAWG(5, self.words)
+
+		self.assertEqual(len(K), 5)
+		self.assertEqual(K.kmers(), sorted(set(map(self.pack, self.words))))
+		for word in self.words + "AAAAA ACGTC CCGT CCGTAA ACGNA".split():
+			expected = word.upper() in self.words
+			self.assertEqual(K.exists(word), expected)
+			self.assertEqual(bytes(word, 'ascii') in K, expected)
+			if len(word) == 5 and 'N' not in word:
+				self.assertEqual(self.pack(word) in K, expected)
+
+		self.assertFalse(-1 in K)
+		self.assertFalse(4**5 in K)
+
+		with self.assertRaises(ValueError):
+			pydawg.KmerDAWG(5, ["ACGT"])
+
+		with self.assertRaises(ValueError):
+			pydawg.KmerDAWG(33, [])
+
+
+	def test_contains_many(self):
+		import array
+		words = array.array('Q', map(self.pack, self.words))
+		K = pydawg.KmerDAWG(5, words)
+		self.assertEqual(K.kmers(), sorted(set(words)))
+
+		query = array.array('Q', range(4**5))
+		result = K.contains_many(query)
+		self.assertEqual([i for i in range(4**5) if result[i]], K.kmers())
+
+		with self.assertRaises(TypeError):
+			K.contains_many(b"12345678")
+
+
+	def test_canonical(self):
+		K = pydawg.KmerDAWG(5, ["ACGTT", "GGGGG"], canonical=True)
+
+		self.assertEqual(len(K), 2)
+		self.assertEqual(K.kmers(), [self.pack("AACGT"), self.pack("CCCCC")])
+		for word in "ACGTT AACGT GGGGG CCCCC".split():
+			self.assertTrue(K.exists(word))
+
+		self.assertFalse(K.exists("ACGTA"))
+		self.assertTrue(K.get_stats()['canonical'])
+
+
+@unittest.skipUnless(pydawg.unicode, "unicode build only")
+class TestUnicode(TestDAWGBase):
+	def setUp(self):
+		self.D = pydawg.DAWG();
+		self.words = ["kot", "kół", "kółko", "żuk", "żółw", "€uro", "\U0001d11e"]
+
+
+	def test_lookups(self):
+		D = self.add_test_words()
+		D.close()
+
+		self.assertEqual(set(D.words()), set(self.words))
+		self.assertEqual(D.longest_prefix("kółek"), 3)
+		self.assertEqual(D.longest_prefix("żó"), 2)
+		self.assertEqual(D.longest_prefix("\U0001d11e\U0001d11e"), 1)
+		self.assertTrue(D.match("żół"))
+		self.assertFalse(D.match("ęź"))
+
+		for cls in [pydawg.SuccinctDAWG, pydawg.CompactDAWG]:
+			X = cls(D)
+			self.assertEqual(list(X), sorted(self.words))
+			self.assertEqual(X.longest_prefix("kółek"), 3)
+			self.assertTrue(X.exists("żółw"))
+
+
+	def test_findall(self):
+		D = self.add_test_words()
+		D.close()
+		C = pydawg.CompactDAWG(D)
+
+		for X in [D, C]:
+			self.assertEqual(set(X.find_all("k??", "?")), {"kot", "kół"})
+			self.assertEqual(set(X.find_all("?uk", "?")), {"żuk"})
+			self.assertEqual(set(X.find_all("ż€€", "€", pydawg.MATCH_AT_LEAST_PREFIX)), {"żuk", "żółw"})
+			self.assertEqual(set(X.find_all("?", "?", pydawg.MATCH_AT_MOST_PREFIX)), {"\U0001d11e"})
+
+
+	def test_string_kinds(self):
+		# the same letters stored in strings of 1, 2 and 4 bytes kind
+		D = self.D
+		for word in sorted(["abc", "ab\xe9", "ab\u0119", "ab\U0001d11e"]):
+			D.add_word(word)
+		D.close()
+
+		for compiled in [False, True]:
+			if compiled:
+				D.compile_double_array()
+
+			for suffix in ["\xe9", "\u0119", "\U0001d11e"]:
+				self.assertTrue(D.exists("ab" + suffix))
+				self.assertFalse(D.exists("abc" + suffix))
+				self.assertEqual(D.longest_prefix("abc" + suffix), 3)
+				if pydawg.perfect_hasing:
+					self.assertEqual(D.index2word(D.word2index("ab" + suffix)), "ab" + suffix)
+
+
+	@unittest.skipUnless(pydawg.utf8, "UTF-8 build only")
+	def test_utf8_dump(self):
+		D = self.add_test_words()
+		D.close()
+
+		self.assertEqual(D.get_stats()['longest_word'], len("żółw".encode('utf-8')))
+		L = pydawg.DAWG(D.bindump())
+		self.assertEqual(list(L.words()), list(D.words()))
+		if pydawg.perfect_hasing:
+			self.assertEqual([D.index2word(D.word2index(w)) for w in self.words], self.words)
+
+
+	@unittest.skipUnless(pydawg.utf8, "UTF-8 build only")
+	def test_utf8_no_cache(self):
+		D = self.add_test_words()
+		word = "zażółć"
+		size = sys.getsizeof(word)
+
+		# queries don't attach UTF-8 copies to strings
+		self.assertFalse(word in D)
+		D.longest_prefix(word)
+		list(D.find_all(word, "ż"))
+		self.assertEqual(sys.getsizeof(word), size)
+
+
 if __name__ == '__main__':
 	unittest.main()
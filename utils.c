@@ -16,12 +16,58 @@
 /* returns bytes or unicode internal buffer */
 static PyObject*
 pymod_get_string(PyObject* obj, DAWG_LETTER_TYPE** word, size_t* wordlen) {
-#ifdef DAWG_UNICODE
+#if defined(DAWG_UTF8)
 	if (PyUnicode_Check(obj)) {
-		*word = (DAWG_LETTER_TYPE*)PyUnicode_AS_UNICODE(obj);
-		*wordlen = (size_t)PyUnicode_GET_SIZE(obj);
-		Py_INCREF(obj);
-		return obj;
+		if (PyUnicode_READY(obj) < 0)
+			return NULL;
+
+		// ASCII strings are used in place, others are encoded to
+		// a temporary buffer (PyUnicode_AsUTF8 would keep a copy
+		// in every queried string)
+		if (PyUnicode_IS_ASCII(obj)) {
+			*word = (DAWG_LETTER_TYPE*)PyUnicode_DATA(obj);
+			*wordlen = (size_t)PyUnicode_GET_LENGTH(obj);
+			Py_INCREF(obj);
+			return obj;
+		}
+
+		PyObject* buffer = PyUnicode_AsUTF8String(obj);
+		if (buffer == NULL)
+			return NULL;
+
+		*word = (DAWG_LETTER_TYPE*)PyBytes_AS_STRING(buffer);
+		*wordlen = (size_t)PyBytes_GET_SIZE(buffer);
+		return buffer;
+	}
+	else {
+		PyErr_SetString(PyExc_TypeError, "string expected");
+		return NULL;
+	}
+#elif defined(DAWG_UNICODE)
+	if (PyUnicode_Check(obj)) {
+		if (PyUnicode_READY(obj) < 0)
+			return NULL;
+
+		const Py_ssize_t length = PyUnicode_GET_LENGTH(obj);
+		*wordlen = (size_t)length;
+		if (PyUnicode_KIND(obj) == PyUnicode_4BYTE_KIND) {
+			*word = (DAWG_LETTER_TYPE*)PyUnicode_DATA(obj);
+			Py_INCREF(obj);
+			return obj;
+		}
+
+		// narrow kinds are widened to a temporary buffer
+		PyObject* buffer = PyBytes_FromStringAndSize(NULL, (length + 1) * DAWG_LETTER_SIZE);
+		if (buffer == NULL)
+			return NULL;
+
+		*word = (DAWG_LETTER_TYPE*)PyBytes_AS_STRING(buffer);
+		if (PyUnicode_AsUCS4(obj, *word, length + 1, 1) == NULL) {
+			Py_DECREF(buffer);
+			return NULL;
+		}
+
+		return buffer;
 	}
 	else {
 		PyErr_SetString(PyExc_TypeError, "string expected");
@@ -41,3 +87,592 @@ pymod_get_string(PyObject* obj, DAWG_LETTER_TYPE** word, size_t* wordlen) {
 #endif
 }
 
+
+/* word passed to lookup functions (see dawg_lookup.c) */
+typedef struct LookupString {
+	int		kind;		///< PEP 393 kind, used if DAWG_LOOKUP_KINDS is defined
+	const void* chars;
+	size_t	length;
+} LookupString;
+
+
+/* like pymod_get_string, but str objects are not converted */
+static PyObject*
+pymod_get_lookup_string(PyObject* obj, LookupString* word) {
+#ifdef DAWG_LOOKUP_KINDS
+	if (PyUnicode_Check(obj)) {
+		if (PyUnicode_READY(obj) < 0)
+			return NULL;
+
+		word->kind		= PyUnicode_KIND(obj);
+		word->chars		= PyUnicode_DATA(obj);
+		word->length	= (size_t)PyUnicode_GET_LENGTH(obj);
+		Py_INCREF(obj);
+		return obj;
+	}
+	else {
+		PyErr_SetString(PyExc_TypeError, "string expected");
+		return NULL;
+	}
+#else
+	DAWG_LETTER_TYPE* chars = NULL;
+	PyObject* result = pymod_get_string(obj, &chars, &word->length);
+
+	word->kind	= DAWG_LETTER_SIZE;
+	word->chars	= chars;
+	return result;
+#endif
+}
+
+
+/* calls instance of lookup function matching kind of word */
+#ifdef DAWG_LOOKUP_KINDS
+#	define DAWG_LOOKUP(fun, object, word) \
+		(((word).kind == PyUnicode_1BYTE_KIND) ? \
+			fun##_ucs1((object), (const Py_UCS1*)(word).chars, (word).length) : \
+		((word).kind == PyUnicode_2BYTE_KIND) ? \
+			fun##_ucs2((object), (const Py_UCS2*)(word).chars, (word).length) : \
+			fun((object), (const DAWG_LETTER_TYPE*)(word).chars, (word).length))
+#else
+#	define DAWG_LOOKUP(fun, object, word) \
+		fun((object), (const DAWG_LETTER_TYPE*)(word).chars, (word).length)
+#endif
+
+
+/* returns bytes or unicode object made of letters; letters of images
+   are any 32-bit values (see DUMP_LETTER_MAX), not always code points */
+static PyObject*
+pymod_make_string(const DAWG_LETTER_TYPE* word, const size_t wordlen) {
+#if defined(DAWG_UTF8)
+	return PyUnicode_DecodeUTF8((const char*)word, (Py_ssize_t)wordlen, NULL);
+#elif defined(DAWG_UNICODE)
+	size_t i;
+	for (i=0; i < wordlen; i++)
+		if (UNLIKELY(word[i] > 0x10ffff)) {
+			PyErr_Format(PyExc_ValueError, "letter 0x%x is not a valid code point", (unsigned)word[i]);
+			return NULL;
+		}
+
+	return PyUnicode_FromKindAndData(PyUnicode_4BYTE_KIND, word, (Py_ssize_t)wordlen);
+#else
+	return PyBytes_FromStringAndSize((const char*)word, (Py_ssize_t)wordlen);
+#endif
+}
+
+
+#ifdef DAWG_UTF8
+/* number of continuation bytes following the lead byte */
+#	define DAWG_LETTER_CONTINUATION(letter) \
+		(((letter) < 0xc0) ? 0 : ((letter) < 0xe0) ? 1 : ((letter) < 0xf0) ? 2 : 3)
+
+/* marks wildcard in UTF-8 pattern, the byte never appears in UTF-8 */
+#	define DAWG_UTF8_WILDCARD 0xff
+
+/* number of characters of str object passed to pymod_get_string */
+#	define pymod_string_length(obj, wordlen) ((size_t)PyUnicode_GET_LENGTH(obj))
+
+/* number of whole characters in prefix of word, prefix length is given in bytes */
+static size_t
+pymod_prefix_length(const DAWG_LETTER_TYPE* word, const size_t wordlen, const size_t prefixlen) {
+	size_t count = 0;
+	size_t i;
+
+	for (i=0; i < prefixlen; i++)
+		if ((word[i] & 0xc0) != 0x80)
+			count += 1;
+
+	// the last character is incomplete
+	if (prefixlen < wordlen and (word[prefixlen] & 0xc0) == 0x80)
+		count -= 1;
+
+	return count;
+}
+#else
+#	define DAWG_LETTER_CONTINUATION(letter) 0
+#	define pymod_string_length(obj, wordlen) (wordlen)
+#	define pymod_prefix_length(word, wordlen, prefixlen) (prefixlen)
+#endif
+
+
+/*	Get keys for DAWG_*_ints functions: buffer of unsigned integers
+	(native byte order) or bytes, where consecutive width bytes
+	make a big-endian key. Returns -1 and sets exception on error,
+	the view has to be released otherwise.
+*/
+static int
+pymod_get_int_array(PyObject* obj, const Py_ssize_t width, Py_buffer* view, DAWGIntArray* keys) {
+	if (width < 1 or width > DAWG_INT_MAX_WIDTH) {
+		PyErr_Format(PyExc_ValueError, "width must be in range 1..%d", DAWG_INT_MAX_WIDTH);
+		return -1;
+	}
+
+	if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0)
+		return -1;
+
+	const char* format = view->format ? view->format : "B";
+	if (*format == '@' or *format == '=')
+		format += 1;
+
+	keys->data	= view->buf;
+	keys->width	= width;
+	if (view->itemsize == 1 and (strcmp(format, "B") == 0 or strcmp(format, "b") == 0 or strcmp(format, "c") == 0)) {
+		if (view->len % width != 0) {
+			PyErr_SetString(PyExc_ValueError, "buffer size is not multiple of width");
+			goto error;
+		}
+
+		keys->itemsize	= 1;
+		keys->count		= view->len / width;
+		return 0;
+	}
+
+	switch (view->itemsize) {
+		case 2:
+		case 4:
+		case 8:
+			if (format[0] != 0 and format[1] == 0 and strchr("HILQN", format[0]) != NULL) {
+				keys->itemsize	= view->itemsize;
+				keys->count		= view->len / view->itemsize;
+				return 0;
+			}
+	}
+
+	PyErr_SetString(PyExc_TypeError, "bytes or buffer of unsigned integers expected");
+
+error:
+	PyBuffer_Release(view);
+	return -1;
+}
+
+
+/*	Words of batch lookup (see DAWG.exists_many): either list of
+	objects or Arrow-style pair of buffers, where i-th word is
+	data[offsets[i] .. offsets[i + 1]); offsets are unsigned 32- or
+	64-bit integers. Words are read without GIL.
+
+	Words of list are prepared in chunks, which are small enough to
+	stay in cache while they are looked up.
+*/
+#define DAWG_BATCH_CHUNK 1024
+
+typedef struct LookupBatch {
+	size_t		count;
+	PyObject*	seq;		///< list of words, NULL for buffers
+	size_t		first;		///< index of the first word of chunk
+	size_t		filled;		///< number of words in chunk
+	LookupString*	words;
+	PyObject**	objects;	///< references keeping words of chunk alive
+	Py_buffer	data;
+	Py_buffer	offsets;
+	size_t		offset_size;
+	size_t		longest;	///< length of the longest word (bytes)
+#ifdef DAWG_LOOKUP_KINDS
+	Py_UCS4*	chars;		///< the longest word decoded from UTF-8
+#endif
+} LookupBatch;
+
+
+static void
+pymod_empty_lookup_batch(LookupBatch* batch) {
+	size_t i;
+
+	for (i=0; i < batch->filled; i++)
+		Py_DECREF(batch->objects[i]);
+
+	batch->filled = 0;
+}
+
+
+static void
+pymod_release_lookup_batch(LookupBatch* batch) {
+	if (batch->seq) {
+		pymod_empty_lookup_batch(batch);
+		memfree(batch->words);
+		memfree(batch->objects);
+		Py_DECREF(batch->seq);
+		return;
+	}
+
+#ifdef DAWG_LOOKUP_KINDS
+	if (batch->chars)
+		memfree(batch->chars);
+#endif
+
+	PyBuffer_Release(&batch->offsets);
+	PyBuffer_Release(&batch->data);
+}
+
+
+static size_t
+pymod_batch_offset(const LookupBatch* batch, const size_t i) {
+	const uint8_t* ptr = (const uint8_t*)batch->offsets.buf + i * batch->offset_size;
+	if (batch->offset_size == 4) {
+		uint32_t offset;
+		memcpy(&offset, ptr, 4);
+		return offset;
+	}
+	else {
+		uint64_t offset;
+		memcpy(&offset, ptr, 8);
+		return (size_t)offset;
+	}
+}
+
+
+static int
+pymod_get_lookup_batch_buffers(PyObject* data, PyObject* offsets, LookupBatch* batch) {
+	size_t i;
+
+	if (PyObject_GetBuffer(data, &batch->data, PyBUF_SIMPLE) < 0)
+		return -1;
+
+	if (PyObject_GetBuffer(offsets, &batch->offsets, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+		PyBuffer_Release(&batch->data);
+		return -1;
+	}
+
+	const char* format = batch->offsets.format ? batch->offsets.format : "B";
+	if (*format == '@' or *format == '=')
+		format += 1;
+
+	// raw bytes are 32-bit offsets of Arrow string array
+	batch->offset_size = 0;
+	if (batch->offsets.itemsize == 1 and strchr("Bbc", format[0]) != NULL and batch->offsets.len % 4 == 0)
+		batch->offset_size = 4;
+	else if ((batch->offsets.itemsize == 4 or batch->offsets.itemsize == 8) and strchr("iIlLqQnN", format[0]) != NULL)
+		batch->offset_size = batch->offsets.itemsize;
+
+	if (batch->offset_size == 0 or format[0] == 0 or format[1] != 0) {
+		PyErr_SetString(PyExc_TypeError, "offsets must be a buffer of 32-bit or 64-bit integers");
+		goto error;
+	}
+
+	const size_t n = batch->offsets.len / batch->offset_size;
+	size_t longest = 0;
+	batch->count = (n > 0) ? n - 1 : 0;
+	for (i=0; i < batch->count; i++) {
+		const size_t start	= pymod_batch_offset(batch, i);
+		const size_t end	= pymod_batch_offset(batch, i + 1);
+		if (end < start or end > (size_t)batch->data.len) {
+			PyErr_Format(PyExc_ValueError, "offsets of word %zu are out of data", i);
+			goto error;
+		}
+
+		if (end - start > longest)
+			longest = end - start;
+	}
+
+	batch->longest = longest;
+#ifdef DAWG_LOOKUP_KINDS
+	// UTF-8 word has at most as many characters as bytes
+	batch->chars = (Py_UCS4*)memalloc((longest + 1) * sizeof(Py_UCS4));
+	if (batch->chars == NULL) {
+		PyErr_NoMemory();
+		goto error;
+	}
+#endif
+
+	return 0;
+
+error:
+	PyBuffer_Release(&batch->offsets);
+	PyBuffer_Release(&batch->data);
+	return -1;
+}
+
+
+/*	Get words for batch lookup: list (or any sequence) of words if offsets
+	is NULL or None, buffers otherwise. Returns -1 and sets exception on error,
+	batch has to be released with pymod_release_lookup_batch otherwise.
+*/
+static int
+pymod_get_lookup_batch(PyObject* words, PyObject* offsets, LookupBatch* batch) {
+	batch->count	= 0;
+	batch->seq		= NULL;
+	batch->first	= 0;
+	batch->filled	= 0;
+#ifdef DAWG_LOOKUP_KINDS
+	batch->chars	= NULL;
+#endif
+
+	if (offsets != NULL and offsets != Py_None)
+		return pymod_get_lookup_batch_buffers(words, offsets, batch);
+
+	PyObject* seq = PySequence_Fast(words, "list of words expected");
+	if (seq == NULL)
+		return -1;
+
+	batch->words	= (LookupString*)memalloc(DAWG_BATCH_CHUNK * sizeof(LookupString));
+	batch->objects	= (PyObject**)memalloc(DAWG_BATCH_CHUNK * sizeof(PyObject*));
+	if (batch->words == NULL or batch->objects == NULL) {
+		memfree(batch->words);
+		memfree(batch->objects);
+		Py_DECREF(seq);
+		PyErr_NoMemory();
+		return -1;
+	}
+
+	batch->seq		= seq;
+	batch->count	= PySequence_Fast_GET_SIZE(seq);
+	return 0;
+}
+
+
+/*	Prepare words from start, sets end of range that can be looked up
+	without GIL. Returns -1 and sets exception on error.
+*/
+static int
+pymod_fill_lookup_batch(LookupBatch* batch, const size_t start, size_t* end) {
+	if (batch->seq == NULL) {
+		*end = batch->count;
+		return 0;
+	}
+
+	pymod_empty_lookup_batch(batch);
+
+	// list might have been changed by other thread, while GIL was released
+	const size_t count = PySequence_Fast_GET_SIZE(batch->seq);
+	if (count != batch->count) {
+		PyErr_SetString(PyExc_RuntimeError, "list of words changed size during lookup");
+		return -1;
+	}
+
+	batch->first = start;
+	while (batch->filled < DAWG_BATCH_CHUNK and start + batch->filled < count) {
+		PyObject* item = PySequence_Fast_GET_ITEM(batch->seq, start + batch->filled);
+		PyObject* tmp = pymod_get_lookup_string(item, &batch->words[batch->filled]);
+		if (tmp == NULL)
+			return -1;
+
+		batch->objects[batch->filled++] = tmp;
+	}
+
+	*end = start + batch->filled;
+	return 0;
+}
+
+
+#ifdef DAWG_LOOKUP_KINDS
+/* decode UTF-8 word, returns number of characters or -1 if word is invalid */
+static Py_ssize_t
+pymod_decode_utf8(const uint8_t* data, const size_t size, Py_UCS4* chars) {
+	size_t i = 0;
+	size_t n = 0;
+
+	while (i < size) {
+		Py_UCS4 c = data[i++];
+		Py_UCS4 min;
+		size_t k;
+
+		if (c < 0x80) {
+			chars[n++] = c;
+			continue;
+		}
+		else if ((c & 0xe0) == 0xc0) {
+			c &= 0x1f; k = 1; min = 0x80;
+		}
+		else if ((c & 0xf0) == 0xe0) {
+			c &= 0x0f; k = 2; min = 0x800;
+		}
+		else if ((c & 0xf8) == 0xf0) {
+			c &= 0x07; k = 3; min = 0x10000;
+		}
+		else
+			return -1;
+
+		if (size - i < k)
+			return -1;
+
+		for (/**/; k > 0; k--, i++) {
+			if ((data[i] & 0xc0) != 0x80)
+				return -1;
+
+			c = (c << 6) | (data[i] & 0x3f);
+		}
+
+		// overlong sequences, surrogates and too big values
+		if (c < min or c > 0x10ffff or (c >= 0xd800 and c <= 0xdfff))
+			return -1;
+
+		chars[n++] = c;
+	}
+
+	return (Py_ssize_t)n;
+}
+#endif
+
+
+/* offsets of i-th word are still within data and the longest word */
+static bool
+pymod_batch_offsets_valid(const LookupBatch* batch, const size_t start, const size_t end) {
+	return start <= end and end <= (size_t)batch->data.len and end - start <= batch->longest;
+}
+
+
+/*	i-th word of batch (it has to be within the filled range), returns
+	false if it's not valid UTF-8 or its offsets aren't valid anymore
+	(buffer is writable by other threads). Doesn't need GIL; decoded
+	word is overwritten by the next call.
+*/
+static bool
+pymod_batch_word(const LookupBatch* batch, const size_t i, LookupString* word) {
+	if (batch->seq) {
+		ASSERT(i >= batch->first and i < batch->first + batch->filled);
+		*word = batch->words[i - batch->first];
+		return true;
+	}
+
+	const size_t start	= pymod_batch_offset(batch, i);
+	const size_t end	= pymod_batch_offset(batch, i + 1);
+	if (UNLIKELY(not pymod_batch_offsets_valid(batch, start, end)))
+		return false;
+
+	const uint8_t* data	= (const uint8_t*)batch->data.buf + start;
+
+#ifdef DAWG_LOOKUP_KINDS
+	const Py_ssize_t length = pymod_decode_utf8(data, end - start, batch->chars);
+	if (length < 0)
+		return false;
+
+	word->kind		= PyUnicode_4BYTE_KIND;
+	word->chars		= batch->chars;
+	word->length	= (size_t)length;
+#else
+	word->kind		= DAWG_LETTER_SIZE;
+	word->chars		= data;
+	word->length	= end - start;
+#endif
+	return true;
+}
+
+
+/*	sets exception for i-th word rejected by pymod_batch_word; the word
+	is checked again, buffers might have been changed during lookup */
+static void
+pymod_batch_word_error(const LookupBatch* batch, const size_t i) {
+	ASSERT(batch->seq == NULL);	// words of list are always valid
+	LookupString word;
+	const size_t start	= pymod_batch_offset(batch, i);
+	const size_t end	= pymod_batch_offset(batch, i + 1);
+
+	if (pymod_batch_offsets_valid(batch, start, end) and not pymod_batch_word(batch, i, &word))
+		PyErr_Format(PyExc_ValueError, "word %zu is not valid UTF-8", i);
+	else
+		PyErr_Format(PyExc_RuntimeError, "offsets of word %zu changed during lookup", i);
+}
+
+
+/* returns array('I') of count zeros */
+static PyObject*
+pymod_new_uint32_array(const size_t count) {
+	PyObject* module = PyImport_ImportModule("array");
+	if (module == NULL)
+		return NULL;
+
+	PyObject* item = PyObject_CallMethod(module, "array", "s(i)", "I", 0);
+	Py_DECREF(module);
+	if (item == NULL)
+		return NULL;
+
+	PyObject* result = PySequence_Repeat(item, (Py_ssize_t)count);
+	Py_DECREF(item);
+	return result;
+}
+
+
+/*	read whole file (from current position) given by path or file descriptor;
+	returns -1 and sets exception on error. File is read without GIL, thus
+	array is allocated by raw allocator and has to be freed with PyMem_RawFree */
+static int
+pymod_read_file(PyObject* path_or_fd, uint8_t** array, size_t* size) {
+#ifdef DAWG_POSIX
+	const size_t chunk = 16*1024*1024;	// max size of a single read
+	PyObject* name = NULL;
+	struct stat st;
+	uint8_t* data = NULL;
+	size_t capacity;
+	size_t n = 0;
+	int fd;
+	int err = 0;
+
+	if (PyLong_Check(path_or_fd)) {
+		fd = PyObject_AsFileDescriptor(path_or_fd);
+		if (fd < 0)
+			return -1;
+	}
+	else {
+		if (not PyUnicode_FSConverter(path_or_fd, &name))
+			return -1;
+
+		Py_BEGIN_ALLOW_THREADS
+		fd = open(PyBytes_AS_STRING(name), O_RDONLY);
+		Py_END_ALLOW_THREADS
+		Py_DECREF(name);
+		if (fd < 0)
+			return PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_or_fd), -1;
+	}
+
+	Py_BEGIN_ALLOW_THREADS
+	// size of regular file is known, one spare byte is needed to hit EOF
+	if (fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0)
+		capacity = (size_t)st.st_size + 1;
+	else
+		capacity = chunk;
+
+#ifdef POSIX_FADV_SEQUENTIAL
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+	data = (uint8_t*)PyMem_RawMalloc(capacity);
+	while (data != NULL) {
+		if (n == capacity) {
+			uint8_t* tmp = (uint8_t*)PyMem_RawRealloc(data, 2 * capacity);
+			if (tmp == NULL) {
+				PyMem_RawFree(data);
+				data = NULL;
+				break;
+			}
+
+			data = tmp;
+			capacity *= 2;
+		}
+
+		const size_t k = (capacity - n < chunk) ? capacity - n : chunk;
+		const ssize_t ret = read(fd, data + n, k);
+		if (ret > 0)
+			n += ret;
+		else if (ret == 0)
+			break;
+		else if (errno != EINTR) {
+			err = errno;
+			break;
+		}
+	}
+
+	if (name)
+		close(fd);
+	Py_END_ALLOW_THREADS
+
+	if (data == NULL) {
+		PyErr_NoMemory();
+		return -1;
+	}
+
+	if (err) {
+		PyMem_RawFree(data);
+		errno = err;
+		PyErr_SetFromErrnoWithFilenameObject(PyExc_OSError, path_or_fd);
+		return -1;
+	}
+
+	*array	= data;
+	*size	= n;
+	return 0;
+#else
+	(void)path_or_fd;
+	(void)array;
+	(void)size;
+	PyErr_SetString(PyExc_NotImplementedError, "reading files is not supported on this platform");
+	return -1;
+#endif
+}